@@ -855,7 +855,23 @@ LUA_API int lua_load (lua_State *L, lua_Reader reader, void *data,
   lua_lock(L);
   if (!chunkname) chunkname = "?";
   luaZ_init(L, &z, reader, data);
-  status = luaD_protectedparser(L, &z, chunkname);
+  status = luaD_protectedparser(L, &z, chunkname, 0);
+  lua_unlock(L);
+  return status;
+}
+
+
+/* SRB2: lua_load for precompiled chunks only, whether or not
+   LUA_ALLOW_BYTECODE lets scripts load them. For the engine's
+   bytecode cache; never hand this anything a script could supply. */
+LUA_API int lua_loadbytecode (lua_State *L, lua_Reader reader, void *data,
+                              const char *chunkname) {
+  ZIO z;
+  int status;
+  lua_lock(L);
+  if (!chunkname) chunkname = "?";
+  luaZ_init(L, &z, reader, data);
+  status = luaD_protectedparser(L, &z, chunkname, 1);
   lua_unlock(L);
   return status;
 }
@@ -941,6 +957,11 @@ LUA_API int lua_gc (lua_State *L, int what, int data) {
       g->gcstepmul = data;
       break;
     }
+    case LUA_GCDEFER: {  /* SRB2: the engine steps the collector itself */
+      g->GCthreshold = g->totalbytes + (cast(lu_mem, data) << 10);
+      res = (g->gcstate != GCSpause);  /* still in a cycle? */
+      break;
+    }
     default: res = -1;  /* invalid option */
   }
   lua_unlock(L);
@@ -204,6 +204,8 @@ LUA_API int   (lua_pcall) (lua_State *L, int nargs, int nresults, int errfunc);
 LUA_API int   (lua_cpcall) (lua_State *L, lua_CFunction func, void *ud);
 LUA_API int   (lua_load) (lua_State *L, lua_Reader reader, void *dt,
                                         const char *chunkname);
+LUA_API int   (lua_loadbytecode) (lua_State *L, lua_Reader reader, void *dt,
+                                        const char *chunkname); /* SRB2 */
 
 LUA_API int (lua_dump) (lua_State *L, lua_Writer writer, void *data);
 
@@ -227,6 +229,7 @@ LUA_API int  (lua_status) (lua_State *L);
 #define LUA_GCSTEP		5
 #define LUA_GCSETPAUSE		6
 #define LUA_GCSETSTEPMUL	7
+#define LUA_GCDEFER		8 /* SRB2: hold off automatic steps for data more Kbytes */
 
 LUA_API int (lua_gc) (lua_State *L, int what, int data);
 
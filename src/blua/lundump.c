@@ -180,7 +180,7 @@ static Proto* LoadFunction(LoadState* S, TString* p)
  return f;
 }
 
-#ifdef LUA_ALLOW_BYTECODE
+/* SRB2: always built, for the engine's own bytecode cache */
 static void LoadHeader(LoadState* S)
 {
  char h[LUAC_HEADERSIZE];
@@ -208,7 +208,6 @@ Proto* luaU_undump (lua_State* L, ZIO* Z, Mbuffer* buff, const char* name)
  LoadHeader(&S);
  return LoadFunction(&S,luaS_newliteral(L,"=?"));
 }
-#endif
 
 /*
 * make header
@@ -1224,6 +1224,7 @@ static boolean CL_SendJoin(void)
 	netbuffer->u.clientcfg.localplayers = localplayers;
 	netbuffer->u.clientcfg.version = VERSION;
 	netbuffer->u.clientcfg.subversion = SUBVERSION;
+	netbuffer->u.clientcfg.modversion = MODVERSION;
 
 	return HSendPacket(servernode, true, 0, sizeof (clientconfig_pak));
 }
@@ -1425,8 +1426,6 @@ static boolean SV_SendServerConfig(INT32 node)
 }
 
 #ifdef JOININGAME
-#define SAVEGAMESIZE (768*1024)
-
 static void SV_SendSaveGame(INT32 node)
 {
 	size_t length, compressedlen;
@@ -1435,7 +1434,7 @@ static void SV_SendSaveGame(INT32 node)
 	UINT8 *buffertosend;
 
 	// first save it in a malloced buffer
-	savebuffer = (UINT8 *)malloc(SAVEGAMESIZE);
+	savebuffer = (UINT8 *)malloc(NETSAVEGAMESIZE);
 	if (!savebuffer)
 	{
 		CONS_Alert(CONS_ERROR, M_GetText("No more free memory for savegame\n"));
@@ -1444,17 +1443,17 @@ static void SV_SendSaveGame(INT32 node)
 
 	// Leave room for the uncompressed length.
 	save_p = savebuffer + sizeof(UINT32);
+	save_end = savebuffer + NETSAVEGAMESIZE;
 
-	P_SaveNetGame();
-
-	length = save_p - savebuffer;
-	if (length > SAVEGAMESIZE)
+	if (!P_SaveNetGame())
 	{
 		free(savebuffer);
 		save_p = NULL;
 		I_Error("Savegame buffer overrun");
 	}
 
+	length = save_p - savebuffer;
+
 	// Allocate space for compressed save: one byte fewer than for the
 	// uncompressed data to ensure that the compression is worthwhile.
 	compressedsave = malloc(length - 1);
@@ -1511,23 +1510,23 @@ static void SV_SavedGame(void)
 	sprintf(tmpsave, "%s" PATHSEP TMPSAVENAME, srb2home);
 
 	// first save it in a malloced buffer
-	save_p = savebuffer = (UINT8 *)malloc(SAVEGAMESIZE);
+	save_p = savebuffer = (UINT8 *)malloc(NETSAVEGAMESIZE);
 	if (!save_p)
 	{
 		CONS_Alert(CONS_ERROR, M_GetText("No more free memory for savegame\n"));
 		return;
 	}
+	save_end = savebuffer + NETSAVEGAMESIZE;
 
-	P_SaveNetGame();
-
-	length = save_p - savebuffer;
-	if (length > SAVEGAMESIZE)
+	if (!P_SaveNetGame())
 	{
 		free(savebuffer);
 		save_p = NULL;
 		I_Error("Savegame buffer overrun");
 	}
 
+	length = save_p - savebuffer;
+
 	// then save it!
 	if (!FIL_WriteFile(tmpsave, savebuffer, length))
 		CONS_Printf(M_GetText("Didn't save %s for netgame"), tmpsave);
@@ -3436,7 +3435,9 @@ static void HandleConnect(SINT8 node)
 	if (bannednode && bannednode[node])
 		SV_SendRefuse(node, M_GetText("You have been banned\nfrom the server"));
 	else if (netbuffer->u.clientcfg.version != VERSION
-		|| netbuffer->u.clientcfg.subversion != SUBVERSION)
+		|| netbuffer->u.clientcfg.subversion != SUBVERSION
+		|| doomcom->datalength < (INT16)(BASEPACKETSIZE + sizeof (clientconfig_pak)) // older builds don't send modversion
+		|| netbuffer->u.clientcfg.modversion != MODVERSION)
 		SV_SendRefuse(node, va(M_GetText("Different SRB2 versions cannot\nplay a netgame!\n(server version %d.%d.%d)"), VERSION/100, VERSION%100, SUBVERSION));
 	else if (!cv_allownewplayer.value && node)
 		SV_SendRefuse(node, M_GetText("The server is not accepting\njoins for the moment"));
@@ -4281,12 +4282,12 @@ static INT16 Consistancy(void)
 		ret += P_GetRandSeed();
 
 #ifdef MOBJCONSISTANCY
-	if (!thinkercap.next)
+	if (!thlist[THINK_MOBJ].next)
 	{
 		DEBFILE(va("Consistancy = %u\n", ret));
 		return ret;
 	}
-	for (th = thinkercap.next; th != &thinkercap; th = th->next)
+	for (th = thlist[THINK_MOBJ].next; th != &thlist[THINK_MOBJ]; th = th->next)
 	{
 		if (th->function.acp1 != (actionf_p1)P_MobjThinker)
 			continue;
@@ -4359,6 +4360,67 @@ static INT16 Consistancy(void)
 	return (INT16)(ret & 0xFFFF);
 }
 
+//
+// D_WorldChecksum
+// Like Consistancy, but a full 32 bits over every player and every
+// mobj, not just what nets care about. Used by -demoregress to catch
+// the first tic where a demo plays out differently.
+//
+#define WORLDSUM(v) (ret = (ret ^ (UINT32)(v)) * 16777619u)
+UINT32 D_WorldChecksum(void)
+{
+	INT32 i;
+	UINT32 ret = 2166136261u;
+	thinker_t *th;
+	mobj_t *mo;
+
+	WORLDSUM(leveltime);
+	WORLDSUM(P_GetRandSeed());
+
+	for (i = 0; i < MAXPLAYERS; i++)
+	{
+		if (!playeringame[i])
+			continue;
+
+		WORLDSUM(i);
+		WORLDSUM(players[i].playerstate);
+		WORLDSUM(players[i].health);
+		WORLDSUM(players[i].score);
+		WORLDSUM(players[i].pflags);
+		WORLDSUM(players[i].powers[pw_shield]);
+		WORLDSUM(players[i].powers[pw_flashing]);
+		WORLDSUM(players[i].speed);
+	}
+
+	if (!thlist[THINK_MOBJ].next)
+		return ret;
+
+	for (th = thlist[THINK_MOBJ].next; th != &thlist[THINK_MOBJ]; th = th->next)
+	{
+		if (th->function.acp1 != (actionf_p1)P_MobjThinker)
+			continue;
+
+		mo = (mobj_t *)th;
+		WORLDSUM(mo->type);
+		WORLDSUM(mo->x);
+		WORLDSUM(mo->y);
+		WORLDSUM(mo->z);
+		WORLDSUM(mo->momx);
+		WORLDSUM(mo->momy);
+		WORLDSUM(mo->momz);
+		WORLDSUM(mo->angle);
+		WORLDSUM(mo->flags);
+		WORLDSUM(mo->flags2);
+		WORLDSUM(mo->eflags);
+		WORLDSUM(mo->state - states);
+		WORLDSUM(mo->tics);
+		WORLDSUM(mo->health);
+	}
+
+	return ret;
+}
+#undef WORLDSUM
+
 // send the client packet to the server
 static void CL_SendClientCmd(void)
 {
@@ -4665,14 +4727,27 @@ void TryRunTics(tic_t realtics)
 	if (neededtic > gametic)
 	{
 		if (advancedemo)
-			D_StartTitle();
+		{
+			if (!(demoregress && G_DemoRegressNext()))
+				D_StartTitle();
+		}
 		else
 			// run the count * tics
 			while (neededtic > gametic)
 			{
 				DEBFILE(va("============ Running tic %d (local %d)\n", gametic, localgametic));
 
-				G_Ticker((gametic % NEWTICRATERATIO) == 0);
+				if (timingdemo)
+				{
+					precise_t start = I_GetPreciseTime();
+					G_Ticker((gametic % NEWTICRATERATIO) == 0);
+					if (timingdemo)
+						G_TimeDemoStage(TDS_TICKER, start);
+				}
+				else
+					G_Ticker((gametic % NEWTICRATERATIO) == 0);
+				if (demoregress && demoplayback)
+					G_DemoRegressTic();
 				ExtraDataTicker();
 				gametic++;
 				consistancy[gametic%BACKUPTICS] = Consistancy();
@@ -309,6 +309,7 @@ typedef struct
 	UINT8 subversion; // Contains build version
 	UINT8 localplayers;
 	UINT8 mode;
+	UINT8 modversion; // Builds that don't sync with each other, see MODVERSION
 } ATTRPACK clientconfig_pak;
 
 #define MAXSERVERNAME 32
@@ -510,6 +511,8 @@ void D_QuitNetGame(void);
 //? How many ticks to run?
 void TryRunTics(tic_t realtic);
 
+UINT32 D_WorldChecksum(void);
+
 // extra data for lmps
 // these functions scare me. they contain magic.
 /*boolean AddLmpExtradata(UINT8 **demo_p, INT32 playernum);
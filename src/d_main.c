@@ -236,6 +236,7 @@ static void D_Display(void)
 	boolean forcerefresh = false;
 	static boolean wipe = false;
 	INT32 wipedefindex = 0;
+	precise_t stagestart = 0;
 
 	if (dedicated)
 		return;
@@ -243,6 +244,9 @@ static void D_Display(void)
 	if (nodrawers)
 		return; // for comparative timing/profiling
 
+	if (timingdemo)
+		stagestart = I_GetPreciseTime();
+
 	// check for change of screen size (video mode)
 	if (setmodeneeded && !wipe)
 		SCR_SetMode(); // change video mode
@@ -357,6 +361,9 @@ static void D_Display(void)
 		// draw the view directly
 		if (cv_renderview.value && !automapactive)
 		{
+			if (timingdemo)
+				stagestart = G_TimeDemoStage(TDS_HUD, stagestart);
+
 			if (players[displayplayer].mo || players[displayplayer].playerstate == PST_DEAD)
 			{
 				topleft = screens[0] + viewwindowy*vid.width + viewwindowx;
@@ -400,6 +407,9 @@ static void D_Display(void)
 				if (postimgtype2)
 					V_DoPostProcessor(1, postimgtype2, postimgparam2);
 			}
+
+			if (timingdemo)
+				stagestart = G_TimeDemoStage(TDS_RENDER, stagestart);
 		}
 
 		if (lastdraw)
@@ -493,8 +503,16 @@ static void D_Display(void)
 			V_DrawRightAlignedString(BASEVIDWIDTH, BASEVIDHEIGHT-ST_HEIGHT-10, V_YELLOWMAP, s);
 		}
 
+		if (timingdemo)
+			stagestart = G_TimeDemoStage(TDS_HUD, stagestart);
+
 		I_FinishUpdate(); // page flip or blit buffer
+
+		if (timingdemo)
+			G_TimeDemoStage(TDS_PRESENT, stagestart);
 	}
+	else if (timingdemo)
+		G_TimeDemoStage(TDS_HUD, stagestart);
 }
 
 // =========================================================================
@@ -506,6 +524,7 @@ tic_t rendergametic;
 void D_SRB2Loop(void)
 {
 	tic_t oldentertics = 0, entertic = 0, realtics = 0, rendertimeout = INFTICS;
+	precise_t framestart = 0;
 
 	if (dedicated)
 		server = true;
@@ -583,6 +602,9 @@ void D_SRB2Loop(void)
 			continue;
 		}
 
+		if (timingdemo)
+			framestart = I_GetPreciseTime();
+
 #ifdef HW3SOUND
 		HW3S_BeginFrameUpdate();
 #endif
@@ -639,6 +661,9 @@ void D_SRB2Loop(void)
 #ifdef HAVE_BLUA
 		LUA_Step();
 #endif
+
+		if (timingdemo)
+			G_TimeDemoFrame(framestart);
 	}
 }
 
@@ -1225,7 +1250,7 @@ void D_SRB2Main(void)
 	R_Init();
 
 	// setting up sound
-	if (dedicated)
+	if (dedicated || M_CheckParm("-demoregress")) // -demoregress is headless too
 	{
 		sound_disabled = true;
 		midi_disabled = digital_disabled = true;
@@ -1293,6 +1318,23 @@ void D_SRB2Main(void)
 	if (!autostart)
 		M_PushSpecialParameters(); // push all "+" parameters at the command buffer
 
+	// play a list of demos back headless, checking each against its baseline
+	if (M_CheckParm("-demoregress") && M_IsNextParm())
+	{
+		const char *demos[64];
+		INT32 numdemos = 0;
+		boolean record = M_CheckParm("-demoregressrecord") != 0;
+
+		M_CheckParm("-demoregress");
+		while (M_IsNextParm() && numdemos < (INT32)(sizeof demos / sizeof *demos))
+			demos[numdemos++] = M_GetNextParm();
+
+		G_StartDemoRegress(demos, numdemos, record);
+		G_SetGamestate(GS_NULL);
+		wipegamestate = GS_NULL;
+		return;
+	}
+
 	// demo doesn't need anymore to be added with D_AddFile()
 	p = M_CheckParm("-playdemo");
 	if (!p)
@@ -1316,6 +1358,22 @@ void D_SRB2Main(void)
 
 		CONS_Printf(M_GetText("Playing demo %s.\n"), tmp);
 
+		// profile every thinker the demo runs, write it out when it ends
+		if (M_CheckParm("-thinkerprof") && M_IsNextParm())
+			P_StartDemoThinkerProfile(M_GetNextParm());
+
+		// timedemo results for scripts: frame time stats as JSON, every frame as CSV
+		if (M_CheckParm("-timedemo"))
+		{
+			const char *json = NULL;
+			if (M_CheckParm("-timedemojson") && M_IsNextParm())
+				json = M_GetNextParm();
+			if (M_CheckParm("-timedemocsv") && M_IsNextParm())
+				G_TimeDemoReportTo(json, M_GetNextParm());
+			else
+				G_TimeDemoReportTo(json, NULL);
+		}
+
 		if (M_CheckParm("-playdemo"))
 		{
 			singledemo = true; // quit after one demo
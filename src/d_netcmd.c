@@ -107,6 +107,7 @@ static void Fishcake_OnChange(void);
 static void Command_Playdemo_f(void);
 static void Command_Timedemo_f(void);
 static void Command_Stopdemo_f(void);
+static void Command_Demoseek_f(void);
 static void Command_StartMovie_f(void);
 static void Command_StopMovie_f(void);
 static void Command_Map_f(void);
@@ -492,6 +493,11 @@ void D_RegisterServerCommands(void)
 #ifdef HAVE_BLUA
 	COM_AddCommand("archivetest", Command_Archivetest_f);
 #endif
+#endif
+#ifdef HAVE_BLUA
+	COM_AddCommand("luagcstats", Command_Luagcstats_f);
+	COM_AddCommand("luapools", Command_Luapools_f);
+	CV_RegisterVar(&cv_luagcbudget);
 #endif
 
 	// for master server connection
@@ -611,8 +617,10 @@ void D_RegisterClientCommands(void)
 
 	COM_AddCommand("numthinkers", Command_Numthinkers_f);
 	COM_AddCommand("countmobjs", Command_CountMobjs_f);
-#ifdef __3DS__
 	COM_AddCommand("thinkertimes", Command_Thinkertimes_f);
+	COM_AddCommand("sightstats", Command_Sightstats_f);
+#ifdef HAVE_BLUA
+	COM_AddCommand("luaprofile", Command_Luaprofile_f);
 #endif
 
 	COM_AddCommand("changeteam", Command_Teamchange_f);
@@ -621,6 +629,10 @@ void D_RegisterClientCommands(void)
 	COM_AddCommand("playdemo", Command_Playdemo_f);
 	COM_AddCommand("timedemo", Command_Timedemo_f);
 	COM_AddCommand("stopdemo", Command_Stopdemo_f);
+	COM_AddCommand("demoseek", Command_Demoseek_f);
+#ifndef _NDS
+	CV_RegisterVar(&cv_demosnapshots);
+#endif
 	COM_AddCommand("playintro", Command_Playintro_f);
 
 	COM_AddCommand("resetcamera", Command_ResetCamera_f);
@@ -771,6 +783,9 @@ void D_RegisterClientCommands(void)
 	CV_RegisterVar(&cv_midimusicvolume);
 	CV_RegisterVar(&cv_numChannels);
 
+	// w_wad.c
+	CV_RegisterVar(&cv_lumpdecompcache);
+
 	// i_cdmus.c
 	CV_RegisterVar(&cd_volume);
 	CV_RegisterVar(&cdUpdate);
@@ -1531,6 +1546,28 @@ static void Command_Stopdemo_f(void)
 	CONS_Printf(M_GetText("Stopped demo.\n"));
 }
 
+static void Command_Demoseek_f(void)
+{
+	const char *arg;
+	const char *colon;
+	UINT32 tic;
+
+	if (COM_Argc() != 2)
+	{
+		CONS_Printf(M_GetText("demoseek <tic> or <minutes>:<seconds>: jump to a point in the demo being played\n"));
+		return;
+	}
+
+	arg = COM_Argv(1);
+	colon = strchr(arg, ':');
+	if (colon)
+		tic = (UINT32)(atoi(arg)*60*TICRATE + atof(colon+1)*TICRATE);
+	else
+		tic = (UINT32)atoi(arg);
+
+	G_DemoSeek(tic);
+}
+
 static void Command_StartMovie_f(void)
 {
 	M_StartMovie();
@@ -4106,7 +4143,7 @@ static void Command_Archivetest_f(void)
 
 	// assign mobjnum
 	i = 1;
-	for (th = thinkercap.next; th != &thinkercap; th = th->next)
+	for (th = thlist[THINK_MOBJ].next; th != &thlist[THINK_MOBJ]; th = th->next)
 		if (th->function.acp1 == (actionf_p1)P_MobjThinker)
 			((mobj_t *)th)->mobjnum = i++;
 
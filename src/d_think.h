@@ -49,6 +49,10 @@ typedef struct thinker_s
 	// killough 11/98: count of how many other objects reference
 	// this one using pointers. Used for garbage collection.
 	INT32 references;
+
+#ifdef HAVE_BLUA
+	boolean luadata; // Lua has a userdata for this, see LUA_InvalidateThinker
+#endif
 } thinker_t;
 
 #endif
@@ -7851,6 +7851,18 @@ void DEH_Check(void)
 #endif
 }
 
+// Name of a mobj type, for profiler output and the like.
+// Freeslots get the name they were allocated under.
+const char *DEH_MobjTypeName(INT32 type)
+{
+	if (type >= 0 && type < MT_FIRSTFREESLOT
+	 && (size_t)type < sizeof(MOBJTYPE_LIST)/sizeof(MOBJTYPE_LIST[0]))
+		return MOBJTYPE_LIST[type];
+	if (type >= MT_FIRSTFREESLOT && type <= MT_LASTFREESLOT && FREE_MOBJS[type - MT_FIRSTFREESLOT])
+		return va("MT_%s", FREE_MOBJS[type - MT_FIRSTFREESLOT]);
+	return va("%d", type);
+}
+
 #ifdef HAVE_BLUA
 #include "lua_script.h"
 #include "lua_libs.h"
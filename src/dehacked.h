@@ -40,6 +40,7 @@ void DEH_LoadDehackedLumpPwad(UINT16 wad, UINT16 lump);
 void DEH_Check(void);
 
 fixed_t get_number(const char *word);
+const char *DEH_MobjTypeName(INT32 type);
 
 #ifdef HAVE_BLUA
 boolean LUA_SetLuaAction(void *state, const char *actiontocompare);
@@ -395,6 +395,7 @@ typedef UINT32 lumpnum_t; // 16 : 16 unsigned long (wad num: lump num)
 #define LUMPERROR UINT32_MAX
 
 typedef UINT32 tic_t;
+typedef UINT64 precise_t; // see I_GetPreciseTime
 #define INFTICS UINT32_MAX
 
 #include "endian.h" // This is needed to make sure the below macro acts correctly in big endian builds
@@ -16,6 +16,17 @@ tic_t I_GetTime(void)
 	return 0;
 }
 
+precise_t I_GetPreciseTime(void)
+{
+	return 0;
+}
+
+UINT64 I_PreciseToMicros(precise_t d)
+{
+	(void)d;
+	return 0;
+}
+
 void I_Sleep(void){}
 
 void I_GetEvent(void){}
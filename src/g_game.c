@@ -46,6 +46,7 @@
 #include "b_bot.h"
 #include "m_cond.h" // condition sets
 #include "md5.h" // demo checksums
+#include "lzf.h" // demo snapshots
 
 gameaction_t gameaction;
 gamestate_t gamestate = GS_NULL;
@@ -68,6 +69,7 @@ char customversionstring[32] = "\0";
 static void G_DoCompleted(void);
 static void G_DoStartContinue(void);
 static void G_DoContinued(void);
+static void G_DemoSnapshotTic(void);
 static void G_DoWorldDone(void);
 
 char   mapmusname[7]; // Music name
@@ -97,6 +99,7 @@ UINT32 demoDelayTime = 15*TICRATE;
 UINT32 demoIdleTime  = 3*TICRATE;
 
 boolean timingdemo; // if true, exit with report on completion
+boolean demoregress; // playing through -demoregress
 boolean nodrawers; // for comparative timing purposes
 boolean noblit; // for comparative timing purposes
 static tic_t demostarttime; // for comparative timing purposes
@@ -242,6 +245,7 @@ static UINT16 demoversion;
 boolean singledemo; // quit after playing a demo from cmdline
 boolean demo_start; // don't start playing demo right away
 static boolean demosynced = true; // console warning message
+static UINT32 demoplaytic; // ticcmds read so far
 
 boolean metalrecording; // recording as metal sonic
 mobj_t *metalplayback;
@@ -373,6 +377,11 @@ consvar_t cv_chatheight= {"chatheight", "8", CV_SAVE, chatheight_cons_t, NULL, 0
 // chat notifications (do you want to hear beeps? I'd understand if you didn't.)
 consvar_t cv_chatnotifications= {"chatnotifications", "On", CV_SAVE, CV_OnOff, NULL, 0, NULL, NULL, 0, 0, NULL};
 
+// seconds of demo playback between snapshots that "demoseek" can jump back to
+// off by default, and never registered on the 3DS, where there's no memory for them
+static CV_PossibleValue_t demosnapshots_cons_t[] = {{0, "MIN"}, {600, "MAX"}, {0, NULL}};
+consvar_t cv_demosnapshots = {"demo_snapshots", "0", CV_SAVE, demosnapshots_cons_t, NULL, 0, NULL, NULL, 0, 0, NULL};
+
 // chat spam protection (why would you want to disable that???)
 consvar_t cv_chatspamprotection= {"chatspamprotection", "On", CV_SAVE, CV_OnOff, NULL, 0, NULL, NULL, 0, 0, NULL};
 
@@ -1991,6 +2000,9 @@ void G_Ticker(boolean run)
 	UINT32 i;
 	INT32 buf;
 
+	if (demoplayback && run)
+		G_DemoSnapshotTic();
+
 	P_MapStart();
 	// do player reborns if needed
 	if (gamestate == GS_LEVEL)
@@ -2559,7 +2571,7 @@ void G_ChangePlayerReferences(mobj_t *oldmo, mobj_t *newmo)
 	I_Assert((oldmo != NULL) && (newmo != NULL));
 
 	// scan all thinkers
-	for (th = thinkercap.next; th != &thinkercap; th = th->next)
+	for (th = thlist[THINK_MOBJ].next; th != &thlist[THINK_MOBJ]; th = th->next)
 	{
 		if (th->function.acp1 != (actionf_p1)P_MobjThinker)
 			continue;
@@ -3858,7 +3870,7 @@ char *G_BuildMapTitle(INT32 mapnum)
 // DEMO RECORDING
 //
 
-#define DEMOVERSION 0x0009
+#define DEMOVERSION 0x000a
 #define DEMOHEADER  "\xF0" "SRB2Replay" "\x0F"
 
 #define DF_GHOST        0x01 // This demo contains ghost data too!
@@ -3942,6 +3954,7 @@ void G_ReadDemoTiccmd(ticcmd_t *cmd, INT32 playernum)
 	if (!demo_p || !demo_start)
 		return;
 	ziptic = READUINT8(demo_p);
+	demoplaytic++;
 
 	if (ziptic & ZT_FWD)
 		oldcmd.forwardmove = READSINT8(demo_p);
@@ -4313,7 +4326,7 @@ void G_ConsGhostTic(void)
 				demo_p += sizeof(angle_t); // angle, unnecessary for cons.
 
 				mobj = NULL;
-				for (th = thinkercap.next; th != &thinkercap; th = th->next)
+				for (th = thlist[THINK_MOBJ].next; th != &thlist[THINK_MOBJ]; th = th->next)
 				{
 					if (th->function.acp1 != (actionf_p1)P_MobjThinker)
 						continue;
@@ -4364,6 +4377,263 @@ void G_ConsGhostTic(void)
 	}
 }
 
+// Demo playback snapshots
+// Every cv_demosnapshots seconds of playback (and once at the very start),
+// the whole game is saved with P_SaveNetGame, along with where we are in
+// the demo. "demoseek" loads the last snapshot at or before where it's
+// going and only simulates the rest, instead of the demo from the start.
+// When they take up more than DEMOSNAPSHOTMEMORY, every other one is
+// dropped and the interval doubles, so long demos keep a spread of them.
+#define DEMOSNAPSHOTMEMORY (16*1024*1024)
+
+typedef struct
+{
+	UINT32 tic; // demoplaytic
+	UINT8 *data; // lzf'd, or not if compressedlen is 0
+	size_t length, compressedlen;
+	size_t demopos;
+	ticcmd_t oldcmd;
+	mobj_t oldghost;
+	boolean synced;
+	boolean metal; // Metal Sonic race running
+	size_t metalpos;
+	mobj_t oldmetal;
+} demosnapshot_t;
+
+static demosnapshot_t *demosnapshots = NULL;
+static size_t numdemosnapshots = 0, maxdemosnapshots = 0;
+static size_t demosnapshotbytes = 0; // of data, all snapshots together
+static UINT32 demosnapshotstride = 1; // cv_demosnapshots intervals between them
+
+static void G_ClearDemoSnapshots(void)
+{
+	size_t i;
+	for (i = 0; i < numdemosnapshots; i++)
+		Z_Free(demosnapshots[i].data);
+	Z_Free(demosnapshots);
+	demosnapshots = NULL;
+	numdemosnapshots = maxdemosnapshots = 0;
+	demosnapshotbytes = 0;
+	demosnapshotstride = 1;
+}
+
+// Drops every other snapshot, keeping the one from the start.
+static void G_ThinDemoSnapshots(void)
+{
+	size_t i, j;
+
+	for (i = j = 0; i < numdemosnapshots; i++)
+	{
+		if (i & 1)
+		{
+			demosnapshotbytes -= demosnapshots[i].compressedlen ? demosnapshots[i].compressedlen : demosnapshots[i].length;
+			Z_Free(demosnapshots[i].data);
+		}
+		else
+			demosnapshots[j++] = demosnapshots[i];
+	}
+	numdemosnapshots = j;
+	demosnapshotstride *= 2;
+}
+
+static void G_TakeDemoSnapshot(void)
+{
+	demosnapshot_t *snap;
+	UINT8 *savebuffer = malloc(NETSAVEGAMESIZE), *compressed;
+	size_t length;
+
+	if (!savebuffer)
+		return; // not worth an error, seeking just gets slower
+
+	save_p = savebuffer;
+	save_end = savebuffer + NETSAVEGAMESIZE;
+	if (!P_SaveNetGame())
+	{
+		CONS_Alert(CONS_WARNING, M_GetText("Demo snapshot at tic %u is too big, skipping it\n"), demoplaytic);
+		free(savebuffer);
+		save_p = NULL;
+		return;
+	}
+	length = save_p - savebuffer;
+	save_p = NULL;
+
+	if (numdemosnapshots == maxdemosnapshots)
+	{
+		maxdemosnapshots = maxdemosnapshots ? maxdemosnapshots*2 : 16;
+		demosnapshots = Z_Realloc(demosnapshots, maxdemosnapshots * sizeof (*demosnapshots), PU_STATIC, NULL);
+	}
+	snap = &demosnapshots[numdemosnapshots++];
+
+	snap->tic = demoplaytic;
+	snap->length = length;
+	compressed = Z_Malloc(length, PU_STATIC, NULL);
+	snap->compressedlen = lzf_compress(savebuffer, length, compressed, length - 1);
+	if (snap->compressedlen)
+		snap->data = Z_Realloc(compressed, snap->compressedlen, PU_STATIC, NULL);
+	else
+		snap->data = M_Memcpy(compressed, savebuffer, length);
+	free(savebuffer);
+
+	snap->demopos = demo_p - demobuffer;
+	snap->oldcmd = oldcmd;
+	snap->oldghost = oldghost;
+	snap->synced = demosynced;
+	snap->metal = (metalplayback != NULL);
+	snap->metalpos = metal_p ? (size_t)(metal_p - metalbuffer) : 0;
+	snap->oldmetal = oldmetal;
+
+	demosnapshotbytes += snap->compressedlen ? snap->compressedlen : snap->length;
+	while (demosnapshotbytes > DEMOSNAPSHOTMEMORY && numdemosnapshots > 1)
+		G_ThinDemoSnapshots();
+}
+
+static boolean G_LoadDemoSnapshot(const demosnapshot_t *snap)
+{
+	UINT8 *savebuffer;
+	boolean ok;
+
+	if (snap->compressedlen)
+	{
+		savebuffer = Z_Malloc(snap->length, PU_STATIC, NULL);
+		lzf_decompress(snap->data, snap->compressedlen, savebuffer, snap->length);
+	}
+	else
+		savebuffer = snap->data;
+
+	save_p = savebuffer;
+	ok = P_LoadNetGame();
+	save_p = NULL;
+	if (snap->compressedlen)
+		Z_Free(savebuffer);
+
+	if (!ok)
+		return false;
+
+	demo_p = demobuffer + snap->demopos;
+	oldcmd = snap->oldcmd;
+	oldghost = snap->oldghost;
+	demosynced = snap->synced;
+	demoplaytic = snap->tic;
+
+	// P_SetupLevel stopped Metal Sonic, and the savegame doesn't keep where
+	// his recording was between tics.
+	if (!snap->metal)
+	{
+		if (metalplayback)
+			G_StopMetalDemo();
+	}
+	else
+	{
+		if (!metalplayback)
+			G_DoPlayMetal();
+		if (!metalplayback)
+			return false;
+		metal_p = metalbuffer + snap->metalpos;
+		oldmetal = snap->oldmetal;
+	}
+	return true;
+}
+
+//
+// G_DemoSnapshotTic
+// Takes a snapshot if one is due. Called before every playback tic.
+//
+static void G_DemoSnapshotTic(void)
+{
+	UINT32 interval = cv_demosnapshots.value * TICRATE;
+	UINT32 last;
+
+	if (!interval)
+		return;
+
+	if (gamestate != GS_LEVEL || !demo_p || !demo_start || titledemo)
+		return;
+
+	if (timingdemo || demoregress)
+		return; // don't skew the numbers
+
+	if (numdemosnapshots)
+	{
+		last = demosnapshots[numdemosnapshots-1].tic;
+		if (demoplaytic < last + interval * demosnapshotstride)
+			return; // not due, or already have this part
+	}
+
+	G_TakeDemoSnapshot();
+}
+
+//
+// G_DemoSeek
+// Jumps demo playback to the given tic (counted in ticcmds from the start).
+//
+void G_DemoSeek(UINT32 tic)
+{
+	const demosnapshot_t *snap = NULL;
+	UINT32 from = demoplaytic, stalled = 0;
+	precise_t start = I_GetPreciseTime();
+	size_t i;
+
+	if (!demoplayback || titledemo || gamestate != GS_LEVEL || !demo_start)
+	{
+		CONS_Printf(M_GetText("You can only seek while a demo is playing in a level.\n"));
+		return;
+	}
+
+	if (paused || P_AutoPause())
+	{
+		CONS_Printf(M_GetText("Unpause the demo to seek.\n"));
+		return;
+	}
+
+	// last snapshot at or before the target, if it beats simulating from here
+	for (i = numdemosnapshots; i--;)
+		if (demosnapshots[i].tic <= tic)
+		{
+			if (tic < demoplaytic || demosnapshots[i].tic > demoplaytic)
+				snap = &demosnapshots[i];
+			break;
+		}
+
+	if (tic < demoplaytic && !snap)
+	{
+#ifndef _NDS
+		if (!cv_demosnapshots.value)
+			CONS_Printf(M_GetText("Set demo_snapshots before playing a demo to seek back in it.\n"));
+		else
+#endif
+			CONS_Printf(M_GetText("No demo snapshot to seek back to.\n"));
+		return;
+	}
+
+	if (snap)
+	{
+		if (!G_LoadDemoSnapshot(snap))
+		{
+			CONS_Alert(CONS_ERROR, M_GetText("Demo snapshot at tic %u couldn't be loaded\n"), snap->tic);
+			G_CheckDemoStatus();
+			return;
+		}
+		from = snap->tic;
+	}
+
+	// P_Ticker reads the demo, but not every tic (level end, intermission)
+	while (demoplayback && gamestate == GS_LEVEL && demoplaytic < tic && stalled < TICRATE)
+	{
+		UINT32 before = demoplaytic;
+		G_Ticker(true);
+		stalled = (demoplaytic == before) ? stalled + 1 : 0;
+	}
+
+	S_StopSounds();
+	if (gamestate == GS_LEVEL)
+		P_ResetCamera(&players[displayplayer], &camera);
+
+	if (demoplayback)
+		CONS_Printf(M_GetText("Seeked to tic %u: %u tics simulated from %s in %f seconds\n"), demoplaytic,
+			demoplaytic - from, snap ? M_GetText("a snapshot") : M_GetText("here"),
+			(double)I_PreciseToMicros(I_GetPreciseTime() - start) / 1000000.0);
+}
+
 void G_GhostTicker(void)
 {
 	demoghost *g,*p;
@@ -5031,6 +5301,7 @@ UINT8 G_CmpDemoTime(char *oldname, char *newname)
 	{
 	case DEMOVERSION: // latest always supported
 	// compatibility available?
+	case 0x0009:
 	case 0x0008:
 		break;
 	// too old, cannot support.
@@ -5170,12 +5441,13 @@ void G_DoPlayDemo(char *defdemoname)
 	switch(demoversion)
 	{
 	case DEMOVERSION: // latest always supported
-	// compatibility available?
-	case 0x0008:
 		break;
 	// too old, cannot support.
 	default:
-		snprintf(msg, 1024, M_GetText("%s is an incompatible replay format and cannot be played.\n"), pdemoname);
+		if (demoversion < DEMOVERSION) // thinkers ran in another order back then, it would desync
+			snprintf(msg, 1024, M_GetText("%s was recorded with an older version of SRB2 and cannot be played.\n"), pdemoname);
+		else
+			snprintf(msg, 1024, M_GetText("%s is an incompatible replay format and cannot be played.\n"), pdemoname);
 		CONS_Alert(CONS_ERROR, "%s", msg);
 		M_StartMessage(msg, NULL, MM_NOTHING);
 		Z_Free(pdemoname);
@@ -5329,6 +5601,8 @@ void G_DoPlayDemo(char *defdemoname)
 	players[0].acceleration = acceleration;
 	players[0].jumpfactor = jumpfactor;
 
+	G_ClearDemoSnapshots();
+	demoplaytic = 0;
 	demo_start = true;
 }
 
@@ -5392,6 +5666,7 @@ void G_AddGhost(char *defdemoname)
 	{
 	case DEMOVERSION: // latest always supported
 	// compatibility available?
+	case 0x0009:
 	case 0x0008:
 		break;
 	// too old, cannot support.
@@ -5562,6 +5837,40 @@ void G_AddGhost(char *defdemoname)
 //
 static INT32 restorecv_vidwait;
 
+// Per-frame timings of the current timedemo, in microseconds.
+// The "other" stage is whatever the frame spent outside of the others
+// (sound, Lua, waiting for input...).
+#define TDS_OTHER NUMTIMEDEMOSTAGES
+#define NUMTIMEDEMOCOLUMNS (NUMTIMEDEMOSTAGES+2) // stages, other, frame
+
+typedef struct
+{
+	UINT32 us[NUMTIMEDEMOCOLUMNS];
+} timedemoframe_t;
+
+static const char *const timedemocolumns[NUMTIMEDEMOCOLUMNS] = {
+	"ticker", "render", "hud", "present", "other", "frame"
+};
+
+// Frame time histogram, upper bounds in microseconds (the last bucket has none)
+static const UINT32 timedemohistbounds[] = {1000, 2000, 4000, 8000, 16667, 33333, 50000, 100000};
+#define NUMTIMEDEMOHIST (sizeof (timedemohistbounds) / sizeof (timedemohistbounds[0]) + 1)
+
+static timedemoframe_t *timedemoframes = NULL;
+static size_t numtimedemoframes = 0, maxtimedemoframes = 0;
+static precise_t timedemostages[NUMTIMEDEMOSTAGES]; // current frame so far
+static precise_t timedemostart = 0; // frames that started before this don't count
+static char *timedemoname = NULL;
+static char *timedemojson = NULL; // -timedemojson
+static char *timedemocsv = NULL; // -timedemocsv
+
+static void G_ResetTimeDemoFrames(void)
+{
+	numtimedemoframes = 0;
+	memset(timedemostages, 0, sizeof (timedemostages));
+	timedemostart = I_GetPreciseTime();
+}
+
 void G_TimeDemo(const char *name)
 {
 	nodrawers = M_CheckParm("-nodraw");
@@ -5573,9 +5882,466 @@ void G_TimeDemo(const char *name)
 	singletics = true;
 	framecount = 0;
 	demostarttime = I_GetTime();
+	Z_Free(timedemoname);
+	timedemoname = Z_StrDup(name);
+	G_ResetTimeDemoFrames();
 	G_DeferedPlayDemo(name);
 }
 
+//
+// G_TimeDemoStage
+// Adds the time since start to the given stage of the current frame.
+// Returns the current time, so the next stage can start from there.
+//
+precise_t G_TimeDemoStage(timedemostage_t stage, precise_t start)
+{
+	precise_t now = I_GetPreciseTime();
+	timedemostages[stage] += now - start;
+	return now;
+}
+
+//
+// G_TimeDemoFrame
+// Ends the current frame, which started at start.
+//
+void G_TimeDemoFrame(precise_t start)
+{
+	timedemoframe_t *frame;
+	precise_t now = I_GetPreciseTime(), staged = 0;
+	INT32 i;
+
+	if (start < timedemostart) // straddles the level load
+	{
+		memset(timedemostages, 0, sizeof (timedemostages));
+		return;
+	}
+
+	if (numtimedemoframes == maxtimedemoframes)
+	{
+		maxtimedemoframes = maxtimedemoframes ? maxtimedemoframes*2 : 4096;
+		timedemoframes = Z_Realloc(timedemoframes, maxtimedemoframes * sizeof (*timedemoframes), PU_STATIC, NULL);
+	}
+
+	frame = &timedemoframes[numtimedemoframes++];
+	for (i = 0; i < NUMTIMEDEMOSTAGES; i++)
+	{
+		frame->us[i] = (UINT32)I_PreciseToMicros(timedemostages[i]);
+		staged += timedemostages[i];
+	}
+	frame->us[NUMTIMEDEMOCOLUMNS-1] = (UINT32)I_PreciseToMicros(now - start);
+	frame->us[TDS_OTHER] = (now - start > staged) ? (UINT32)I_PreciseToMicros(now - start - staged) : 0;
+	memset(timedemostages, 0, sizeof (timedemostages));
+}
+
+//
+// G_TimeDemoReportTo
+// Have the next timedemo write its results out, then quit.
+// Either may be NULL.
+//
+void G_TimeDemoReportTo(const char *jsonfile, const char *csvfile)
+{
+	Z_Free(timedemojson);
+	Z_Free(timedemocsv);
+	timedemojson = jsonfile ? Z_StrDup(jsonfile) : NULL;
+	timedemocsv = csvfile ? Z_StrDup(csvfile) : NULL;
+}
+
+typedef struct
+{
+	UINT32 min, median, p95, p99, max;
+	double mean;
+} timedemostats_t;
+
+static int G_CompareUINT32(const void *a, const void *b)
+{
+	const UINT32 x = *(const UINT32 *)a, y = *(const UINT32 *)b;
+	return (x > y) - (x < y);
+}
+
+// Nearest-rank percentile of a sorted list
+static UINT32 G_Percentile(const UINT32 *sorted, size_t n, UINT32 pct)
+{
+	size_t rank = (n * pct + 99) / 100;
+	return sorted[rank ? rank - 1 : 0];
+}
+
+static void G_TimeDemoStats(timedemostats_t *stats, size_t *hist)
+{
+	UINT32 *sorted = malloc(numtimedemoframes * sizeof (*sorted));
+	size_t i, j;
+	INT32 c;
+
+	if (!sorted)
+		I_Error("G_TimeDemoStats: Out of memory");
+
+	memset(hist, 0, NUMTIMEDEMOHIST * sizeof (*hist));
+
+	for (c = 0; c < NUMTIMEDEMOCOLUMNS; c++)
+	{
+		UINT64 sum = 0;
+		for (i = 0; i < numtimedemoframes; i++)
+		{
+			sorted[i] = timedemoframes[i].us[c];
+			sum += sorted[i];
+		}
+		qsort(sorted, numtimedemoframes, sizeof (*sorted), G_CompareUINT32);
+
+		stats[c].min = sorted[0];
+		stats[c].median = G_Percentile(sorted, numtimedemoframes, 50);
+		stats[c].p95 = G_Percentile(sorted, numtimedemoframes, 95);
+		stats[c].p99 = G_Percentile(sorted, numtimedemoframes, 99);
+		stats[c].max = sorted[numtimedemoframes - 1];
+		stats[c].mean = (double)sum / numtimedemoframes;
+	}
+
+	// sorted still holds the frame totals
+	for (i = j = 0; i < numtimedemoframes; i++)
+	{
+		while (j < NUMTIMEDEMOHIST - 1 && sorted[i] >= timedemohistbounds[j])
+			j++;
+		hist[j]++;
+	}
+
+	free(sorted);
+}
+
+static void G_WriteTimeDemoJSON(const char *filename, const timedemostats_t *stats, const size_t *hist, double seconds)
+{
+	FILE *f = fopen(filename, "w");
+	const char *c;
+	size_t i;
+
+	if (!f)
+	{
+		CONS_Alert(CONS_ERROR, M_GetText("Couldn't open %s for writing\n"), filename);
+		return;
+	}
+
+	fprintf(f, "{\n\t\"demo\": \"");
+	for (c = timedemoname; *c; c++)
+	{
+		if (*c == '"' || *c == '\\')
+			fputc('\\', f);
+		fputc(*c, f);
+	}
+	fprintf(f, "\",\n");
+	fprintf(f, "\t\"version\": \"%s\",\n", comprevision);
+	fprintf(f, "\t\"nodraw\": %s,\n", nodrawers ? "true" : "false");
+	fprintf(f, "\t\"gametics\": %u,\n", leveltime);
+	fprintf(f, "\t\"frames\": %s,\n", sizeu1(numtimedemoframes));
+	fprintf(f, "\t\"seconds\": %f,\n", seconds);
+	fprintf(f, "\t\"avg_fps\": %f,\n", numtimedemoframes / seconds);
+	fprintf(f, "\t\"stages\": {\n");
+	for (i = 0; i < NUMTIMEDEMOCOLUMNS; i++)
+		fprintf(f, "\t\t\"%s\": {\"min_us\": %u, \"median_us\": %u, \"p95_us\": %u, \"p99_us\": %u, \"max_us\": %u, \"mean_us\": %.1f}%s\n",
+			timedemocolumns[i], stats[i].min, stats[i].median, stats[i].p95, stats[i].p99, stats[i].max, stats[i].mean,
+			(i < NUMTIMEDEMOCOLUMNS - 1) ? "," : "");
+	fprintf(f, "\t},\n\t\"histogram\": [\n");
+	for (i = 0; i < NUMTIMEDEMOHIST; i++)
+	{
+		if (i < NUMTIMEDEMOHIST - 1)
+			fprintf(f, "\t\t{\"below_us\": %u, \"frames\": %s},\n", timedemohistbounds[i], sizeu1(hist[i]));
+		else
+			fprintf(f, "\t\t{\"below_us\": null, \"frames\": %s}\n", sizeu1(hist[i]));
+	}
+	fprintf(f, "\t]\n}\n");
+
+	fclose(f);
+	CONS_Printf(M_GetText("Timedemo results written to %s\n"), filename);
+}
+
+static void G_WriteTimeDemoCSV(const char *filename)
+{
+	FILE *f = fopen(filename, "w");
+	size_t i;
+	INT32 c;
+
+	if (!f)
+	{
+		CONS_Alert(CONS_ERROR, M_GetText("Couldn't open %s for writing\n"), filename);
+		return;
+	}
+
+	fprintf(f, "frame");
+	for (c = 0; c < NUMTIMEDEMOCOLUMNS; c++)
+		fprintf(f, ",%s_us", timedemocolumns[c]);
+	fprintf(f, "\n");
+	for (i = 0; i < numtimedemoframes; i++)
+	{
+		fprintf(f, "%s", sizeu1(i));
+		for (c = 0; c < NUMTIMEDEMOCOLUMNS; c++)
+			fprintf(f, ",%u", timedemoframes[i].us[c]);
+		fprintf(f, "\n");
+	}
+
+	fclose(f);
+	CONS_Printf(M_GetText("Timedemo frames written to %s\n"), filename);
+}
+
+//
+// G_TimeDemoReport
+// Prints frame time percentiles per stage and a histogram, and writes
+// out the files asked for on the command line.
+// Returns true if the game should quit now.
+//
+static boolean G_TimeDemoReport(void)
+{
+	timedemostats_t stats[NUMTIMEDEMOCOLUMNS];
+	size_t hist[NUMTIMEDEMOHIST];
+	double seconds;
+	size_t i;
+	boolean quit = (timedemojson || timedemocsv);
+
+	if (numtimedemoframes)
+	{
+		G_TimeDemoStats(stats, hist);
+		seconds = (double)stats[NUMTIMEDEMOCOLUMNS-1].mean * numtimedemoframes / 1000000.0;
+		if (seconds <= 0.0)
+			seconds = 1.0/1000000.0;
+
+		CONS_Printf(M_GetText("%s frames, %f frames per second%s\n"), sizeu1(numtimedemoframes),
+			numtimedemoframes / seconds, nodrawers ? M_GetText(" (not drawn)") : "");
+		CONS_Printf("%-8s %8s %8s %8s %8s %8s %8s\n", "us", "min", "median", "p95", "p99", "max", "mean");
+		for (i = 0; i < NUMTIMEDEMOCOLUMNS; i++)
+			CONS_Printf("%-8s %8u %8u %8u %8u %8u %8.1f\n", timedemocolumns[i],
+				stats[i].min, stats[i].median, stats[i].p95, stats[i].p99, stats[i].max, stats[i].mean);
+		for (i = 0; i < NUMTIMEDEMOHIST; i++)
+		{
+			if (!hist[i])
+				continue;
+			if (i < NUMTIMEDEMOHIST - 1)
+				CONS_Printf(M_GetText("  below %6.2f ms: %s (%.1f%%)\n"), timedemohistbounds[i] / 1000.0,
+					sizeu1(hist[i]), 100.0 * hist[i] / numtimedemoframes);
+			else
+				CONS_Printf(M_GetText("  above %6.2f ms: %s (%.1f%%)\n"), timedemohistbounds[i-1] / 1000.0,
+					sizeu1(hist[i]), 100.0 * hist[i] / numtimedemoframes);
+		}
+
+		if (timedemojson)
+			G_WriteTimeDemoJSON(timedemojson, stats, hist, seconds);
+		if (timedemocsv)
+			G_WriteTimeDemoCSV(timedemocsv);
+	}
+	else if (quit)
+		CONS_Alert(CONS_WARNING, M_GetText("No frames were timed, nothing written\n"));
+
+	G_TimeDemoReportTo(NULL, NULL);
+	Z_Free(timedemoframes);
+	timedemoframes = NULL;
+	numtimedemoframes = maxtimedemoframes = 0;
+	return quit;
+}
+
+// Demo regression runner (-demoregress)
+// Plays a list of demos back to back, as fast as possible and undrawn,
+// keeping D_WorldChecksum for every tic. Each demo's checksums are
+// compared against a baseline saved next to it (<demo>.sum, in srb2home
+// like -playdemo looks for demos), which is written if there isn't one
+// yet or -demoregressrecord is given. Quits when done, with an error if
+// any demo diverged or couldn't be played.
+#define DEMOSUMHEADER "SRB2DEMOSUM"
+
+static const char **regressdemos = NULL;
+static INT32 numregressdemos = 0, curregressdemo = -1, numregressfailed = 0;
+static boolean regressrecord = false;
+static UINT32 *regresssums = NULL; // this playback, one per tic
+static size_t numregresssums = 0, maxregresssums = 0;
+static precise_t regressstart;
+static precise_t regresstotaltime = 0;
+static UINT64 regresstotaltics = 0;
+
+void G_StartDemoRegress(const char **demos, INT32 numdemos, boolean record)
+{
+	INT32 i;
+
+	regressdemos = Z_Malloc(numdemos * sizeof (*regressdemos), PU_STATIC, NULL);
+	for (i = 0; i < numdemos; i++)
+		regressdemos[i] = Z_StrDup(demos[i]);
+	numregressdemos = numdemos;
+	curregressdemo = -1;
+	numregressfailed = 0;
+	regressrecord = record;
+
+	demoregress = true;
+	singletics = true;
+	nodrawers = true;
+	D_AdvanceDemo();
+}
+
+static const char *G_DemoRegressBaseline(const char *name)
+{
+	return va("%s"PATHSEP"%s.sum", srb2home, name);
+}
+
+// Returns the number of checksums read into *sums, 0 if there's no baseline
+static size_t G_ReadDemoRegressBaseline(const char *filename, UINT32 **sums)
+{
+	UINT8 *buffer;
+	char *p, *end;
+	size_t n = 0, max;
+
+	if (!FIL_ReadFile(filename, &buffer))
+		return 0;
+
+	p = (char *)buffer;
+	if (strncmp(p, DEMOSUMHEADER, sizeof (DEMOSUMHEADER)-1))
+	{
+		CONS_Alert(CONS_WARNING, M_GetText("%s is not a demo checksum file\n"), filename);
+		Z_Free(buffer);
+		return 0;
+	}
+	p = strchr(p, '\n'); // rest of the header line is just for people
+	if (!p)
+	{
+		Z_Free(buffer);
+		return 0;
+	}
+
+	max = strlen(p)/9 + 1; // at most one per "xxxxxxxx\n"
+	*sums = Z_Malloc(max * sizeof (**sums), PU_STATIC, NULL);
+	while (n < max)
+	{
+		UINT32 sum = (UINT32)strtoul(p, &end, 16);
+		if (end == p)
+			break;
+		(*sums)[n++] = sum;
+		p = end;
+	}
+
+	Z_Free(buffer);
+	if (!n)
+	{
+		Z_Free(*sums);
+		*sums = NULL;
+	}
+	return n;
+}
+
+static boolean G_WriteDemoRegressBaseline(const char *filename)
+{
+	FILE *f = fopen(filename, "w");
+	size_t i;
+
+	if (!f)
+		return false;
+
+	fprintf(f, DEMOSUMHEADER" %s %s\n", comprevision, sizeu1(numregresssums));
+	for (i = 0; i < numregresssums; i++)
+		fprintf(f, "%08x\n", regresssums[i]);
+	fclose(f);
+	return true;
+}
+
+//
+// G_DemoRegressNext
+// Starts the next demo in the list, or reports and quits if there are none left.
+// Called instead of D_StartTitle when a demo has ended.
+//
+boolean G_DemoRegressNext(void)
+{
+	char name[256];
+
+	advancedemo = false;
+
+	if (++curregressdemo >= numregressdemos)
+	{
+		double seconds = (double)I_PreciseToMicros(regresstotaltime) / 1000000.0;
+
+		CONS_Printf(M_GetText("Demo regression: %d demos, %s tics in %f seconds (%f tics/sec), %d failed\n"),
+			numregressdemos, sizeu1((size_t)regresstotaltics), seconds,
+			seconds > 0.0 ? regresstotaltics / seconds : 0.0, numregressfailed);
+		if (numregressfailed)
+			I_Error("Demo regression: %d of %d demos failed", numregressfailed, numregressdemos);
+		I_Quit();
+	}
+
+	strlcpy(name, regressdemos[curregressdemo], sizeof (name));
+	CONS_Printf(M_GetText("Demo regression %d/%d: %s\n"), curregressdemo + 1, numregressdemos, name);
+	numregresssums = 0;
+
+	// Internal if no extension, external if one exists, same as playdemo
+	if (FIL_CheckExtension(name))
+		G_DoPlayDemo(va("%s"PATHSEP"%s", srb2home, name));
+	else
+		G_DoPlayDemo(name);
+
+	if (!demoplayback)
+	{
+		CONS_Alert(CONS_ERROR, M_GetText("%s: couldn't be played\n"), name);
+		numregressfailed++;
+		D_AdvanceDemo();
+	}
+	regressstart = I_GetPreciseTime();
+	return true;
+}
+
+void G_DemoRegressTic(void)
+{
+	if (numregresssums == maxregresssums)
+	{
+		maxregresssums = maxregresssums ? maxregresssums*2 : 4096;
+		regresssums = Z_Realloc(regresssums, maxregresssums * sizeof (*regresssums), PU_STATIC, NULL);
+	}
+	regresssums[numregresssums++] = D_WorldChecksum();
+}
+
+//
+// G_DemoRegressEnd
+// Checks the demo that just ended against its baseline.
+//
+static void G_DemoRegressEnd(void)
+{
+	const char *name = regressdemos[curregressdemo];
+	char basename[256];
+	precise_t time = I_GetPreciseTime() - regressstart;
+	double seconds = (double)I_PreciseToMicros(time) / 1000000.0;
+	UINT32 *base = NULL;
+	size_t numbase = 0, i;
+
+	strlcpy(basename, G_DemoRegressBaseline(name), sizeof (basename));
+	regresstotaltime += time;
+	regresstotaltics += numregresssums;
+
+	CONS_Printf(M_GetText("%s: %s tics in %f seconds, %f tics/sec\n"), name, sizeu1(numregresssums),
+		seconds, seconds > 0.0 ? numregresssums / seconds : 0.0);
+
+	if (!regressrecord)
+		numbase = G_ReadDemoRegressBaseline(basename, &base);
+
+	if (!numbase)
+	{
+		if (G_WriteDemoRegressBaseline(basename))
+			CONS_Printf(M_GetText("%s: baseline written to %s\n"), name, basename);
+		else
+		{
+			CONS_Alert(CONS_ERROR, M_GetText("Couldn't open %s for writing\n"), basename);
+			numregressfailed++;
+		}
+		return;
+	}
+
+	for (i = 0; i < numregresssums && i < numbase; i++)
+		if (regresssums[i] != base[i])
+			break;
+
+	if (i < numregresssums && i < numbase)
+	{
+		CONS_Alert(CONS_ERROR, M_GetText("%s: diverges from baseline at tic %s (%08x, expected %08x)\n"),
+			name, sizeu1(i), regresssums[i], base[i]);
+		numregressfailed++;
+	}
+	else if (numregresssums != numbase)
+	{
+		CONS_Alert(CONS_ERROR, M_GetText("%s: ran for %s tics, baseline has %s\n"),
+			name, sizeu1(numregresssums), sizeu2(numbase));
+		numregressfailed++;
+	}
+	else
+		CONS_Printf(M_GetText("%s: matches baseline\n"), name);
+
+	Z_Free(base);
+}
+
 void G_DoPlayMetal(void)
 {
 	lumpnum_t l;
@@ -5592,7 +6358,7 @@ void G_DoPlayMetal(void)
 		metalbuffer = metal_p = W_CacheLumpNum(l, PU_STATIC);
 
 	// find metal sonic
-	for (th = thinkercap.next; th != &thinkercap; th = th->next)
+	for (th = thlist[THINK_MOBJ].next; th != &thlist[THINK_MOBJ]; th = th->next)
 	{
 		if (th->function.acp1 != (actionf_p1)P_MobjThinker)
 			continue;
@@ -5617,6 +6383,7 @@ void G_DoPlayMetal(void)
 	{
 	case DEMOVERSION: // latest always supported
 	// compatibility available?
+	case 0x0009:
 	case 0x0008:
 		break;
 	// too old, cannot support.
@@ -5647,6 +6414,7 @@ void G_DoneLevelLoad(void)
 	CONS_Printf(M_GetText("Loaded level in %f sec\n"), (double)(I_GetTime() - demostarttime) / TICRATE);
 	framecount = 0;
 	demostarttime = I_GetTime();
+	G_ResetTimeDemoFrames();
 }
 
 /*
@@ -5699,6 +6467,7 @@ ATTRNORETURN void FUNCNORETURN G_StopMetalRecording(void)
 // called from stopdemo command, map command, and g_checkdemoStatus.
 void G_StopDemo(void)
 {
+	G_ClearDemoSnapshots();
 	Z_Free(demobuffer);
 	demobuffer = NULL;
 	demoplayback = false;
@@ -5734,6 +6503,7 @@ boolean G_CheckDemoStatus(void)
 	{
 		INT32 demotime;
 		double f1, f2;
+		boolean quit;
 		demotime = I_GetTime() - demostarttime;
 		if (!demotime)
 			return true;
@@ -5742,14 +6512,27 @@ boolean G_CheckDemoStatus(void)
 		f1 = (double)demotime;
 		f2 = (double)framecount*TICRATE;
 		CONS_Printf(M_GetText("timed %u gametics in %d realtics\n%f seconds, %f avg fps\n"), leveltime,demotime,f1/TICRATE,f2/f1);
+		quit = G_TimeDemoReport();
+		if (P_EndDemoThinkerProfile() || quit)
+			I_Quit(); // -thinkerprof or -timedemojson/-timedemocsv run, nothing more to do
 		if (restorecv_vidwait != cv_vidwait.value)
 			CV_SetValue(&cv_vidwait, restorecv_vidwait);
 		D_AdvanceDemo();
 		return true;
 	}
 
+	if (demoregress && demoplayback)
+	{
+		G_DemoRegressEnd();
+		G_StopDemo();
+		singletics = true;
+		D_AdvanceDemo();
+		return true;
+	}
+
 	if (demoplayback)
 	{
+		P_EndDemoThinkerProfile();
 		if (singledemo)
 			I_Quit();
 		G_StopDemo();
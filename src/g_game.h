@@ -36,7 +36,7 @@ extern boolean playeringame[MAXPLAYERS];
 // ======================================
 
 // demoplaying back and demo recording
-extern boolean demoplayback, titledemo, demorecording, timingdemo;
+extern boolean demoplayback, titledemo, demorecording, timingdemo, demoregress;
 
 // Quit after playing a demo from cmdline.
 extern boolean singledemo;
@@ -56,6 +56,7 @@ extern INT16 rw_maximums[NUM_WEAPONS];
 // used in game menu
 extern consvar_t cv_chatwidth, cv_chatnotifications, cv_chatheight, cv_chattime, cv_consolechat, cv_chatbacktint, cv_chatspamprotection, cv_compactscoreboard;
 extern consvar_t cv_crosshair, cv_crosshair2;
+extern consvar_t cv_demosnapshots;
 extern consvar_t cv_invertmouse, cv_alwaysfreelook, cv_chasefreelook, cv_mousemove;
 extern consvar_t cv_invertmouse2, cv_alwaysfreelook2, cv_chasefreelook2, cv_mousemove2;
 extern consvar_t cv_useranalog, cv_useranalog2;
@@ -155,6 +156,23 @@ void G_LoadMetal(UINT8 **buffer);
 
 void G_DoPlayDemo(char *defdemoname);
 void G_TimeDemo(const char *name);
+
+// Timedemo frame timing: each frame's wall time is split into these.
+typedef enum
+{
+	TDS_TICKER, // G_Ticker
+	TDS_RENDER, // R_RenderPlayerView/HWR_RenderPlayerView
+	TDS_HUD, // everything else drawn: status bar, HUD, console, menu, wipes
+	TDS_PRESENT, // I_FinishUpdate
+	NUMTIMEDEMOSTAGES
+} timedemostage_t;
+
+precise_t G_TimeDemoStage(timedemostage_t stage, precise_t start);
+void G_TimeDemoFrame(precise_t start);
+void G_TimeDemoReportTo(const char *jsonfile, const char *csvfile);
+void G_StartDemoRegress(const char **demos, INT32 numdemos, boolean record);
+boolean G_DemoRegressNext(void);
+void G_DemoRegressTic(void);
 void G_AddGhost(char *defdemoname);
 void G_DoPlayMetal(void);
 void G_DoneLevelLoad(void);
@@ -162,6 +180,7 @@ void G_StopMetalDemo(void);
 ATTRNORETURN void FUNCNORETURN G_StopMetalRecording(void);
 void G_StopDemo(void);
 boolean G_CheckDemoStatus(void);
+void G_DemoSeek(UINT32 tic);
 
 INT32 G_GetGametypeByName(const char *gametypestr);
 boolean G_IsSpecialStage(INT32 mapnum);
@@ -33,7 +33,7 @@
 #include "../r_state.h"     // sides, sectors, sprites, numsides, numsprites
 #include "../r_sky.h"       // skytexture
 #include "../p_setup.h"     // levelflats, numlevelflats
-#include "../p_local.h"     // thinkercap, P_MobjThinker
+#include "../p_local.h"     // thlist, P_MobjThinker
 #include "../command.h"     // consvar_t
 
 #if defined(_NDS)
@@ -685,6 +685,12 @@ void HWR_PrecacheLevel(void)
 	if (skytexture >= 0 && skytexture < numtextures)
 		texturepresent[skytexture] = 1;
 
+	// Have the patches read in the background while the first ones get uploaded.
+	for (j = 0; j < (size_t)numtextures; j++)
+		if (texturepresent[j])
+			for (k = 0; k < (size_t)textures[j]->patchcount; k++)
+				W_PrefetchLumpNumPwad(textures[j]->patches[k].wad, textures[j]->patches[k].lump);
+
 	for (j = 0; j < (size_t)numtextures; j++)
 	{
 		if (!texturepresent[j])
@@ -702,6 +708,8 @@ void HWR_PrecacheLevel(void)
 	// --- Flats ---
 	// levelflats[] only contains flats actually referenced by the level, so
 	// no presence bitmap is needed.
+	for (i = 0; i < numlevelflats; i++)
+		W_PrefetchLumpNum(levelflats[i].lumpnum);
 	for (i = 0; i < numlevelflats; i++)
 	{
 		if (HEADROOM_REACHED())
@@ -720,7 +728,7 @@ void HWR_PrecacheLevel(void)
 		spritepresent = calloc(numsprites, sizeof (*spritepresent));
 		if (spritepresent == NULL)
 			goto done;
-		for (th = thinkercap.next; th != &thinkercap; th = th->next)
+		for (th = thlist[THINK_MOBJ].next; th != &thlist[THINK_MOBJ]; th = th->next)
 			if (th->function.acp1 == (actionf_p1)P_MobjThinker)
 			{
 				size_t s = (size_t)((mobj_t *)th)->sprite;
@@ -728,6 +736,13 @@ void HWR_PrecacheLevel(void)
 					spritepresent[s] = 1;
 			}
 
+		for (i = 0; i < numsprites; i++)
+			if (spritepresent[i])
+				for (j = 0; j < sprites[i].numframes; j++)
+					for (k = 0; k < 8; k++)
+						if (sprites[i].spriteframes[j].lumppat[k] != LUMPERROR)
+							W_PrefetchLumpNum(sprites[i].spriteframes[j].lumppat[k]);
+
 		for (i = 0; i < numsprites; i++)
 		{
 			if (!spritepresent[i])
@@ -4862,94 +4862,54 @@ static inline void HWR_DrawPrecipitationSprite(gr_vissprite_t *spr)
 // --------------------------------------------------------------------------
 static gr_vissprite_t gr_vsprsortedhead;
 
+// Maps a float onto a UINT32 that orders the same way when compared unsigned.
+static inline UINT32 HWR_FloatSortBits(float f)
+{
+	union { float f; UINT32 u; } v;
+	v.f = f + 0.0f; // -0 and +0 are the same distance
+	return (v.u & 0x80000000) ? ~v.u : (v.u | 0x80000000);
+}
+
 static void HWR_SortVisSprites(void)
 {
 	UINT32 i;
-	gr_vissprite_t *ds, *dsprev, *dsnext, *dsfirst;
-	gr_vissprite_t *best = NULL;
-	gr_vissprite_t unsorted;
-	float bestdist = 0.0f;
-	INT32 bestdispoffset = 0;
+	gr_vissprite_t *ds;
+	vsprsortkey_t *keys;
+	const vsprsortkey_t *sorted;
+	precise_t start;
 
 	if (!gr_visspritecount)
 		return;
 
-	dsfirst = HWR_GetVisSprite(0);
+	start = I_GetPreciseTime();
 
-	for (i = 0, dsnext = dsfirst, ds = NULL; i < gr_visspritecount; i++)
+	// Farthest first, and of the same distance, smallest dispoffset first.
+	// Sryder:	Oh boy, while it's nice having ALL the sprites sorted properly, it fails when we bring MD2's into the
+	//			mix and they want to be translucent. So let's place all the translucent sprites and MD2's AFTER
+	//			everything else, but still ordered of course, the depth buffer can handle the opaque ones plenty fine.
+	// TODO:	Fully sort all sprites and MD2s with walls and floors, this part will be unnecessary after that
+	keys = R_GetVisSpriteSortKeys(gr_visspritecount);
+	for (i = 0; i < gr_visspritecount; i++)
 	{
-		dsprev = ds;
-		ds = dsnext;
-		if (i < gr_visspritecount - 1) dsnext = HWR_GetVisSprite(i + 1);
-
-		ds->next = dsnext;
-		ds->prev = dsprev;
+		ds = HWR_GetVisSprite(i);
+		keys[i].key = ((UINT64)~HWR_FloatSortBits(ds->tz) << 32)
+			| ((UINT32)ds->dispoffset ^ 0x80000000);
+		keys[i].group = ((ds->mobj->flags2 & MF2_SHADOW) || (ds->mobj->frame & FF_TRANSMASK)) ? 1 : 0;
+		keys[i].sprite = ds;
 	}
+	sorted = R_SortVisSpriteKeys(keys, gr_visspritecount);
 
-	// Fix first and last. ds still points to the last one after the loop
-	dsfirst->prev = &unsorted;
-	unsorted.next = dsfirst;
-	if (ds)
-		ds->next = &unsorted;
-	unsorted.prev = ds;
-
-	// pull the vissprites out by scale
 	gr_vsprsortedhead.next = gr_vsprsortedhead.prev = &gr_vsprsortedhead;
 	for (i = 0; i < gr_visspritecount; i++)
 	{
-		best = NULL;
-		for (ds = unsorted.next; ds != &unsorted; ds = ds->next)
-		{
-			if (!best || ds->tz > bestdist)
-			{
-				bestdist = ds->tz;
-				bestdispoffset = ds->dispoffset;
-				best = ds;
-			}
-			// order visprites of same scale by dispoffset, smallest first
-			else if (ds->tz == bestdist && ds->dispoffset < bestdispoffset)
-			{
-				bestdispoffset = ds->dispoffset;
-				best = ds;
-			}
-		}
-		if (best)
-		{
-			best->next->prev = best->prev;
-			best->prev->next = best->next;
-			best->next = &gr_vsprsortedhead;
-			best->prev = gr_vsprsortedhead.prev;
-		}
-		gr_vsprsortedhead.prev->next = best;
-		gr_vsprsortedhead.prev = best;
+		ds = sorted[i].sprite;
+		ds->next = &gr_vsprsortedhead;
+		ds->prev = gr_vsprsortedhead.prev;
+		gr_vsprsortedhead.prev->next = ds;
+		gr_vsprsortedhead.prev = ds;
 	}
 
-	// Sryder:	Oh boy, while it's nice having ALL the sprites sorted properly, it fails when we bring MD2's into the
-	//			mix and they want to be translucent. So let's place all the translucent sprites and MD2's AFTER
-	//			everything else, but still ordered of course, the depth buffer can handle the opaque ones plenty fine.
-	//			We just need to move all translucent ones to the end in order
-	// TODO:	Fully sort all sprites and MD2s with walls and floors, this part will be unnecessary after that
-	best = gr_vsprsortedhead.next;
-	for (i = 0; i < gr_visspritecount; i++)
-	{
-		if ((best->mobj->flags2 & MF2_SHADOW) || (best->mobj->frame & FF_TRANSMASK))
-		{
-			if (best == gr_vsprsortedhead.next)
-			{
-				gr_vsprsortedhead.next = best->next;
-			}
-			best->prev->next = best->next;
-			best->next->prev = best->prev;
-			best->prev = gr_vsprsortedhead.prev;
-			gr_vsprsortedhead.prev->next = best;
-			gr_vsprsortedhead.prev = best;
-			ds = best;
-			best = best->next;
-			ds->next = &gr_vsprsortedhead;
-		}
-		else
-			best = best->next;
-	}
+	R_CountVisSpriteSort(start, gr_visspritecount);
 }
 
 // A drawnode is something that points to a 3D floor, 3D side, or masked
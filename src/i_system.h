@@ -46,6 +46,15 @@ UINT32 I_GetFreeMem(UINT32 *total);
 */
 tic_t I_GetTime(void);
 
+/**	\brief	Returns a high-resolution timestamp, for profiling.
+	Only the difference between two of them means anything.
+*/
+precise_t I_GetPreciseTime(void);
+
+/**	\brief	Converts a difference of I_GetPreciseTime values to microseconds.
+*/
+UINT64 I_PreciseToMicros(precise_t d);
+
 /**	\brief	The I_Sleep function
 
 	\return	void
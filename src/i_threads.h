@@ -0,0 +1,49 @@
+// SONIC ROBO BLAST 2
+//-----------------------------------------------------------------------------
+// Copyright (C) 1999-2018 by Sonic Team Junior.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  i_threads.h
+/// \brief Multithreading abstraction
+
+#ifdef HAVE_THREADS
+
+#ifndef __I_THREADS__
+#define __I_THREADS__
+
+typedef void (*I_thread_fn)(void *userdata);
+
+typedef void *I_mutex;
+typedef void *I_cond;
+
+/**	\brief	Starts a detached thread running entry(userdata)
+
+	\param	name	thread name, for debugging only
+	\param	entry	function the thread runs, the thread ends when it returns
+	\param	userdata	passed to entry
+
+	\return	true if the thread was started
+*/
+boolean I_SpawnThread(const char *name, I_thread_fn entry, void *userdata);
+
+I_mutex I_CreateMutex(void);
+void I_DestroyMutex(I_mutex id);
+void I_LockMutex(I_mutex id);
+void I_UnlockMutex(I_mutex id);
+
+I_cond I_CreateCond(void);
+void I_DestroyCond(I_cond cond);
+
+/**	\brief	Waits on a condition, the mutex must be locked by the caller
+	and is locked again on return
+*/
+void I_HoldCond(I_cond cond, I_mutex mutex);
+void I_WakeOneCond(I_cond cond);
+void I_WakeAllCond(I_cond cond);
+
+#endif/*__I_THREADS__*/
+
+#endif/*HAVE_THREADS*/
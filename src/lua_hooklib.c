@@ -18,6 +18,8 @@
 #include "r_things.h"
 #include "b_bot.h"
 #include "z_zone.h"
+#include "i_system.h" // I_GetPreciseTime
+#include "dehacked.h" // DEH_MobjTypeName
 
 #include "lua_script.h"
 #include "lua_libs.h"
@@ -63,17 +65,25 @@ struct hook_s
 {
 	struct hook_s *next;
 	enum hook type;
-	UINT16 id;
+	int ref; // the hook function, as a registry reference
 	union {
 		mobjtype_t mt;
 		char *skinname;
 		char *funcname;
 	} s;
 	boolean error;
+
+	// For the Lua profiler
+	struct hook_s *nextall; // every hook, in the order they were added
+	UINT16 id;
+	char *where; // "file:line" the function was defined at
+	UINT64 calls;
+	precise_t time;
 };
 typedef struct hook_s* hook_p;
 
-#define FMT_HOOKID "hook_%d"
+// Push a hook's function onto the stack.
+#define PushHook(L, hookp) lua_rawgeti(L, LUA_REGISTRYINDEX, (hookp)->ref)
 
 // For each mobj type, a linked list to its thinker and collision hooks.
 // That way, we don't have to iterate through all the hooks.
@@ -85,6 +95,12 @@ static hook_p mobjcollidehooks[NUMMOBJTYPES];
 // For each mobj type, a linked list for other mobj hooks
 static hook_p mobjhooks[NUMMOBJTYPES];
 
+// For each mobj type, a bit per hook type it has hooks for, so that mobjs
+// nobody hooked never reach Lua. MT_NULL holds the generic hooks.
+// (hook_MAX has to stay below 32 for this.)
+static UINT32 mobjhookmask[NUMMOBJTYPES];
+#define MobjHooked(mt, which) ((mobjhookmask[MT_NULL] | mobjhookmask[mt]) & (1<<(which)))
+
 // A linked list for player hooks
 static hook_p playerhooks;
 
@@ -94,11 +110,107 @@ static hook_p linedefexecutorhooks;
 // For other hooks, a unique linked list
 hook_p roothook;
 
+// All of the above, through nextall
+static hook_p allhooks;
+static hook_p *lastallhook = &allhooks;
+static UINT16 numhooks;
+
+// Lua profiler, see Command_Luaprofile_f.
+// Hooks are timed per call; everything else the VM runs is sampled every
+// PROFILE_SAMPLERATE instructions and attributed to the running function
+// and line.
+static boolean luaprofiling = false;
+static precise_t luaprofilestart, luaprofiletime; // wall time spent profiling
+static UINT64 hooktypecalls[hook_MAX];
+static precise_t hooktypetime[hook_MAX];
+
+#define PROFILE_SAMPLERATE 1000
+#define MAXPROFILESPOTS 1024 // power of two
+
+typedef struct
+{
+	char source[LUA_IDSIZE];
+	int line; // linedefined for functions, currentline for lines
+	boolean isline;
+	UINT32 samples;
+} luaprofilespot_t;
+
+static luaprofilespot_t *profilespots = NULL;
+static size_t numprofilespots;
+static UINT32 profilesamples, profiledropped;
+
+static void LUA_CountProfileSample(const char *source, int line, boolean isline)
+{
+	UINT32 h = (UINT32)line * 31 + isline;
+	const char *c;
+	size_t i;
+
+	for (c = source; *c; c++)
+		h = h * 31 + (UINT8)*c;
+
+	for (i = h & (MAXPROFILESPOTS-1); profilespots[i].samples; i = (i + 1) & (MAXPROFILESPOTS-1))
+		if (profilespots[i].line == line && profilespots[i].isline == isline
+		&& !strcmp(profilespots[i].source, source))
+		{
+			profilespots[i].samples++;
+			return;
+		}
+
+	if (numprofilespots >= MAXPROFILESPOTS*3/4)
+	{
+		profiledropped++;
+		return;
+	}
+	strlcpy(profilespots[i].source, source, LUA_IDSIZE);
+	profilespots[i].line = line;
+	profilespots[i].isline = isline;
+	profilespots[i].samples = 1;
+	numprofilespots++;
+}
+
+// lua_Hook for LUA_MASKCOUNT
+static void LUA_ProfileSample(lua_State *L, lua_Debug *ar)
+{
+	if (!profilespots || !lua_getinfo(L, "Sl", ar))
+		return;
+	profilesamples++;
+	LUA_CountProfileSample(ar->short_src, ar->linedefined, false);
+	if (ar->currentline > 0)
+		LUA_CountProfileSample(ar->short_src, ar->currentline, true);
+}
+
+// lua_pcall for hooks, timed while profiling.
+static int CallHook(hook_p hookp, int nargs, int nresults)
+{
+	precise_t t;
+	int err;
+
+	if (!luaprofiling)
+		return lua_pcall(gL, nargs, nresults, 0);
+
+	t = I_GetPreciseTime();
+	err = lua_pcall(gL, nargs, nresults, 0);
+	t = I_GetPreciseTime() - t;
+	hookp->calls++;
+	hookp->time += t;
+	hooktypecalls[hookp->type]++;
+	hooktypetime[hookp->type] += t;
+	return err;
+}
+
+// LUA_Call for hooks
+#define LUA_CallHook(hookp, a)\
+{\
+	if (CallHook(hookp, a, 0)) {\
+		CONS_Alert(CONS_WARNING,"%s\n",lua_tostring(gL,-1));\
+		lua_pop(gL, 1);\
+	}\
+}
+
 // Takes hook, function, and additional arguments (mobj type to act on, etc.)
 static int lib_addHook(lua_State *L)
 {
-	static struct hook_s hook = {NULL, 0, 0, {0}, false};
-	static UINT32 nextid;
+	static struct hook_s hook = {NULL, 0, LUA_NOREF, {0}, false, NULL, 0, NULL, 0, 0};
 	hook_p hookp, *lastp;
 
 	hook.type = luaL_checkoption(L, 1, NULL, hookNames);
@@ -159,20 +271,31 @@ static int lib_addHook(lua_State *L)
 	}
 	lua_settop(L, 1); // lua stack contains only the function now.
 
+	{ // remember where it came from, for the profiler
+		lua_Debug ar;
+		lua_pushvalue(L, 1);
+		lua_getinfo(L, ">S", &ar);
+		hook.where = ZZ_Alloc(strlen(ar.short_src) + 12);
+		sprintf(hook.where, "%s:%d", ar.short_src, ar.linedefined);
+	}
+	hook.id = numhooks++;
+
 	hooksAvailable[hook.type/8] |= 1<<(hook.type%8);
 
-	// set hook.id to the highest id + 1
-	hook.id = nextid++;
+	// keep the function in the registry, and just its reference in the hook
+	hook.ref = luaL_ref(L, LUA_REGISTRYINDEX);
 
 	// Special cases for some hook types (see the comments above mobjthinkerhooks declaration)
 	switch(hook.type)
 	{
 	case hook_MobjThinker:
 		lastp = &mobjthinkerhooks[hook.s.mt];
+		mobjhookmask[hook.s.mt] |= 1<<hook.type;
 		break;
 	case hook_MobjCollide:
 	case hook_MobjMoveCollide:
 		lastp = &mobjcollidehooks[hook.s.mt];
+		mobjhookmask[hook.s.mt] |= 1<<hook.type;
 		break;
 	case hook_MobjSpawn:
 	case hook_TouchSpecial:
@@ -184,6 +307,7 @@ static int lib_addHook(lua_State *L)
 	case hook_BossDeath:
 	case hook_MobjRemoved:
 		lastp = &mobjhooks[hook.s.mt];
+		mobjhookmask[hook.s.mt] |= 1<<hook.type;
 		break;
 	case hook_JumpSpecial:
 	case hook_AbilitySpecial:
@@ -209,18 +333,22 @@ static int lib_addHook(lua_State *L)
 	memcpy(hookp, &hook, sizeof(struct hook_s));
 	// tack it onto the end of the linked list.
 	*lastp = hookp;
+	*lastallhook = hookp;
+	lastallhook = &hookp->nextall;
 
-	// set the hook function in the registry.
-	lua_pushfstring(L, FMT_HOOKID, hook.id);
-	lua_pushvalue(L, 1);
-	lua_settable(L, LUA_REGISTRYINDEX);
 	return 0;
 }
 
 int LUA_HookLib(lua_State *L)
 {
 	memset(hooksAvailable,0,sizeof(UINT8[(hook_MAX/8)+1]));
+	memset(mobjhookmask,0,sizeof(mobjhookmask));
 	roothook = NULL;
+	allhooks = NULL;
+	lastallhook = &allhooks;
+	numhooks = 0;
+	if (luaprofiling)
+		lua_sethook(L, LUA_ProfileSample, LUA_MASKCOUNT, PROFILE_SAMPLERATE);
 	lua_register(L, "addHook", lib_addHook);
 	return 0;
 }
@@ -234,6 +362,9 @@ boolean LUAh_MobjHook(mobj_t *mo, enum hook which)
 
 	I_Assert(mo->type < NUMMOBJTYPES);
 
+	if (!MobjHooked(mo->type, which))
+		return false;
+
 	lua_settop(gL, 0);
 
 	// Look for all generic mobj hooks
@@ -242,10 +373,9 @@ boolean LUAh_MobjHook(mobj_t *mo, enum hook which)
 		{
 			if (lua_gettop(gL) == 0)
 				LUA_PushUserdata(gL, mo, META_MOBJ);
-			lua_pushfstring(gL, FMT_HOOKID, hookp->id);
-			lua_gettable(gL, LUA_REGISTRYINDEX);
+			PushHook(gL, hookp);
 			lua_pushvalue(gL, -2);
-			if (lua_pcall(gL, 1, 1, 0)) {
+			if (CallHook(hookp, 1, 1)) {
 				if (!hookp->error || cv_debug & DBG_LUA)
 					CONS_Alert(CONS_WARNING,"%s\n",lua_tostring(gL, -1));
 				lua_pop(gL, 1);
@@ -262,10 +392,9 @@ boolean LUAh_MobjHook(mobj_t *mo, enum hook which)
 		{
 			if (lua_gettop(gL) == 0)
 				LUA_PushUserdata(gL, mo, META_MOBJ);
-			lua_pushfstring(gL, FMT_HOOKID, hookp->id);
-			lua_gettable(gL, LUA_REGISTRYINDEX);
+			PushHook(gL, hookp);
 			lua_pushvalue(gL, -2);
-			if (lua_pcall(gL, 1, 1, 0)) {
+			if (CallHook(hookp, 1, 1)) {
 				if (!hookp->error || cv_debug & DBG_LUA)
 					CONS_Alert(CONS_WARNING,"%s\n",lua_tostring(gL, -1));
 				lua_pop(gL, 1);
@@ -295,10 +424,9 @@ boolean LUAh_PlayerHook(player_t *plr, enum hook which)
 		{
 			if (lua_gettop(gL) == 0)
 				LUA_PushUserdata(gL, plr, META_PLAYER);
-			lua_pushfstring(gL, FMT_HOOKID, hookp->id);
-			lua_gettable(gL, LUA_REGISTRYINDEX);
+			PushHook(gL, hookp);
 			lua_pushvalue(gL, -2);
-			if (lua_pcall(gL, 1, 1, 0)) {
+			if (CallHook(hookp, 1, 1)) {
 				if (!hookp->error || cv_debug & DBG_LUA)
 					CONS_Alert(CONS_WARNING,"%s\n",lua_tostring(gL, -1));
 				lua_pop(gL, 1);
@@ -327,10 +455,9 @@ void LUAh_MapChange(INT16 mapnumber)
 	for (hookp = roothook; hookp; hookp = hookp->next)
 		if (hookp->type == hook_MapChange)
 		{
-			lua_pushfstring(gL, FMT_HOOKID, hookp->id);
-			lua_gettable(gL, LUA_REGISTRYINDEX);
+			PushHook(gL, hookp);
 			lua_pushvalue(gL, -2);
-			LUA_Call(gL, 1);
+			LUA_CallHook(hookp, 1);
 		}
 
 	lua_settop(gL, 0);
@@ -349,10 +476,9 @@ void LUAh_MapLoad(void)
 	for (hookp = roothook; hookp; hookp = hookp->next)
 		if (hookp->type == hook_MapLoad)
 		{
-			lua_pushfstring(gL, FMT_HOOKID, hookp->id);
-			lua_gettable(gL, LUA_REGISTRYINDEX);
+			PushHook(gL, hookp);
 			lua_pushvalue(gL, -2);
-			LUA_Call(gL, 1);
+			LUA_CallHook(hookp, 1);
 		}
 
 	lua_settop(gL, 0);
@@ -371,10 +497,9 @@ void LUAh_PlayerJoin(int playernum)
 	for (hookp = roothook; hookp; hookp = hookp->next)
 		if (hookp->type == hook_PlayerJoin)
 		{
-			lua_pushfstring(gL, FMT_HOOKID, hookp->id);
-			lua_gettable(gL, LUA_REGISTRYINDEX);
+			PushHook(gL, hookp);
 			lua_pushvalue(gL, -2);
-			LUA_Call(gL, 1);
+			LUA_CallHook(hookp, 1);
 		}
 
 	lua_settop(gL, 0);
@@ -390,9 +515,8 @@ void LUAh_ThinkFrame(void)
 	for (hookp = roothook; hookp; hookp = hookp->next)
 		if (hookp->type == hook_ThinkFrame)
 		{
-			lua_pushfstring(gL, FMT_HOOKID, hookp->id);
-			lua_gettable(gL, LUA_REGISTRYINDEX);
-			if (lua_pcall(gL, 0, 0, 0)) {
+			PushHook(gL, hookp);
+			if (CallHook(hookp, 0, 0)) {
 				if (!hookp->error || cv_debug & DBG_LUA)
 					CONS_Alert(CONS_WARNING,"%s\n",lua_tostring(gL, -1));
 				lua_pop(gL, 1);
@@ -411,6 +535,9 @@ UINT8 LUAh_MobjCollideHook(mobj_t *thing1, mobj_t *thing2, enum hook which)
 
 	I_Assert(thing1->type < NUMMOBJTYPES);
 
+	if (!MobjHooked(thing1->type, which))
+		return 0;
+
 	lua_settop(gL, 0);
 
 	// Look for all generic mobj collision hooks
@@ -422,11 +549,10 @@ UINT8 LUAh_MobjCollideHook(mobj_t *thing1, mobj_t *thing2, enum hook which)
 				LUA_PushUserdata(gL, thing1, META_MOBJ);
 				LUA_PushUserdata(gL, thing2, META_MOBJ);
 			}
-			lua_pushfstring(gL, FMT_HOOKID, hookp->id);
-			lua_gettable(gL, LUA_REGISTRYINDEX);
+			PushHook(gL, hookp);
 			lua_pushvalue(gL, -3);
 			lua_pushvalue(gL, -3);
-			if (lua_pcall(gL, 2, 1, 0)) {
+			if (CallHook(hookp, 2, 1)) {
 				if (!hookp->error || cv_debug & DBG_LUA)
 					CONS_Alert(CONS_WARNING,"%s\n",lua_tostring(gL, -1));
 				lua_pop(gL, 1);
@@ -451,11 +577,10 @@ UINT8 LUAh_MobjCollideHook(mobj_t *thing1, mobj_t *thing2, enum hook which)
 				LUA_PushUserdata(gL, thing1, META_MOBJ);
 				LUA_PushUserdata(gL, thing2, META_MOBJ);
 			}
-			lua_pushfstring(gL, FMT_HOOKID, hookp->id);
-			lua_gettable(gL, LUA_REGISTRYINDEX);
+			PushHook(gL, hookp);
 			lua_pushvalue(gL, -3);
 			lua_pushvalue(gL, -3);
-			if (lua_pcall(gL, 2, 1, 0)) {
+			if (CallHook(hookp, 2, 1)) {
 				if (!hookp->error || cv_debug & DBG_LUA)
 					CONS_Alert(CONS_WARNING,"%s\n",lua_tostring(gL, -1));
 				lua_pop(gL, 1);
@@ -486,6 +611,9 @@ boolean LUAh_MobjThinker(mobj_t *mo)
 
 	I_Assert(mo->type < NUMMOBJTYPES);
 
+	if (!MobjHooked(mo->type, hook_MobjThinker))
+		return false;
+
 	lua_settop(gL, 0);
 
 	// Look for all generic mobj thinker hooks
@@ -493,10 +621,9 @@ boolean LUAh_MobjThinker(mobj_t *mo)
 	{
 		if (lua_gettop(gL) == 0)
 			LUA_PushUserdata(gL, mo, META_MOBJ);
-		lua_pushfstring(gL, FMT_HOOKID, hookp->id);
-		lua_gettable(gL, LUA_REGISTRYINDEX);
+		PushHook(gL, hookp);
 		lua_pushvalue(gL, -2);
-		if (lua_pcall(gL, 1, 1, 0)) {
+		if (CallHook(hookp, 1, 1)) {
 			if (!hookp->error || cv_debug & DBG_LUA)
 				CONS_Alert(CONS_WARNING,"%s\n",lua_tostring(gL, -1));
 			lua_pop(gL, 1);
@@ -512,10 +639,9 @@ boolean LUAh_MobjThinker(mobj_t *mo)
 	{
 		if (lua_gettop(gL) == 0)
 			LUA_PushUserdata(gL, mo, META_MOBJ);
-		lua_pushfstring(gL, FMT_HOOKID, hookp->id);
-		lua_gettable(gL, LUA_REGISTRYINDEX);
+		PushHook(gL, hookp);
 		lua_pushvalue(gL, -2);
-		if (lua_pcall(gL, 1, 1, 0)) {
+		if (CallHook(hookp, 1, 1)) {
 			if (!hookp->error || cv_debug & DBG_LUA)
 				CONS_Alert(CONS_WARNING,"%s\n",lua_tostring(gL, -1));
 			lua_pop(gL, 1);
@@ -541,6 +667,9 @@ boolean LUAh_TouchSpecial(mobj_t *special, mobj_t *toucher)
 
 	I_Assert(special->type < NUMMOBJTYPES);
 
+	if (!MobjHooked(special->type, hook_TouchSpecial))
+		return 0;
+
 	lua_settop(gL, 0);
 
 	// Look for all generic touch special hooks
@@ -552,11 +681,10 @@ boolean LUAh_TouchSpecial(mobj_t *special, mobj_t *toucher)
 				LUA_PushUserdata(gL, special, META_MOBJ);
 				LUA_PushUserdata(gL, toucher, META_MOBJ);
 			}
-			lua_pushfstring(gL, FMT_HOOKID, hookp->id);
-			lua_gettable(gL, LUA_REGISTRYINDEX);
+			PushHook(gL, hookp);
 			lua_pushvalue(gL, -3);
 			lua_pushvalue(gL, -3);
-			if (lua_pcall(gL, 2, 1, 0)) {
+			if (CallHook(hookp, 2, 1)) {
 				if (!hookp->error || cv_debug & DBG_LUA)
 					CONS_Alert(CONS_WARNING,"%s\n",lua_tostring(gL, -1));
 				lua_pop(gL, 1);
@@ -576,11 +704,10 @@ boolean LUAh_TouchSpecial(mobj_t *special, mobj_t *toucher)
 				LUA_PushUserdata(gL, special, META_MOBJ);
 				LUA_PushUserdata(gL, toucher, META_MOBJ);
 			}
-			lua_pushfstring(gL, FMT_HOOKID, hookp->id);
-			lua_gettable(gL, LUA_REGISTRYINDEX);
+			PushHook(gL, hookp);
 			lua_pushvalue(gL, -3);
 			lua_pushvalue(gL, -3);
-			if (lua_pcall(gL, 2, 1, 0)) {
+			if (CallHook(hookp, 2, 1)) {
 				if (!hookp->error || cv_debug & DBG_LUA)
 					CONS_Alert(CONS_WARNING,"%s\n",lua_tostring(gL, -1));
 				lua_pop(gL, 1);
@@ -606,6 +733,9 @@ UINT8 LUAh_ShouldDamage(mobj_t *target, mobj_t *inflictor, mobj_t *source, INT32
 
 	I_Assert(target->type < NUMMOBJTYPES);
 
+	if (!MobjHooked(target->type, hook_ShouldDamage))
+		return 0;
+
 	lua_settop(gL, 0);
 
 	// Look for all generic should damage hooks
@@ -619,13 +749,12 @@ UINT8 LUAh_ShouldDamage(mobj_t *target, mobj_t *inflictor, mobj_t *source, INT32
 				LUA_PushUserdata(gL, source, META_MOBJ);
 				lua_pushinteger(gL, damage);
 			}
-			lua_pushfstring(gL, FMT_HOOKID, hookp->id);
-			lua_gettable(gL, LUA_REGISTRYINDEX);
+			PushHook(gL, hookp);
 			lua_pushvalue(gL, -5);
 			lua_pushvalue(gL, -5);
 			lua_pushvalue(gL, -5);
 			lua_pushvalue(gL, -5);
-			if (lua_pcall(gL, 4, 1, 0)) {
+			if (CallHook(hookp, 4, 1)) {
 				if (!hookp->error || cv_debug & DBG_LUA)
 					CONS_Alert(CONS_WARNING,"%s\n",lua_tostring(gL, -1));
 				lua_pop(gL, 1);
@@ -652,13 +781,12 @@ UINT8 LUAh_ShouldDamage(mobj_t *target, mobj_t *inflictor, mobj_t *source, INT32
 				LUA_PushUserdata(gL, source, META_MOBJ);
 				lua_pushinteger(gL, damage);
 			}
-			lua_pushfstring(gL, FMT_HOOKID, hookp->id);
-			lua_gettable(gL, LUA_REGISTRYINDEX);
+			PushHook(gL, hookp);
 			lua_pushvalue(gL, -5);
 			lua_pushvalue(gL, -5);
 			lua_pushvalue(gL, -5);
 			lua_pushvalue(gL, -5);
-			if (lua_pcall(gL, 4, 1, 0)) {
+			if (CallHook(hookp, 4, 1)) {
 				if (!hookp->error || cv_debug & DBG_LUA)
 					CONS_Alert(CONS_WARNING,"%s\n",lua_tostring(gL, -1));
 				lua_pop(gL, 1);
@@ -689,6 +817,9 @@ boolean LUAh_MobjDamage(mobj_t *target, mobj_t *inflictor, mobj_t *source, INT32
 
 	I_Assert(target->type < NUMMOBJTYPES);
 
+	if (!MobjHooked(target->type, hook_MobjDamage))
+		return 0;
+
 	lua_settop(gL, 0);
 
 	// Look for all generic mobj damage hooks
@@ -702,13 +833,12 @@ boolean LUAh_MobjDamage(mobj_t *target, mobj_t *inflictor, mobj_t *source, INT32
 				LUA_PushUserdata(gL, source, META_MOBJ);
 				lua_pushinteger(gL, damage);
 			}
-			lua_pushfstring(gL, FMT_HOOKID, hookp->id);
-			lua_gettable(gL, LUA_REGISTRYINDEX);
+			PushHook(gL, hookp);
 			lua_pushvalue(gL, -5);
 			lua_pushvalue(gL, -5);
 			lua_pushvalue(gL, -5);
 			lua_pushvalue(gL, -5);
-			if (lua_pcall(gL, 4, 1, 0)) {
+			if (CallHook(hookp, 4, 1)) {
 				if (!hookp->error || cv_debug & DBG_LUA)
 					CONS_Alert(CONS_WARNING,"%s\n",lua_tostring(gL, -1));
 				lua_pop(gL, 1);
@@ -730,13 +860,12 @@ boolean LUAh_MobjDamage(mobj_t *target, mobj_t *inflictor, mobj_t *source, INT32
 				LUA_PushUserdata(gL, source, META_MOBJ);
 				lua_pushinteger(gL, damage);
 			}
-			lua_pushfstring(gL, FMT_HOOKID, hookp->id);
-			lua_gettable(gL, LUA_REGISTRYINDEX);
+			PushHook(gL, hookp);
 			lua_pushvalue(gL, -5);
 			lua_pushvalue(gL, -5);
 			lua_pushvalue(gL, -5);
 			lua_pushvalue(gL, -5);
-			if (lua_pcall(gL, 4, 1, 0)) {
+			if (CallHook(hookp, 4, 1)) {
 				if (!hookp->error || cv_debug & DBG_LUA)
 					CONS_Alert(CONS_WARNING,"%s\n",lua_tostring(gL, -1));
 				lua_pop(gL, 1);
@@ -762,6 +891,9 @@ boolean LUAh_MobjDeath(mobj_t *target, mobj_t *inflictor, mobj_t *source)
 
 	I_Assert(target->type < NUMMOBJTYPES);
 
+	if (!MobjHooked(target->type, hook_MobjDeath))
+		return 0;
+
 	lua_settop(gL, 0);
 
 	// Look for all generic mobj death hooks
@@ -774,12 +906,11 @@ boolean LUAh_MobjDeath(mobj_t *target, mobj_t *inflictor, mobj_t *source)
 				LUA_PushUserdata(gL, inflictor, META_MOBJ);
 				LUA_PushUserdata(gL, source, META_MOBJ);
 			}
-			lua_pushfstring(gL, FMT_HOOKID, hookp->id);
-			lua_gettable(gL, LUA_REGISTRYINDEX);
+			PushHook(gL, hookp);
 			lua_pushvalue(gL, -4);
 			lua_pushvalue(gL, -4);
 			lua_pushvalue(gL, -4);
-			if (lua_pcall(gL, 3, 1, 0)) {
+			if (CallHook(hookp, 3, 1)) {
 				if (!hookp->error || cv_debug & DBG_LUA)
 					CONS_Alert(CONS_WARNING,"%s\n",lua_tostring(gL, -1));
 				lua_pop(gL, 1);
@@ -800,12 +931,11 @@ boolean LUAh_MobjDeath(mobj_t *target, mobj_t *inflictor, mobj_t *source)
 				LUA_PushUserdata(gL, inflictor, META_MOBJ);
 				LUA_PushUserdata(gL, source, META_MOBJ);
 			}
-			lua_pushfstring(gL, FMT_HOOKID, hookp->id);
-			lua_gettable(gL, LUA_REGISTRYINDEX);
+			PushHook(gL, hookp);
 			lua_pushvalue(gL, -4);
 			lua_pushvalue(gL, -4);
 			lua_pushvalue(gL, -4);
-			if (lua_pcall(gL, 3, 1, 0)) {
+			if (CallHook(hookp, 3, 1)) {
 				if (!hookp->error || cv_debug & DBG_LUA)
 					CONS_Alert(CONS_WARNING,"%s\n",lua_tostring(gL, -1));
 				lua_pop(gL, 1);
@@ -839,11 +969,10 @@ boolean LUAh_BotTiccmd(player_t *bot, ticcmd_t *cmd)
 				LUA_PushUserdata(gL, bot, META_PLAYER);
 				LUA_PushUserdata(gL, cmd, META_TICCMD);
 			}
-			lua_pushfstring(gL, FMT_HOOKID, hookp->id);
-			lua_gettable(gL, LUA_REGISTRYINDEX);
+			PushHook(gL, hookp);
 			lua_pushvalue(gL, -3);
 			lua_pushvalue(gL, -3);
-			if (lua_pcall(gL, 2, 1, 0)) {
+			if (CallHook(hookp, 2, 1)) {
 				if (!hookp->error || cv_debug & DBG_LUA)
 					CONS_Alert(CONS_WARNING,"%s\n",lua_tostring(gL, -1));
 				lua_pop(gL, 1);
@@ -878,11 +1007,10 @@ boolean LUAh_BotAI(mobj_t *sonic, mobj_t *tails, ticcmd_t *cmd)
 				LUA_PushUserdata(gL, sonic, META_MOBJ);
 				LUA_PushUserdata(gL, tails, META_MOBJ);
 			}
-			lua_pushfstring(gL, FMT_HOOKID, hookp->id);
-			lua_gettable(gL, LUA_REGISTRYINDEX);
+			PushHook(gL, hookp);
 			lua_pushvalue(gL, -3);
 			lua_pushvalue(gL, -3);
-			if (lua_pcall(gL, 2, 8, 0)) {
+			if (CallHook(hookp, 2, 8)) {
 				if (!hookp->error || cv_debug & DBG_LUA)
 					CONS_Alert(CONS_WARNING,"%s\n",lua_tostring(gL, -1));
 				lua_pop(gL, 1);
@@ -939,12 +1067,11 @@ boolean LUAh_LinedefExecute(line_t *line, mobj_t *mo, sector_t *sector)
 				LUA_PushUserdata(gL, mo, META_MOBJ);
 				LUA_PushUserdata(gL, sector, META_SECTOR);
 			}
-			lua_pushfstring(gL, FMT_HOOKID, hookp->id);
-			lua_gettable(gL, LUA_REGISTRYINDEX);
+			PushHook(gL, hookp);
 			lua_pushvalue(gL, -4);
 			lua_pushvalue(gL, -4);
 			lua_pushvalue(gL, -4);
-			LUA_Call(gL, 3);
+			LUA_CallHook(hookp, 3);
 			hooked = true;
 		}
 
@@ -983,13 +1110,12 @@ boolean LUAh_PlayerMsg(int source, int target, int flags, char *msg)
 				}
 				lua_pushstring(gL, msg); // msg
 			}
-			lua_pushfstring(gL, FMT_HOOKID, hookp->id);
-			lua_gettable(gL, LUA_REGISTRYINDEX);
+			PushHook(gL, hookp);
 			lua_pushvalue(gL, -5);
 			lua_pushvalue(gL, -5);
 			lua_pushvalue(gL, -5);
 			lua_pushvalue(gL, -5);
-			if (lua_pcall(gL, 4, 1, 0)) {
+			if (CallHook(hookp, 4, 1)) {
 				if (!hookp->error || cv_debug & DBG_LUA)
 					CONS_Alert(CONS_WARNING,"%s\n",lua_tostring(gL, -1));
 				lua_pop(gL, 1);
@@ -1026,12 +1152,11 @@ boolean LUAh_HurtMsg(player_t *player, mobj_t *inflictor, mobj_t *source)
 				LUA_PushUserdata(gL, inflictor, META_MOBJ);
 				LUA_PushUserdata(gL, source, META_MOBJ);
 			}
-			lua_pushfstring(gL, FMT_HOOKID, hookp->id);
-			lua_gettable(gL, LUA_REGISTRYINDEX);
+			PushHook(gL, hookp);
 			lua_pushvalue(gL, -4);
 			lua_pushvalue(gL, -4);
 			lua_pushvalue(gL, -4);
-			if (lua_pcall(gL, 3, 1, 0)) {
+			if (CallHook(hookp, 3, 1)) {
 				if (!hookp->error || cv_debug & DBG_LUA)
 					CONS_Alert(CONS_WARNING,"%s\n",lua_tostring(gL, -1));
 				lua_pop(gL, 1);
@@ -1066,10 +1191,9 @@ void LUAh_NetArchiveHook(lua_CFunction archFunc)
 	for (hookp = roothook; hookp; hookp = hookp->next)
 		if (hookp->type == hook_NetVars)
 		{
-			lua_pushfstring(gL, FMT_HOOKID, hookp->id);
-			lua_gettable(gL, LUA_REGISTRYINDEX);
+			PushHook(gL, hookp);
 			lua_pushvalue(gL, -2); // archFunc
-			LUA_Call(gL, 1);
+			LUA_CallHook(hookp, 1);
 		}
 
 	lua_pop(gL, 1); // pop archFunc
@@ -1092,14 +1216,284 @@ void LUAh_PlayerQuit(player_t *plr, int reason)
 		        LUA_PushUserdata(gL, plr, META_PLAYER); // Player that quit
 		        lua_pushinteger(gL, reason); // Reason for quitting
 		    }
-			lua_pushfstring(gL, FMT_HOOKID, hookp->id);
-			lua_gettable(gL, LUA_REGISTRYINDEX);
+			PushHook(gL, hookp);
 			lua_pushvalue(gL, -3);
 			lua_pushvalue(gL, -3);
-			LUA_Call(gL, 2);
+			LUA_CallHook(hookp, 2);
 		}
 
 	lua_settop(gL, 0);
 }
 
+static const char *ProfileHookTarget(hook_p hookp)
+{
+	switch (hookp->type)
+	{
+	case hook_MobjSpawn:
+	case hook_MobjCollide:
+	case hook_MobjMoveCollide:
+	case hook_TouchSpecial:
+	case hook_MobjFuse:
+	case hook_MobjThinker:
+	case hook_BossThinker:
+	case hook_ShouldDamage:
+	case hook_MobjDamage:
+	case hook_MobjDeath:
+	case hook_BossDeath:
+	case hook_MobjRemoved:
+	case hook_HurtMsg:
+		return hookp->s.mt == MT_NULL ? "" : DEH_MobjTypeName(hookp->s.mt);
+	case hook_BotAI:
+		return hookp->s.skinname ? hookp->s.skinname : "";
+	case hook_LinedefExecute:
+		return hookp->s.funcname;
+	default:
+		return "";
+	}
+}
+
+static int CompareHookTime(const void *a, const void *b)
+{
+	const precise_t ta = (*(const hook_p *)a)->time, tb = (*(const hook_p *)b)->time;
+	return (ta < tb) - (ta > tb);
+}
+
+static int CompareSpotSamples(const void *a, const void *b)
+{
+	const UINT32 sa = (*(const luaprofilespot_t * const *)a)->samples;
+	const UINT32 sb = (*(const luaprofilespot_t * const *)b)->samples;
+	return (sa < sb) - (sa > sb);
+}
+
+// Wall time covered by the profile so far.
+static precise_t LUA_ProfileTime(void)
+{
+	if (luaprofiling)
+		return luaprofiletime + (I_GetPreciseTime() - luaprofilestart);
+	return luaprofiletime;
+}
+
+static void LUA_StartProfile(void)
+{
+	hook_p hookp;
+
+	for (hookp = allhooks; hookp; hookp = hookp->nextall)
+	{
+		hookp->calls = 0;
+		hookp->time = 0;
+	}
+	memset(hooktypecalls, 0, sizeof(hooktypecalls));
+	memset(hooktypetime, 0, sizeof(hooktypetime));
+
+	if (!profilespots)
+		profilespots = Z_Malloc(MAXPROFILESPOTS * sizeof (*profilespots), PU_STATIC, NULL);
+	memset(profilespots, 0, MAXPROFILESPOTS * sizeof (*profilespots));
+	numprofilespots = 0;
+	profilesamples = profiledropped = 0;
+
+	luaprofiletime = 0;
+	luaprofilestart = I_GetPreciseTime();
+	luaprofiling = true;
+	if (gL)
+		lua_sethook(gL, LUA_ProfileSample, LUA_MASKCOUNT, PROFILE_SAMPLERATE);
+}
+
+static void LUA_StopProfile(void)
+{
+	luaprofiletime = LUA_ProfileTime();
+	luaprofiling = false;
+	if (gL)
+		lua_sethook(gL, NULL, 0, 0);
+}
+
+// Everything that was sampled at least once, most samples first.
+// Returns the number of spots in *spots, which the caller frees.
+static size_t LUA_SortedProfileSpots(luaprofilespot_t ***spots)
+{
+	size_t i, n = 0;
+
+	*spots = Z_Malloc((numprofilespots + 1) * sizeof (**spots), PU_STATIC, NULL);
+	if (profilespots)
+		for (i = 0; i < MAXPROFILESPOTS; i++)
+			if (profilespots[i].samples)
+				(*spots)[n++] = &profilespots[i];
+	qsort(*spots, n, sizeof (**spots), CompareSpotSamples);
+	return n;
+}
+
+// Every hook that ran, most time first.
+// Returns the number of hooks in *hooks, which the caller frees.
+static size_t LUA_SortedProfileHooks(hook_p **hooks)
+{
+	hook_p hookp;
+	size_t n = 0;
+
+	*hooks = Z_Malloc((numhooks + 1) * sizeof (**hooks), PU_STATIC, NULL);
+	for (hookp = allhooks; hookp; hookp = hookp->nextall)
+		if (hookp->calls)
+			(*hooks)[n++] = hookp;
+	qsort(*hooks, n, sizeof (**hooks), CompareHookTime);
+	return n;
+}
+
+static void WriteCSVString(FILE *f, const char *s)
+{
+	fputc('"', f);
+	for (; *s; s++)
+	{
+		if (*s == '"')
+			fputc('"', f);
+		fputc(*s, f);
+	}
+	fputc('"', f);
+}
+
+static void WriteProfileRow(FILE *f, const char *kind, INT32 id, const char *name,
+	const char *target, const char *where, UINT64 calls, precise_t time, UINT32 samples)
+{
+	const double us = (double)I_PreciseToMicros(time);
+
+	fprintf(f, "%s,", kind);
+	if (id >= 0)
+		fprintf(f, "%d", id);
+	fputc(',', f);
+	WriteCSVString(f, name);
+	fputc(',', f);
+	WriteCSVString(f, target);
+	fputc(',', f);
+	WriteCSVString(f, where);
+	fprintf(f, ",%.0f,%.0f,%.3f,%u,%.2f\n", (double)calls, us,
+		calls ? us / (double)calls : 0.0, samples,
+		profilesamples ? 100.0 * samples / profilesamples : 0.0);
+}
+
+/** \brief Writes the profile as CSV.
+
+	One row per hook type and per hook that ran, with their total and
+	per-call microseconds (inclusive of any hooks they set off), then one
+	row per sampled function and line.
+
+	\param	filename	file to write
+	\return	false if the file couldn't be opened
+*/
+static boolean LUA_WriteProfile(const char *filename)
+{
+	FILE *f;
+	hook_p *hooks;
+	luaprofilespot_t **spots;
+	size_t i, n;
+
+	f = fopen(filename, "w");
+	if (!f)
+		return false;
+
+	fprintf(f, "kind,id,name,target,where,calls,total_us,us_per_call,samples,sample_pct\n");
+	for (i = 0; i < hook_MAX; i++)
+		if (hooktypecalls[i])
+			WriteProfileRow(f, "hooktype", -1, hookNames[i], "", "", hooktypecalls[i], hooktypetime[i], 0);
+
+	n = LUA_SortedProfileHooks(&hooks);
+	for (i = 0; i < n; i++)
+		WriteProfileRow(f, "hook", hooks[i]->id, hookNames[hooks[i]->type], ProfileHookTarget(hooks[i]),
+			hooks[i]->where, hooks[i]->calls, hooks[i]->time, 0);
+	Z_Free(hooks);
+
+	n = LUA_SortedProfileSpots(&spots);
+	for (i = 0; i < n; i++)
+		WriteProfileRow(f, spots[i]->isline ? "line" : "function", -1, "", "",
+			va("%s:%d", spots[i]->source, spots[i]->line), 0, 0, spots[i]->samples);
+	Z_Free(spots);
+
+	fclose(f);
+	CONS_Printf(M_GetText("Lua profile written to %s\n"), filename);
+	return true;
+}
+
+static void LUA_PrintProfile(void)
+{
+	const double totalus = (double)I_PreciseToMicros(LUA_ProfileTime());
+	hook_p *hooks;
+	luaprofilespot_t **spots;
+	size_t i, n, shown;
+
+	CONS_Printf("--- luaprofile (%.0f ms%s) ---\n", totalus / 1000.0, luaprofiling ? ", running" : "");
+
+	CONS_Printf("Hook types:\n");
+	for (i = 0; i < hook_MAX; i++)
+		if (hooktypecalls[i])
+		{
+			const double us = (double)I_PreciseToMicros(hooktypetime[i]);
+			CONS_Printf("  %-16s %8.0f calls %10.0f us %8.2f us/call %5.1f%%\n", hookNames[i],
+				(double)hooktypecalls[i], us, us / (double)hooktypecalls[i],
+				totalus > 0.0 ? 100.0 * us / totalus : 0.0);
+		}
+
+	CONS_Printf("Top hooks:\n");
+	n = LUA_SortedProfileHooks(&hooks);
+	for (i = 0; i < n && i < 10; i++)
+	{
+		const double us = (double)I_PreciseToMicros(hooks[i]->time);
+		CONS_Printf("  #%-4d %s %s (%s): %.0f calls, %.0f us, %.2f us/call\n", hooks[i]->id,
+			hookNames[hooks[i]->type], ProfileHookTarget(hooks[i]), hooks[i]->where,
+			(double)hooks[i]->calls, us, us / (double)hooks[i]->calls);
+	}
+	Z_Free(hooks);
+
+	CONS_Printf("Top functions (%u samples, 1 per %d instructions):\n", profilesamples, PROFILE_SAMPLERATE);
+	n = LUA_SortedProfileSpots(&spots);
+	for (i = shown = 0; i < n && shown < 10; i++)
+	{
+		if (spots[i]->isline)
+			continue;
+		CONS_Printf("  %5.1f%% %s:%d\n", 100.0 * spots[i]->samples / profilesamples,
+			spots[i]->source, spots[i]->line);
+		shown++;
+	}
+	Z_Free(spots);
+
+	if (profiledropped)
+		CONS_Printf("(%u samples fell outside the table)\n", profiledropped);
+}
+
+/** \brief The "luaprofile" console command.
+
+	luaprofile start: reset and start timing hooks and sampling the VM
+	luaprofile stop: stop, keeping what was gathered
+	luaprofile dump [file]: print the top hooks and functions, or write
+	everything to a CSV file
+*/
+void Command_Luaprofile_f(void)
+{
+	const char *arg = COM_Argv(1);
+
+	if (COM_Argc() < 2)
+	{
+		CONS_Printf(M_GetText("luaprofile start|stop|dump [file]: profile Lua hooks and functions (%s)\n"),
+			luaprofiling ? "running" : "stopped");
+		return;
+	}
+
+	if (!stricmp(arg, "start"))
+	{
+		LUA_StartProfile();
+		CONS_Printf("Lua profiling: ON\n");
+	}
+	else if (!stricmp(arg, "stop"))
+	{
+		if (!luaprofiling)
+			return;
+		LUA_StopProfile();
+		CONS_Printf("Lua profiling: OFF\n");
+	}
+	else if (!stricmp(arg, "dump"))
+	{
+		if (COM_Argc() < 3)
+			LUA_PrintProfile();
+		else if (!LUA_WriteProfile(COM_Argv(2)))
+			CONS_Alert(CONS_ERROR, M_GetText("Couldn't open %s for writing\n"), COM_Argv(2));
+	}
+	else
+		CONS_Printf(M_GetText("luaprofile start|stop|dump [file]\n"));
+}
+
 #endif
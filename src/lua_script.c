@@ -15,6 +15,15 @@
 #include "fastcmp.h"
 #include "dehacked.h"
 #include "z_zone.h"
+#include "i_system.h" // I_GetPreciseTime, I_mkdir
+#include "d_main.h" // srb2home
+#include "m_argv.h"
+// The bytecode cache needs md5.c, which the 3DS build links in for it
+// even though it leaves out the wad checksums (NOMD5).
+#if !defined (NOMD5) || defined (_NDS)
+#define LUA_BYTECODECACHE
+#include "md5.h" // bytecode cache
+#endif
 #include "w_wad.h"
 #include "p_setup.h"
 #include "r_state.h"
@@ -56,16 +65,177 @@ static lua_CFunction liblist[] = {
 	NULL
 };
 
+// Lua's small blocks (tables, strings, closures, userdata...) come and go
+// all the time, so those come from size-class pools rather than the zone.
+// Lua always tells us how big a block is when it frees or resizes it, so
+// the pooled blocks need no header at all. Anything bigger than the largest
+// class goes to the zone as PU_LUA like before. The pools only give their
+// chunks back when the Lua state is closed.
+#define LUAPOOLGRAIN 8
+#define LUAPOOLMAX 256 // largest pooled size
+#define NUMLUAPOOLS (LUAPOOLMAX/LUAPOOLGRAIN)
+#define LUAPOOLCHUNK 8192
+
+typedef struct
+{
+	void *freelist;
+	void *chunks; // each starts with a pointer to the next
+	size_t used, peak, capacity;
+	UINT32 allocs;
+} luapool_t;
+
+static luapool_t luapools[NUMLUAPOOLS];
+static size_t luabigbytes, luabigpeak;
+static UINT32 luabigallocs;
+
+#define LUAPOOL(size) (((size) - 1) / LUAPOOLGRAIN)
+
+static void LUA_GrowPool(luapool_t *pool, size_t size)
+{
+	const size_t count = (LUAPOOLCHUNK - LUAPOOLGRAIN) / size;
+	UINT8 *chunk = Z_Malloc(LUAPOOLCHUNK, PU_LUA, NULL);
+	size_t i;
+
+	*(void **)chunk = pool->chunks;
+	pool->chunks = chunk;
+
+	for (i = count; i--;)
+	{
+		void *ptr = chunk + LUAPOOLGRAIN + i*size;
+		*(void **)ptr = pool->freelist;
+		pool->freelist = ptr;
+	}
+	pool->capacity += count;
+}
+
+static inline void *LUA_PoolAlloc(size_t size)
+{
+	luapool_t *pool = &luapools[LUAPOOL(size)];
+	void *ptr;
+
+	if (!pool->freelist)
+		LUA_GrowPool(pool, (LUAPOOL(size) + 1) * LUAPOOLGRAIN);
+
+	ptr = pool->freelist;
+	pool->freelist = *(void **)ptr;
+	if (++pool->used > pool->peak)
+		pool->peak = pool->used;
+	pool->allocs++;
+	return ptr;
+}
+
+static inline void LUA_PoolFree(void *ptr, size_t size)
+{
+	luapool_t *pool = &luapools[LUAPOOL(size)];
+
+	*(void **)ptr = pool->freelist;
+	pool->freelist = ptr;
+	pool->used--;
+}
+
+// Gives back every pool chunk. Only for when the Lua state is gone.
+static void LUA_ClearPools(void)
+{
+	size_t i;
+
+	for (i = 0; i < NUMLUAPOOLS; i++)
+	{
+		void *chunk = luapools[i].chunks;
+		while (chunk)
+		{
+			void *next = *(void **)chunk;
+			Z_Free(chunk);
+			chunk = next;
+		}
+	}
+	memset(luapools, 0, sizeof(luapools));
+	luabigbytes = luabigpeak = 0;
+	luabigallocs = 0;
+}
+
 // Lua asks for memory using this.
 static void *LUA_Alloc(void *ud, void *ptr, size_t osize, size_t nsize)
 {
 	(void)ud;
+#ifndef HAVE_VALGRIND
+	if (osize && osize <= LUAPOOLMAX) // pooled block
+	{
+		void *newptr;
+
+		if (nsize == 0)
+		{
+			LUA_PoolFree(ptr, osize);
+			return NULL;
+		}
+		if (nsize <= LUAPOOLMAX && LUAPOOL(nsize) == LUAPOOL(osize))
+			return ptr; // still fits
+
+		if (nsize <= LUAPOOLMAX)
+			newptr = LUA_PoolAlloc(nsize);
+		else
+		{
+			newptr = Z_Malloc(nsize, PU_LUA, NULL);
+			luabigallocs++;
+			if ((luabigbytes += nsize) > luabigpeak)
+				luabigpeak = luabigbytes;
+		}
+		M_Memcpy(newptr, ptr, min(osize, nsize));
+		LUA_PoolFree(ptr, osize);
+		return newptr;
+	}
+
+	if (nsize && nsize <= LUAPOOLMAX) // moving into a pool
+	{
+		void *newptr = LUA_PoolAlloc(nsize);
+		if (osize)
+		{
+			M_Memcpy(newptr, ptr, nsize);
+			Z_Free(ptr);
+			luabigbytes -= osize;
+		}
+		return newptr;
+	}
+
+	luabigbytes -= osize;
+	if (nsize == 0) {
+		if (osize != 0)
+			Z_Free(ptr);
+		return NULL;
+	}
+	if (!osize)
+		luabigallocs++;
+	if ((luabigbytes += nsize) > luabigpeak)
+		luabigpeak = luabigbytes;
+	return Z_Realloc(ptr, nsize, PU_LUA, NULL);
+#else
 	if (nsize == 0) {
 		if (osize != 0)
 			Z_Free(ptr);
 		return NULL;
 	} else
 		return Z_Realloc(ptr, nsize, PU_LUA, NULL);
+#endif
+}
+
+// "luapools": how the Lua allocator's pools are doing
+void Command_Luapools_f(void)
+{
+	size_t i, used = 0, capacity = 0;
+
+	CONS_Printf("size    used    peak   capacity    allocs\n");
+	for (i = 0; i < NUMLUAPOOLS; i++)
+	{
+		const luapool_t *pool = &luapools[i];
+		if (!pool->capacity)
+			continue;
+		CONS_Printf("%4s %7s %7s %10s %9u\n", sizeu1((i + 1) * LUAPOOLGRAIN), sizeu2(pool->used),
+			sizeu3(pool->peak), sizeu4(pool->capacity), pool->allocs);
+		used += pool->used * (i + 1) * LUAPOOLGRAIN;
+		capacity += pool->capacity * (i + 1) * LUAPOOLGRAIN;
+	}
+	CONS_Printf("Pooled: %s KB of %s KB in use\n", sizeu1(used >> 10), sizeu2(capacity >> 10));
+	CONS_Printf("Zone: %s KB (peak %s KB), %u blocks allocated\n", sizeu1(luabigbytes >> 10),
+		sizeu2(luabigpeak >> 10), luabigallocs);
 }
 
 // Panic function Lua calls when there's an unprotected error.
@@ -110,6 +280,30 @@ static int noglobals(lua_State *L)
 	return luaL_error(L, "Implicit global " LUA_QS " prevented. Create a local variable instead.", csname);
 }
 
+// Every pointer Lua has a userdata for, along with that userdata. Freeing
+// and removing things Lua never saw (most of them) only has to look here,
+// instead of going through the registry.
+typedef struct
+{
+	void *data;
+	void **userdata;
+} luaudslot_t;
+
+static luaudslot_t *udslots = NULL;
+static size_t udslotcount = 0; // always a power of two
+static size_t udslotsused = 0;
+
+// Thinkers removed this tic whose userdata has been invalidated, but whose
+// registry entries haven't been cleared out yet; see LUA_FlushUserdata.
+#define MAXDEFERREDUD 512
+static void *deferredud[MAXDEFERREDUD];
+static size_t numdeferredud = 0;
+
+// State of the frame-driven collector, see LUA_StepGC.
+static boolean luagccycle = false; // in the middle of a frame-driven cycle
+static int luagcnextcycle = 0; // heap size (KB) to start the next one at
+static int luagclastcount = 0; // heap size (KB) at the end of the last LUA_Step
+
 // Clear and create a new Lua state, laddo!
 // There's SCRIPTIN to be had!
 static void LUA_ClearState(void)
@@ -121,6 +315,16 @@ static void LUA_ClearState(void)
 	if (gL)
 		lua_close(gL);
 	gL = NULL;
+	LUA_ClearPools();
+
+	// ...and everything that pointed into it
+	if (udslots)
+		Z_Free(udslots);
+	udslots = NULL;
+	udslotcount = udslotsused = 0;
+	numdeferredud = 0;
+	luagccycle = false;
+	luagcnextcycle = luagclastcount = 0;
 
 	CONS_Printf(M_GetText("Pardon me while I initialize the Lua scripting interface...\n"));
 
@@ -164,6 +368,180 @@ void LUA_ClearExtVars(void)
 }
 #endif
 
+#if defined (LUA_BYTECODECACHE) || defined (LUA_ALLOW_BYTECODE)
+// Writes compiled chunks out for lua_dump, must match lua_Writer
+static int dumpWriter(lua_State *L, const void *p, size_t sz, void *ud)
+{
+	FILE *handle = (FILE*)ud;
+	I_Assert(handle != NULL);
+	(void)L;
+	if (!sz) return 0; // nothing to write? can't fail that! :D
+	return (fwrite(p, 1, sz, handle) != sz); // if fwrite != sz, we've failed.
+}
+#endif
+
+#ifdef LUA_BYTECODECACHE
+// Compiled scripts are kept in srb2home/luacache, named after the MD5 of
+// their source and chunk name, so unchanged scripts skip the parser the
+// next time they're loaded. Each file starts with the build that wrote it;
+// files from any other build, or whose contents don't match their name,
+// are ignored and written again. -noluacache turns all of this off.
+#define LUACACHEDIR "luacache"
+
+typedef struct
+{
+	const char *data;
+	size_t size;
+} luacachereader_t;
+
+// must match lua_Reader
+static const char *LUA_CacheReader(lua_State *L, void *ud, size_t *size)
+{
+	luacachereader_t *reader = ud;
+	(void)L;
+	if (!reader->size)
+		return NULL;
+	*size = reader->size;
+	reader->size = 0;
+	return reader->data;
+}
+
+static size_t LUA_CacheStamp(char *stamp, size_t len)
+{
+	snprintf(stamp, len, "SRB2LUAC %s %s %s\n", comprevision, compdate, comptime);
+	stamp[len-1] = '\0';
+	return strlen(stamp);
+}
+
+static void LUA_CachePath(char *path, size_t len, const UINT8 *md5, const char *ext)
+{
+	char hex[33];
+	size_t i;
+	for (i = 0; i < 16; i++)
+		sprintf(&hex[i*2], "%02x", md5[i]);
+	snprintf(path, len, "%s" PATHSEP LUACACHEDIR PATHSEP "%s%s", srb2home, hex, ext);
+	path[len-1] = '\0';
+}
+
+// Pushes the cached compile of a script, if there's a good one.
+static boolean LUA_LoadCachedChunk(const UINT8 *md5, const char *chunkname)
+{
+	char path[512], stamp[256];
+	const size_t stamplen = LUA_CacheStamp(stamp, sizeof stamp);
+	luacachereader_t reader;
+	boolean ok;
+	char *buf;
+	FILE *f;
+	long size;
+
+	LUA_CachePath(path, sizeof path, md5, ".luac");
+	f = fopen(path, "rb");
+	if (!f)
+		return false;
+
+	fseek(f, 0, SEEK_END);
+	size = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	if (size <= (long)(stamplen + 16))
+	{
+		fclose(f);
+		return false;
+	}
+
+	buf = Z_Malloc(size, PU_STATIC, NULL);
+	ok = (fread(buf, 1, size, f) == (size_t)size
+		&& !memcmp(buf, stamp, stamplen)
+		&& !memcmp(buf + stamplen, md5, 16));
+	fclose(f);
+
+	if (ok)
+	{
+		reader.data = buf + stamplen + 16;
+		reader.size = size - (stamplen + 16);
+		if (lua_loadbytecode(gL, LUA_CacheReader, &reader, chunkname))
+		{
+			CONS_Debug(DBG_LUA, "Ignoring %s: %s\n", path, lua_tostring(gL, -1));
+			lua_pop(gL, 1);
+			ok = false;
+		}
+	}
+
+	Z_Free(buf);
+	return ok;
+}
+
+// Writes the function on top of the stack to the cache.
+static void LUA_SaveCachedChunk(const UINT8 *md5)
+{
+	static boolean triedmkdir = false;
+	char path[512], temp[512], stamp[256];
+	const size_t stamplen = LUA_CacheStamp(stamp, sizeof stamp);
+	boolean ok;
+	FILE *f;
+
+	LUA_CachePath(temp, sizeof temp, md5, ".tmp");
+	f = fopen(temp, "wb");
+	if (!f && !triedmkdir)
+	{
+		// only once a session, the 3DS complains about existing folders
+		triedmkdir = true;
+		snprintf(path, sizeof path, "%s" PATHSEP LUACACHEDIR, srb2home);
+		path[sizeof path - 1] = '\0';
+		I_mkdir(path, 0755);
+		f = fopen(temp, "wb");
+	}
+	if (!f)
+		return;
+
+	LUA_CachePath(path, sizeof path, md5, ".luac");
+
+	ok = (fwrite(stamp, 1, stamplen, f) == stamplen
+		&& fwrite(md5, 1, 16, f) == 16
+		&& !lua_dump(gL, dumpWriter, f));
+	ok = (fclose(f) == 0) && ok;
+
+	// swap it in whole, so a crash never leaves half a file behind
+	remove(path);
+	if (!ok || rename(temp, path))
+		remove(temp);
+}
+#endif
+
+// luaL_loadbuffer, going through the bytecode cache.
+static int LUA_LoadChunk(MYFILE *f, const char *chunkname)
+{
+#ifdef LUA_BYTECODECACHE
+	static INT32 usecache = -1;
+	UINT8 md5[16];
+	char *key;
+	size_t namelen;
+	int status;
+
+	if (usecache == -1)
+		usecache = !M_CheckParm("-noluacache");
+	if (!usecache)
+		return luaL_loadbuffer(gL, f->data, f->size, chunkname);
+
+	// key on the name too, since that's compiled in for error messages
+	namelen = strlen(chunkname);
+	key = Z_Malloc(16 + namelen, PU_STATIC, NULL);
+	md5_buffer(f->data, f->size, key);
+	M_Memcpy(key + 16, chunkname, namelen);
+	md5_buffer(key, 16 + namelen, md5);
+	Z_Free(key);
+
+	if (LUA_LoadCachedChunk(md5, chunkname))
+		return 0;
+
+	status = luaL_loadbuffer(gL, f->data, f->size, chunkname);
+	if (!status)
+		LUA_SaveCachedChunk(md5);
+	return status;
+#else
+	return luaL_loadbuffer(gL, f->data, f->size, chunkname);
+#endif
+}
+
 // Load a script from a MYFILE
 static inline void LUA_LoadFile(MYFILE *f, char *name)
 {
@@ -175,7 +553,7 @@ static inline void LUA_LoadFile(MYFILE *f, char *name)
 	lua_pushinteger(gL, f->wad);
 	lua_setfield(gL, LUA_REGISTRYINDEX, "WAD");
 
-	if (luaL_loadbuffer(gL, f->data, f->size, va("@%s",name)) || lua_pcall(gL, 0, 0, 0)) {
+	if (LUA_LoadChunk(f, va("@%s",name)) || lua_pcall(gL, 0, 0, 0)) {
 		CONS_Alert(CONS_WARNING,"%s\n",lua_tostring(gL,-1));
 		lua_pop(gL,1);
 	}
@@ -217,15 +595,6 @@ void LUA_LoadLump(UINT16 wad, UINT16 lump)
 }
 
 #ifdef LUA_ALLOW_BYTECODE
-// must match lua_Writer
-static int dumpWriter(lua_State *L, const void *p, size_t sz, void *ud)
-{
-	FILE *handle = (FILE*)ud;
-	I_Assert(handle != NULL);
-	(void)L;
-	if (!sz) return 0; // nothing to write? can't fail that! :D
-	return (fwrite(p, 1, sz, handle) != sz); // if fwrite != sz, we've failed.
-}
 
 // Compile a script by name and dump it back to disk.
 void LUA_DumpFile(const char *filename)
@@ -331,6 +700,75 @@ fixed_t LUA_EvalMath(const char *word)
 	return res;
 }
 
+#define UDSLOT(data) ((size_t)((UINT32)((size_t)(data) >> 3) * 2654435761u) & (udslotcount - 1))
+
+static luaudslot_t *LUA_FindUdSlot(void *data)
+{
+	size_t i;
+
+	if (!udslotsused)
+		return NULL;
+
+	for (i = UDSLOT(data); udslots[i].data; i = (i + 1) & (udslotcount - 1))
+		if (udslots[i].data == data)
+			return &udslots[i];
+	return NULL;
+}
+
+static void LUA_AddUdSlot(void *data, void **userdata)
+{
+	size_t i;
+
+	if ((udslotsused + 1) * 2 > udslotcount) // keep at most half full
+	{
+		luaudslot_t *old = udslots;
+		const size_t oldcount = udslotcount;
+
+		udslotcount = oldcount ? oldcount * 2 : 1024;
+		udslots = Z_Calloc(udslotcount * sizeof (*udslots), PU_LUA, NULL);
+		for (i = 0; i < oldcount; i++)
+			if (old[i].data)
+			{
+				size_t j = UDSLOT(old[i].data);
+				while (udslots[j].data)
+					j = (j + 1) & (udslotcount - 1);
+				udslots[j] = old[i];
+			}
+		if (old)
+			Z_Free(old);
+	}
+
+	for (i = UDSLOT(data); udslots[i].data; i = (i + 1) & (udslotcount - 1))
+		if (udslots[i].data == data)
+			break;
+	if (!udslots[i].data)
+		udslotsused++;
+	udslots[i].data = data;
+	udslots[i].userdata = userdata;
+}
+
+static void LUA_RemoveUdSlot(luaudslot_t *slot)
+{
+	size_t i = slot - udslots, j = i;
+
+	// shift back any later entries that probed past this one
+	for (;;)
+	{
+		size_t home;
+		j = (j + 1) & (udslotcount - 1);
+		if (!udslots[j].data)
+			break;
+		home = UDSLOT(udslots[j].data);
+		if (((j - home) & (udslotcount - 1)) < ((j - i) & (udslotcount - 1)))
+			continue; // still reachable from its home slot
+		udslots[i] = udslots[j];
+		i = j;
+	}
+	udslots[i].data = NULL;
+	udslots[i].userdata = NULL;
+	udslotsused--;
+}
+
 // Takes a pointer, any pointer, and a metatable name
 // Creates a userdata for that pointer with the given metatable
 // Pushes it to the stack and stores it in the registry.
@@ -347,6 +785,19 @@ void LUA_PushUserdata(lua_State *L, void *data, const char *meta)
 	I_Assert(lua_istable(L, -1));
 	lua_pushlightuserdata(L, data);
 	lua_rawget(L, -2);
+	if (!lua_isnil(L, -1) && !*(void **)lua_touserdata(L, -1))
+	{
+		// left over from a removed thinker that used to live here;
+		// don't let this one inherit its variables.
+		lua_getfield(L, LUA_REGISTRYINDEX, LREG_EXTVARS);
+		I_Assert(lua_istable(L, -1));
+		lua_pushlightuserdata(L, data);
+		lua_pushnil(L);
+		lua_rawset(L, -3);
+		lua_pop(L, 1);
+		lua_pop(L, 1); // pop the stale userdata
+		lua_pushnil(L);
+	}
 	if (lua_isnil(L, -1)) { // no userdata? deary me, we'll have to make one.
 		lua_pop(L, 1); // pop the nil
 
@@ -361,6 +812,10 @@ void LUA_PushUserdata(lua_State *L, void *data, const char *meta)
 		lua_pushvalue(L, -2); // v (copy of the userdata)
 		lua_rawset(L, -4);
 
+		LUA_AddUdSlot(data, userdata);
+		if (fastcmp(meta, META_MOBJ))
+			((thinker_t *)data)->luadata = true;
+
 		// stack is left with the userdata on top, as if getting it had originally succeeded.
 	}
 	lua_remove(L, -2); // remove LREG_VALID
@@ -370,9 +825,15 @@ void LUA_PushUserdata(lua_State *L, void *data, const char *meta)
 void LUA_InvalidateUserdata(void *data)
 {
 	void **userdata;
+	luaudslot_t *slot;
 	if (!gL)
 		return;
 
+	slot = LUA_FindUdSlot(data);
+	if (!slot) // not in lua
+		return;
+	LUA_RemoveUdSlot(slot);
+
 	// fetch the userdata
 	lua_getfield(gL, LUA_REGISTRYINDEX, LREG_VALID);
 	I_Assert(lua_istable(gL, -1));
@@ -403,6 +864,74 @@ void LUA_InvalidateUserdata(void *data)
 	lua_pop(gL, 1); // pop LREG_VALID
 }
 
+// Same as LUA_InvalidateUserdata, for thinkers being removed during a tic.
+// Lua sees the thinker as invalid straight away, but the registry entries
+// are only cleared out by the next LUA_FlushUserdata, all in one go.
+void LUA_InvalidateThinker(thinker_t *th)
+{
+	luaudslot_t *slot;
+
+	if (!th->luadata)
+	{
+		// not a mobj Lua has seen; could still be something else it has
+		LUA_InvalidateUserdata(th);
+		return;
+	}
+	th->luadata = false;
+
+	if (!gL || !(slot = LUA_FindUdSlot(th)))
+		return;
+
+	if (numdeferredud == MAXDEFERREDUD)
+		LUA_FlushUserdata();
+
+	*slot->userdata = NULL;
+	LUA_RemoveUdSlot(slot);
+	deferredud[numdeferredud++] = th;
+}
+
+// Clears the registry entries of everything LUA_InvalidateThinker put off.
+void LUA_FlushUserdata(void)
+{
+	size_t i;
+
+	if (!numdeferredud)
+		return;
+	if (!gL)
+	{
+		numdeferredud = 0;
+		return;
+	}
+
+	lua_getfield(gL, LUA_REGISTRYINDEX, LREG_VALID);
+	I_Assert(lua_istable(gL, -1));
+	lua_getfield(gL, LUA_REGISTRYINDEX, LREG_EXTVARS);
+	I_Assert(lua_istable(gL, -1));
+	for (i = 0; i < numdeferredud; i++)
+	{
+		void **userdata;
+
+		lua_pushlightuserdata(gL, deferredud[i]);
+		lua_rawget(gL, -3);
+		userdata = lua_touserdata(gL, -1);
+		lua_pop(gL, 1);
+
+		// already gone, or something new lives there now and has its own
+		if (!userdata || *userdata)
+			continue;
+
+		lua_pushlightuserdata(gL, deferredud[i]);
+		lua_pushnil(gL);
+		lua_rawset(gL, -3); // LREG_EXTVARS
+
+		lua_pushlightuserdata(gL, deferredud[i]);
+		lua_pushnil(gL);
+		lua_rawset(gL, -4); // LREG_VALID
+	}
+	lua_pop(gL, 2);
+	numdeferredud = 0;
+}
+
 // Invalidate level data arrays
 void LUA_InvalidateLevel(void)
 {
@@ -411,8 +940,11 @@ void LUA_InvalidateLevel(void)
 	if (!gL)
 		return;
 
-	for (th = thinkercap.next; th && th != &thinkercap; th = th->next)
-		LUA_InvalidateUserdata(th);
+	LUA_FlushUserdata();
+
+	for (i = 0; i < NUM_THINKERLISTS; i++)
+		for (th = thlist[i].next; th && th != &thlist[i]; th = th->next)
+			LUA_InvalidateUserdata(th);
 
 	LUA_InvalidateMapthings();
 
@@ -519,6 +1051,7 @@ static UINT8 GetUserdataArchType(int index)
 
 static UINT8 ArchiveValue(int TABLESINDEX, int myindex)
 {
+	P_SaveRoom(SAVEROOM);
 	if (myindex < 0)
 		myindex = lua_gettop(gL)+1+myindex;
 	switch (lua_type(gL, myindex))
@@ -549,6 +1082,7 @@ static UINT8 ArchiveValue(int TABLESINDEX, int myindex)
 		UINT16 len = (UINT16)lua_objlen(gL, myindex); // get length of string, including embedded zeros
 		const char *s = lua_tostring(gL, myindex);
 		UINT16 i = 0;
+		P_SaveRoom(sizeof(UINT8) + sizeof(UINT16) + len);
 		WRITEUINT8(save_p, ARCH_STRING);
 		// if you're wondering why we're writing a string to save_p this way,
 		// it turns out that Lua can have embedded zeros ('\0') in the strings,
@@ -735,6 +1269,8 @@ static void ArchiveExtVars(void *pointer, const char *ptype)
 	int TABLESINDEX;
 	UINT16 i;
 
+	P_SaveRoom(SAVEROOM);
+
 	if (!gL) {
 		if (fastcmp(ptype,"player")) // players must always be included, even if no vars
 			WRITEUINT16(save_p, 0);
@@ -777,6 +1313,7 @@ static void ArchiveExtVars(void *pointer, const char *ptype)
 	while (lua_next(gL, -2))
 	{
 		I_Assert(lua_type(gL, -2) == LUA_TSTRING);
+		P_SaveRoom(lua_objlen(gL, -2) + 1);
 		WRITESTRING(save_p, lua_tostring(gL, -2));
 		if (ArchiveValue(TABLESINDEX, -1) == 2)
 			CONS_Alert(CONS_ERROR, "Type of value for %s entry '%s' (%s) could not be archived!\n", ptype, lua_tostring(gL, -2), luaL_typename(gL, -1));
@@ -835,6 +1372,7 @@ static void ArchiveTables(void)
 			lua_pop(gL, 1);
 		}
 		lua_pop(gL, 1);
+		P_SaveRoom(SAVEROOM);
 		WRITEUINT8(save_p, ARCH_TEND);
 	}
 }
@@ -998,12 +1536,132 @@ static void UnArchiveTables(void)
 	}
 }
 
+// Lua garbage collection.
+// With lua_gcbudget at 0, the collector runs the stock way: whenever enough
+// has been allocated, wherever that happens to be, plus a small step here
+// every frame. Otherwise the engine drives it, stepping it for up to that
+// many microseconds after each frame and holding off the automatic steps in
+// between, so collection doesn't land in the middle of P_Ticker. If the
+// budget can't keep up and the heap outgrows the headroom, the automatic
+// steps kick back in until the frame steps catch up.
+static CV_PossibleValue_t luagcbudget_cons_t[] = {{0, "MIN"}, {100000, "MAX"}, {0, NULL}};
+consvar_t cv_luagcbudget = {"lua_gcbudget", "1000", CV_SAVE, luagcbudget_cons_t, NULL, 0, NULL, NULL, 0, 0, NULL};
+
+// GC telemetry, for "luagcstats"
+static struct
+{
+	UINT32 frames; // frames the collector was stepped on
+	UINT32 steps;
+	UINT32 cycles; // cycles finished by frame steps
+	UINT32 overbudget; // frames that went past lua_gcbudget
+	UINT32 offframe; // frames where the heap shrank outside of LUA_Step
+	precise_t total, max;
+	UINT32 hist[8]; // pauses of <50, <100, <250, <500, <1000, <2000, <5000, >= 5000 us
+} luagcstats;
+
+static const UINT32 luagchistlimits[7] = {50, 100, 250, 500, 1000, 2000, 5000};
+
+static void LUA_CountGCPause(precise_t pause, UINT32 steps)
+{
+	const UINT64 us = I_PreciseToMicros(pause);
+	size_t i;
+
+	luagcstats.frames++;
+	luagcstats.steps += steps;
+	luagcstats.total += pause;
+	if (pause > luagcstats.max)
+		luagcstats.max = pause;
+	for (i = 0; i < 7 && us >= luagchistlimits[i]; i++)
+		;
+	luagcstats.hist[i]++;
+	if (cv_luagcbudget.value && us > (UINT64)cv_luagcbudget.value)
+		luagcstats.overbudget++;
+}
+
+static void LUA_StepGC(void)
+{
+	const precise_t start = I_GetPreciseTime();
+	int count = lua_gc(gL, LUA_GCCOUNT, 0);
+	UINT32 steps = 0;
+
+	if (count < luagclastcount)
+		luagcstats.offframe++;
+
+	if (!cv_luagcbudget.value)
+	{
+		lua_gc(gL, LUA_GCSTEP, 1);
+		LUA_CountGCPause(I_GetPreciseTime() - start, 1);
+		luagclastcount = lua_gc(gL, LUA_GCCOUNT, 0);
+		return;
+	}
+
+	if (luagccycle || count >= luagcnextcycle)
+	{
+		luagccycle = true;
+		do
+		{
+			steps++;
+			if (lua_gc(gL, LUA_GCSTEP, 0)) // finished a cycle
+			{
+				luagccycle = false;
+				luagcstats.cycles++;
+				// same rule as the stock collector: wait for the heap to double
+				count = lua_gc(gL, LUA_GCCOUNT, 0);
+				luagcnextcycle = count * 2;
+				break;
+			}
+		} while (I_PreciseToMicros(I_GetPreciseTime() - start) < (UINT64)cv_luagcbudget.value);
+		count = lua_gc(gL, LUA_GCCOUNT, 0);
+		LUA_CountGCPause(I_GetPreciseTime() - start, steps);
+	}
+
+	// Let the heap grow by half again (and by at least 256K) during the tics
+	// before the automatic steps take over; more if the next cycle is further off.
+	{
+		int headroom = max(count/2, 256);
+		if (!luagccycle && luagcnextcycle > count)
+			headroom += luagcnextcycle - count;
+		if (lua_gc(gL, LUA_GCDEFER, headroom))
+			luagccycle = true; // the automatic steps started one
+	}
+	luagclastcount = count;
+}
+
+void Command_Luagcstats_f(void)
+{
+	const double frames = luagcstats.frames ? (double)luagcstats.frames : 1.0;
+	size_t i;
+
+	if (COM_Argc() > 1 && !stricmp(COM_Argv(1), "reset"))
+	{
+		memset(&luagcstats, 0, sizeof(luagcstats));
+		return;
+	}
+
+	CONS_Printf("Lua heap: %d KB, collector %s", gL ? lua_gc(gL, LUA_GCCOUNT, 0) : 0,
+		cv_luagcbudget.value ? va("stepped for up to %d us a frame\n", cv_luagcbudget.value) : "run on allocation\n");
+	CONS_Printf("%u frames stepped, %u steps, %u cycles finished\n",
+		luagcstats.frames, luagcstats.steps, luagcstats.cycles);
+	CONS_Printf("Pause: %.1f us avg, %.0f us max, %u over budget\n",
+		(double)I_PreciseToMicros(luagcstats.total) / frames,
+		(double)I_PreciseToMicros(luagcstats.max), luagcstats.overbudget);
+	CONS_Printf("Heap shrank outside the frame steps on %u frames\n", luagcstats.offframe);
+	for (i = 0; i < 8; i++)
+	{
+		if (i < 7)
+			CONS_Printf("  < %4u us: %u\n", luagchistlimits[i], luagcstats.hist[i]);
+		else
+			CONS_Printf("  >=%4u us: %u\n", luagchistlimits[6], luagcstats.hist[i]);
+	}
+}
+
 void LUA_Step(void)
 {
 	if (!gL)
 		return;
 	lua_settop(gL, 0);
-	lua_gc(gL, LUA_GCSTEP, 1);
+	LUA_FlushUserdata();
+	LUA_StepGC();
 }
 
 void LUA_Archive(void)
@@ -1011,6 +1669,8 @@ void LUA_Archive(void)
 	INT32 i;
 	thinker_t *th;
 
+	LUA_FlushUserdata(); // don't archive the variables of removed mobjs
+
 	if (gL)
 		lua_newtable(gL); // tables to be archived.
 
@@ -1022,7 +1682,7 @@ void LUA_Archive(void)
 		ArchiveExtVars(&players[i], "player");
 	}
 
-	for (th = thinkercap.next; th != &thinkercap; th = th->next)
+	for (th = thlist[THINK_MOBJ].next; th != &thlist[THINK_MOBJ]; th = th->next)
 		if (th->function.acp1 == (actionf_p1)P_MobjThinker)
 		{
 			// archive function will determine when to skip mobjs,
@@ -1056,7 +1716,7 @@ void LUA_UnArchive(void)
 
 	do {
 		mobjnum = READUINT32(save_p); // read a mobjnum
-		for (th = thinkercap.next; th != &thinkercap; th = th->next)
+		for (th = thlist[THINK_MOBJ].next; th != &thlist[THINK_MOBJ]; th = th->next)
 			if (th->function.acp1 == (actionf_p1)P_MobjThinker
 			&& ((mobj_t *)th)->mobjnum == mobjnum) // find matching mobj
 				UnArchiveExtVars(th); // apply variables
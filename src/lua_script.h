@@ -45,14 +45,21 @@ void LUA_DumpFile(const char *filename);
 fixed_t LUA_EvalMath(const char *word);
 void LUA_PushUserdata(lua_State *L, void *data, const char *meta);
 void LUA_InvalidateUserdata(void *data);
+void LUA_InvalidateThinker(thinker_t *th);
+void LUA_FlushUserdata(void);
 void LUA_InvalidateLevel(void);
 void LUA_InvalidateMapthings(void);
 void LUA_InvalidatePlayer(player_t *player);
 void LUA_Step(void);
+void Command_Luagcstats_f(void);
+void Command_Luapools_f(void);
 void LUA_Archive(void);
 void LUA_UnArchive(void);
 void Got_Luacmd(UINT8 **cp, INT32 playernum); // lua_consolelib.c
 void LUA_CVarChanged(const char *name); // lua_consolelib.c
+
+extern consvar_t cv_luagcbudget;
+
 int Lua_optoption(lua_State *L, int narg,
 	const char *def, const char *const lst[]);
 void LUAh_NetArchiveHook(lua_CFunction archFunc);
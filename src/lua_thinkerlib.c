@@ -51,14 +51,31 @@ static int iterationState_gc(lua_State *L)
 		lua_pushlightuserdata(L, (th)); \
 }
 
+// Steps over list heads, moving on to the next thinker list until the
+// last one the iteration covers is exhausted; NULL when we're done.
+static thinker_t *skip_listheads(thinker_t *th, thinklistnum_t last)
+{
+	while (th >= thlist && th < thlist + NUM_THINKERLISTS)
+	{
+		thinklistnum_t n = (thinklistnum_t)(th - thlist);
+		if (n >= last)
+			return NULL;
+		th = thlist[n+1].next;
+	}
+	return th;
+}
+
 static int lib_iterateThinkers(lua_State *L)
 {
 	thinker_t *th = NULL, *next = NULL;
 	struct iterationState *it = luaL_checkudata(L, 1, META_ITERATIONSTATE);
+	// mobjs only ever live on their own list, so don't bother with the rest
+	const thinklistnum_t first = (it->filter == (actionf_p1)P_MobjThinker) ? THINK_MOBJ : 0;
+	const thinklistnum_t last = (it->filter == (actionf_p1)P_MobjThinker) ? THINK_MOBJ : NUM_THINKERLISTS - 1;
 	lua_settop(L, 2);
 
 	if (lua_isnil(L, 2))
-		th = &thinkercap;
+		th = &thlist[first];
 	else if (lua_isuserdata(L, 2))
 	{
 		if (lua_islightuserdata(L, 2))
@@ -88,13 +105,14 @@ static int lib_iterateThinkers(lua_State *L)
 	if (!next)
 		return luaL_error(L, "next thinker invalidated during iteration");
 
-	for (; next != &thinkercap; next = next->next)
+	for (next = skip_listheads(next, last); next; next = skip_listheads(next->next, last))
 		if (!it->filter || next->function.acp1 == it->filter)
 		{
+			thinker_t *after = skip_listheads(next->next, last);
 			push_thinker(next);
-			if (next->next != &thinkercap)
+			if (after)
 			{
-				push_thinker(next->next);
+				push_thinker(after);
 				it->next = luaL_ref(L, LUA_REGISTRYINDEX);
 			}
 			return 1;
@@ -9,6 +9,7 @@
 #include "../w_wad.h"
 #include "../z_zone.h"
 #include "../byteptr.h"
+#include "../sdl/mixer_sfx.h"
 #include "nds_utils.h"
 
 #define SAMPLERATE			44100
@@ -24,7 +25,7 @@ typedef struct
 UINT8 sound_started = false;
 
 static Mix_Music *music;
-static UINT8 music_volume, sfx_volume;
+static UINT8 music_volume;
 static double loop_point;
 static boolean songpaused;
 
@@ -57,8 +58,7 @@ static void SoundDriverInit(void)
 		return;
 	}
 
-	// Set number of channels being mixed
-	Mix_AllocateChannels(16);
+	I_StartupSfxMix(SAMPLERATE, 2);
 
 	sound_started = 1;
 }
@@ -99,149 +99,6 @@ static void *findRemoveCacheForChunk(Mix_Chunk *chunk)
 	return NULL;
 }
 */
-static inline bool isDoomSound(void *stream)
-{
-	UINT16 ver;
-
-	// lump header
-	ver = READUINT16(stream);
-	
-	// It should be 3 if it's a doomsound...
-	return ver == 3 ? true : false;
-}
-
-static Mix_Chunk *ds2chunk(void *stream)
-{
-	u16 freq;
-	size_t samples, i, newsamples;
-	u8 *sound;
-	SINT8 *s;
-	s16 *d;
-	INT16 o;
-	fixed_t step, frac;
-	Mix_Chunk *chunk;
-
-	(void) READUINT16(stream);	// skip lump header
-	freq = READUINT16(stream);
-	samples = READUINT32(stream);
-
-	switch(freq)
-	{
-		case 44100:
-			newsamples = samples;
-			break;
-
-		case 22050:
-			newsamples = samples<<1;
-			break;
-
-		case 11025:
-			newsamples = samples<<2;
-			break;
-
-		default:
-			frac = (44100 << FRACBITS) / (UINT32)freq;
-			if (!(frac & 0xFFFF)) // other solid multiples (change if FRACBITS != 16)
-				newsamples = samples * (frac >> FRACBITS);
-			else // strange and unusual fractional frequency steps, plus anything higher than 44100hz.
-				newsamples = FixedMul(FixedDiv(samples, freq), 44100) + 1; // add 1 to counter truncation.
-			if (newsamples >= UINT32_MAX>>2)
-				return NULL; // would and/or did wrap, can't store.
-			break;
-	}
-
-	if(newsamples > (1024 * 1024 * 8)>>2)
-	{
-		printf("ds2chunk: too many samples (%i)\n", newsamples);
-		return NULL;
-	}
-
-	sound = Z_Malloc(newsamples<<2, PU_SOUND, NULL);	// newsamples * sizeof(S16) * numchannels
-	if(!sound)
-	{
-		printf("ds2chunk: alloc failed, samples (%i)\n", newsamples);
-		return NULL;
-	}
-
-	s = (SINT8 *)stream;
-	d = (s16 *)sound;
-
-	// NOTE: we cannot assume "samples" is aligned to 4!
-
-	switch(freq)
-	{
-		case 44100:
-			for(i=0; i<samples; i++)
-			{
-				o = ((s16)(*s++)+0x80)<<8;
-				*d++ = o; // left channel
-				*d++ = o; // right channel
-			}
-			break;
-
-		case 22050:
-			for(i=0; i<samples; i++)
-			{
-				o = ((s16)(*s++)+0x80)<<8;
-				*d++ = o; // left channel
-				*d++ = o; // right channel
-				*d++ = o; // left channel
-				*d++ = o; // right channel
-			}
-			break;
-
-		case 11025:
-			// The compiler will optimze this. Trust me, I checked it.
-			for(i=0; i<samples; i++)
-			{
-				o = ((s16)(*s++)+0x80)<<8;
-				*d++ = o; // left channel
-				*d++ = o; // right channel
-				*d++ = o; // left channel
-				*d++ = o; // right channel
-				*d++ = o; // left channel
-				*d++ = o; // right channel
-				*d++ = o; // left channel
-				*d++ = o; // right channel
-			}
-			break;
-
-		default: // convert arbitrary hz to 44100.
-			step = 0;
-			i = 0;
-			frac = ((UINT32)freq << FRACBITS) / 44100;
-			while (i < samples)
-			{
-				o = (s16)(*s+0x80)<<8; // changed signedness and shift up to 16 bits
-				while (step < FRACUNIT) // this is as fast as I can make it.
-				{
-					*d++ = o; // left channel
-					*d++ = o; // right channel
-					step += frac;
-				}
-				do {
-					i++; s++;
-					step -= FRACUNIT;
-				} while (step >= FRACUNIT);
-			}
-			break;
-	}
-
-#ifdef DIAGNOSTIC
-	//printf("Got DoomSound freq %i\n", freq);
-#endif
-
-	chunk = Mix_QuickLoad_RAW(sound, (UINT8*)d-sound);
-	if(!chunk)
-	{
-		free(sound);
-		chunk = NULL;
-	}
-
-	// return Mixer Chunk.
-	return chunk;
-}
-
 void I_StartupSound(void)
 {
 	SoundDriverInit();
@@ -256,6 +113,7 @@ void I_ShutdownSound(void){}
 void *I_GetSfx(sfxinfo_t *sfx)
 {
 	void *lump;
+	void *native;
 	Mix_Chunk *chunk;
 	SDL_RWops *rw;
 
@@ -266,103 +124,33 @@ void *I_GetSfx(sfxinfo_t *sfx)
 		sfx->lumpnum = S_GetSfxLumpNum(sfx);
 	sfx->length = W_LumpLength(sfx->lumpnum);
 
-	lump = W_CacheLumpNum(sfx->lumpnum, PU_SOUND);
+	// A private copy: another sfx may share this lump, and a DoomSound
+	// keeps its buffer until I_FreeSfx.
+	lump = W_CacheLumpNumForce(sfx->lumpnum, PU_SOUND);
 	if (!lump)
 		return NULL;
 
-	if(isDoomSound(lump))
-	{
-		// convert from standard DoomSound format.
-		chunk = ds2chunk(lump);
-		if (chunk)
-		{
-			Z_Free(lump);
-			return chunk;
-		}
-		else return NULL;
-	}
+	// played straight from the lump, see mixer_sfx.c
+	native = I_SfxFromDoomSound(lump, sfx->length);
+	if (native)
+		return native;
 
 	// Try to load it as a WAVE or OGG using Mixer.
 	rw = SDL_RWFromMem(lump, sfx->length);
 	if (rw != NULL)
 	{
 		chunk = Mix_LoadWAV_RW(rw, 1);
-		return chunk;
+		Z_Free(lump); // Mixer made its own copy
+		return I_SfxFromChunk(chunk);
 	}
 
-	//Z_Free(lump);		XXX
+	Z_Free(lump);
 
 	return NULL; // haven't been able to get anything
 }
 
-void I_FreeSfx(sfxinfo_t *sfx)
-{
-	Mix_Chunk *chunk = sfx->data;
-
-	if (chunk)
-	{
-		UINT8 *abufdata = NULL;
-		if (chunk->allocated == 0)
-		{
-			// We allocated the data in this chunk, so get the abuf from mixer, then let it free the chunk, THEN we free the data
-			// I believe this should ensure the sound is not playing when we free it
-			abufdata = chunk->abuf;
-		}
-		Mix_FreeChunk(chunk);
-		if (abufdata)
-		{
-			// I'm going to assume we used Z_Malloc to allocate this data.
-			Z_Free(abufdata);
-		}
-
-		sfx->data = NULL;
-	}
-
-	sfx->lumpnum = LUMPERROR;
-}
-
-INT32 I_StartSound(sfxenum_t id, UINT8 vol, UINT8 sep, UINT8 pitch, UINT8 priority, INT32 channel)
-{
-	if (!sound_started)
-		return 0;
-
-	UINT8 volume = (((UINT16)vol + 1) * (UINT16)sfx_volume) / 62; // (256 * 31) / 62 == 127
-	INT32 handle = Mix_PlayChannel(channel, S_sfx[id].data, 0);
-	Mix_Volume(handle, volume);
-	Mix_SetPanning(handle, min((UINT16)(0xff-sep)<<1, 0xff), min((UINT16)(sep)<<1, 0xff));
-	(void)pitch; // Mixer can't handle pitch
-	(void)priority; // priority and channel management is handled by SRB2...
-	return handle;
-}
-
-void I_StopSound(INT32 handle)
-{
-	if (!sound_started)
-		return;
-
-	Mix_HaltChannel(handle);
-}
-
-boolean I_SoundIsPlaying(INT32 handle)
-{
-	return Mix_Playing(handle);
-}
-
 void I_UpdateSound(void){};
 
-void I_UpdateSoundParams(INT32 handle, UINT8 vol, UINT8 sep, UINT8 pitch)
-{
-	UINT8 volume = (((UINT16)vol + 1) * (UINT16)sfx_volume) / 62; // (256 * 31) / 62 == 127
-	Mix_Volume(handle, volume);
-	Mix_SetPanning(handle, min((UINT16)(0xff-sep)<<1, 0xff), min((UINT16)(sep)<<1, 0xff));
-	(void)pitch;
-}
-
-void I_SetSfxVolume(UINT8 volume)
-{
-	sfx_volume = volume;
-}
-
 /// ------------------------
 /// Music Hooks
 /// ------------------------
@@ -506,6 +294,7 @@ void I_ShutdownDigMusic(void)
 	music = NULL;
 
 	// quit SDL_mixer
+	I_ShutdownSfxMix();
 	Mix_CloseAudio();
 
 	sound_started = 0;
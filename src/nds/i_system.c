@@ -53,6 +53,18 @@ tic_t I_GetTime(void)
 	return (since_start*TICRATE)/1000LL;
 }
 
+precise_t I_GetPreciseTime(void)
+{
+	return svcGetSystemTick();
+}
+
+UINT64 I_PreciseToMicros(precise_t d)
+{
+	// CP15 timer runs at the ARM11 clock
+	// split up so that long runs don't overflow the multiply
+	return (d / SYSCLOCK_ARM11) * 1000000 + (d % SYSCLOCK_ARM11) * 1000000 / SYSCLOCK_ARM11;
+}
+
 void I_Sleep(void)
 {
 	extern consvar_t cv_sleep;
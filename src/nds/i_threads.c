@@ -0,0 +1,117 @@
+// SONIC ROBO BLAST 2
+//-----------------------------------------------------------------------------
+// Copyright (C) 1999-2018 by Sonic Team Junior.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  nds/i_threads.c
+/// \brief Multithreading abstraction for libctru
+
+#include <stdlib.h>
+#include <3ds.h>
+
+#define __BYTEBOOL__
+#define boolean bool
+
+#include "../doomdef.h"
+#include "../i_threads.h"
+#include "nds_utils.h"
+
+#ifdef HAVE_THREADS
+
+typedef struct
+{
+	I_thread_fn entry;
+	void *userdata;
+} thread_start_t;
+
+static void I_ThreadEntry(void *arg)
+{
+	thread_start_t start = *(thread_start_t *)arg;
+	free(arg);
+	start.entry(start.userdata);
+}
+
+boolean I_SpawnThread(const char *name, I_thread_fn entry, void *userdata)
+{
+	const size_t stackSize = 32 * 1024;
+	thread_start_t *start;
+	s32 prio = 0x30;
+	Thread th;
+
+	(void)name;
+
+	start = malloc(sizeof *start);
+	if (!start)
+		return false;
+	start->entry = entry;
+	start->userdata = userdata;
+
+	// Same cores as the render worker, which idles while these threads
+	// have something to do (mostly during level loads).
+	svcGetThreadPriority(&prio, CUR_THREAD_HANDLE);
+	th = threadCreate(I_ThreadEntry, start, stackSize, min(prio + 1, 0x3F), isNew3DS ? 2 : 1, true);
+	if (th == NULL)
+	{
+		free(start);
+		return false;
+	}
+	return true;
+}
+
+I_mutex I_CreateMutex(void)
+{
+	LightLock *lock = malloc(sizeof *lock);
+	if (!lock)
+		I_Error("I_CreateMutex: out of memory");
+	LightLock_Init(lock);
+	return lock;
+}
+
+void I_DestroyMutex(I_mutex id)
+{
+	free(id); // LightLocks hold no kernel objects
+}
+
+void I_LockMutex(I_mutex id)
+{
+	LightLock_Lock(id);
+}
+
+void I_UnlockMutex(I_mutex id)
+{
+	LightLock_Unlock(id);
+}
+
+I_cond I_CreateCond(void)
+{
+	CondVar *cond = malloc(sizeof *cond);
+	if (!cond)
+		I_Error("I_CreateCond: out of memory");
+	CondVar_Init(cond);
+	return cond;
+}
+
+void I_DestroyCond(I_cond cond)
+{
+	free(cond); // nor do CondVars
+}
+
+void I_HoldCond(I_cond cond, I_mutex mutex)
+{
+	CondVar_Wait(cond, mutex);
+}
+
+void I_WakeOneCond(I_cond cond)
+{
+	CondVar_Signal(cond);
+}
+
+void I_WakeAllCond(I_cond cond)
+{
+	CondVar_Broadcast(cond);
+}
+
+#endif/*HAVE_THREADS*/
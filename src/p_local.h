@@ -63,11 +63,21 @@
 // P_TICK
 //
 
-// both the head and tail of the thinker list
-extern thinker_t thinkercap;
+// thinker lists, in the order they are run
+typedef enum
+{
+	THINK_POLYOBJ, // first, so that carrying physics work right
+	THINK_MAIN,
+	THINK_MOBJ,
+	THINK_PRECIP,
+	NUM_THINKERLISTS
+} thinklistnum_t;
+
+// both the head and tail of each thinker list
+extern thinker_t thlist[NUM_THINKERLISTS];
 
 void P_InitThinkers(void);
-void P_AddThinker(thinker_t *thinker);
+void P_AddThinker(const thinklistnum_t n, thinker_t *thinker);
 void P_RemoveThinker(thinker_t *thinker);
 
 //
@@ -322,6 +332,9 @@ boolean P_TeleportMove(mobj_t *thing, fixed_t x, fixed_t y, fixed_t z);
 void P_SlideMove(mobj_t *mo);
 void P_BounceMove(mobj_t *mo);
 boolean P_CheckSight(mobj_t *t1, mobj_t *t2);
+void P_InitSightGroups(void);
+void P_InvalidateSightMemo(void);
+void Command_Sightstats_f(void);
 void P_CheckHoopPosition(mobj_t *hoopthing, fixed_t x, fixed_t y, fixed_t z, fixed_t radius);
 
 boolean P_CheckSector(sector_t *sector, boolean crunch);
@@ -351,6 +364,22 @@ extern fixed_t bmaporgx;
 extern fixed_t bmaporgy; // origin of block map
 extern mobj_t **blocklinks; // for thing chains
 
+// Copy of a blockmap line list entry, with what it takes
+// to reject the line by bounding box without touching line_t.
+// Map vertices are whole map units, so INT16 holds them exactly.
+typedef struct
+{
+	INT16 x1, y1; // v1, in map units
+	INT16 x2, y2; // v2
+	UINT16 line; // index into lines
+	SINT8 slopetype; // slopetype_t, or -1 for polyobject lines (never rejected)
+} blockline_t;
+
+extern blockline_t *blocklines; // NULL if the map has too many lines for it
+extern INT32 *blocklineoffs; // lists are blocklines[blocklineoffs[i]] up to blocklines[blocklineoffs[i+1]]
+
+void P_UnpinPolyobjBlockLines(void);
+
 //
 // P_INTER
 //
@@ -1479,7 +1479,7 @@ boolean P_CheckPosition(mobj_t *thing, fixed_t x, fixed_t y)
 		for (bx = xl; bx <= xh; bx++)
 			for (by = yl; by <= yh; by++)
 			{
-				if (!P_BlockThingsIterator(bx, by, PIT_CheckThing))
+				if (!P_BlockThingsIteratorTm(bx, by, PIT_CheckThing))
 					blockval = false;
 				if (P_MobjWasRemoved(tmthing))
 					return false;
@@ -1491,7 +1491,7 @@ boolean P_CheckPosition(mobj_t *thing, fixed_t x, fixed_t y)
 	// check lines
 	for (bx = xl; bx <= xh; bx++)
 		for (by = yl; by <= yh; by++)
-			if (!P_BlockLinesIterator(bx, by, PIT_CheckLine))
+			if (!P_BlockLinesIteratorBox(bx, by, tmbbox, PIT_CheckLine))
 				blockval = false;
 
 	return blockval;
@@ -1694,7 +1694,7 @@ boolean P_CheckCameraPosition(fixed_t x, fixed_t y, camera_t *thiscam)
 	// check lines
 	for (bx = xl; bx <= xh; bx++)
 		for (by = yl; by <= yh; by++)
-			if (!P_BlockLinesIterator(bx, by, PIT_CheckCameraLine))
+			if (!P_BlockLinesIteratorBox(bx, by, tmbbox, PIT_CheckCameraLine))
 				return false;
 
 	return true;
@@ -3292,7 +3292,7 @@ static boolean PIT_ChangeSector(mobj_t *thing, boolean realcrush)
 						thinker_t *think;
 						elevator_t *crumbler;
 
-						for (think = thinkercap.next; think != &thinkercap; think = think->next)
+						for (think = thlist[THINK_MAIN].next; think != &thlist[THINK_MAIN]; think = think->next)
 						{
 							if (think->function.acp1 != (actionf_p1)T_StartCrumble)
 								continue;
@@ -3350,6 +3350,8 @@ boolean P_CheckSector(sector_t *sector, boolean crunch)
 	nofit = false;
 	crushchange = crunch;
 
+	P_InvalidateSightMemo(); // heights changed
+
 	// killough 4/4/98: scan list front-to-back until empty or exhausted,
 	// restarting from beginning after each thing is processed. Avoids
 	// crashes, and is sure to examine all things in the sector, and only
@@ -3931,7 +3933,7 @@ void P_CreateSecNodeList(mobj_t *thing, fixed_t x, fixed_t y)
 
 	for (bx = xl; bx <= xh; bx++)
 		for (by = yl; by <= yh; by++)
-			P_BlockLinesIterator(bx, by, PIT_GetSectors);
+			P_BlockLinesIteratorBox(bx, by, tmbbox, PIT_GetSectors);
 
 	// Add the sector of the (x, y) point to sector_list.
 	sector_list = P_AddSecnode(thing->subsector->sector, thing, sector_list);
@@ -4010,7 +4012,7 @@ void P_CreatePrecipSecNodeList(precipmobj_t *thing,fixed_t x,fixed_t y)
 
 	for (bx = xl; bx <= xh; bx++)
 		for (by = yl; by <= yh; by++)
-			P_BlockLinesIterator(bx, by, PIT_GetPrecipSectors);
+			P_BlockLinesIteratorBox(bx, by, preciptmbbox, PIT_GetPrecipSectors);
 
 	// Add the sector of the (x, y) point to sector_list.
 	precipsector_list = P_AddPrecipSecnode(thing->subsector->sector, thing, precipsector_list);
@@ -1041,6 +1041,99 @@ boolean P_BlockLinesIterator(INT32 x, INT32 y, boolean (*func)(line_t *))
 	return true; // Everything was checked.
 }
 
+//
+// P_BlockLinesIteratorBox
+// Same as P_BlockLinesIterator, for iterators that, like PIT_CheckLine,
+// do nothing with lines that the given box doesn't cross. Those are thrown
+// out from the packed block lists, before their line_t is even looked at
+// (so they don't get their validcount set either, which is fine since
+// they'd be thrown out again from any other block).
+//
+boolean P_BlockLinesIteratorBox(INT32 x, INT32 y, fixed_t *bbox, boolean (*func)(line_t *))
+{
+	INT32 offset;
+	const blockline_t *bl, *end;
+#ifdef POLYOBJECTS
+	polymaplink_t *plink; // haleyjd 02/22/06
+#endif
+	line_t *ld;
+	INT32 p1, p2;
+
+	if (x < 0 || y < 0 || x >= bmapwidth || y >= bmapheight)
+		return true;
+
+	if (!blocklines)
+		return P_BlockLinesIterator(x, y, func);
+
+	offset = y*bmapwidth + x;
+
+#ifdef POLYOBJECTS
+	// haleyjd 02/22/06: consider polyobject lines
+	plink = polyblocklinks[offset];
+
+	while (plink)
+	{
+		polyobj_t *po = plink->po;
+
+		if (po->validcount != validcount) // if polyobj hasn't been checked
+		{
+			size_t i;
+			po->validcount = validcount;
+
+			for (i = 0; i < po->numLines; ++i)
+			{
+				if (po->lines[i]->validcount == validcount) // line has been checked
+					continue;
+				po->lines[i]->validcount = validcount;
+				if (!func(po->lines[i]))
+					return false;
+			}
+		}
+		plink = (polymaplink_t *)(plink->link.next);
+	}
+#endif
+
+	end = blocklines + blocklineoffs[offset + 1];
+	for (bl = blocklines + blocklineoffs[offset]; bl < end; bl++)
+	{
+		if (bl->slopetype != -1) // not a polyobject line
+		{
+			const fixed_t vx1 = (fixed_t)bl->x1<<FRACBITS, vy1 = (fixed_t)bl->y1<<FRACBITS;
+			const fixed_t vx2 = (fixed_t)bl->x2<<FRACBITS, vy2 = (fixed_t)bl->y2<<FRACBITS;
+
+			// the line's bounding box, same as lines[bl->line].bbox
+			if (bbox[BOXRIGHT] <= min(vx1, vx2) || bbox[BOXLEFT] >= max(vx1, vx2)
+			|| bbox[BOXTOP] <= min(vy1, vy2) || bbox[BOXBOTTOM] >= max(vy1, vy2))
+				continue;
+
+			// P_BoxOnLineSide, on the packed copy.
+			// Boxes that got this far always cross axis-aligned lines.
+			if (bl->slopetype == ST_POSITIVE || bl->slopetype == ST_NEGATIVE)
+			{
+				const fixed_t ldx = bl->x2 - bl->x1, ldy = bl->y2 - bl->y1;
+				const fixed_t x1 = (bl->slopetype == ST_POSITIVE) ? bbox[BOXLEFT] : bbox[BOXRIGHT];
+				const fixed_t x2 = (bl->slopetype == ST_POSITIVE) ? bbox[BOXRIGHT] : bbox[BOXLEFT];
+
+				p1 = (FixedMul(bbox[BOXTOP] - vy1, ldx) >= FixedMul(ldy, x1 - vx1));
+				p2 = (FixedMul(bbox[BOXBOTTOM] - vy1, ldx) >= FixedMul(ldy, x2 - vx1));
+				if (p1 == p2)
+					continue;
+			}
+		}
+
+		ld = &lines[bl->line];
+
+		if (ld->validcount == validcount)
+			continue; // Line has already been checked.
+
+		ld->validcount = validcount;
+
+		if (!func(ld))
+			return false;
+	}
+	return true; // Everything was checked.
+}
+
 
 //
 // P_BlockThingsIterator
@@ -1068,6 +1161,52 @@ boolean P_BlockThingsIterator(INT32 x, INT32 y, boolean (*func)(mobj_t *))
 	return true;
 }
 
+//
+// P_BlockThingsIteratorTm
+// Same as P_BlockThingsIterator, for iterators that, like PIT_CheckThing,
+// do nothing at all with things whose bounding box doesn't overlap that of
+// tmthing at (tmx, tmy). Those are skipped over right here, without the
+// call or taking a reference on the next thing in the block, which adds up
+// in blocks full of rings. Everything is read live, since the iterator can
+// move things (or start another check that changes tmx and tmy).
+//
+boolean P_BlockThingsIteratorTm(INT32 x, INT32 y, boolean (*func)(mobj_t *))
+{
+	mobj_t *mobj, *bnext = NULL;
+
+	if (x < 0 || y < 0 || x >= bmapwidth || y >= bmapheight)
+		return true;
+
+	for (mobj = blocklinks[y*bmapwidth + x]; mobj;)
+	{
+		if (tmthing)
+		{
+			const fixed_t blockdist = mobj->radius + tmthing->radius;
+			if (abs(mobj->x - tmx) >= blockdist || abs(mobj->y - tmy) >= blockdist)
+			{
+				mobj = mobj->bnext; // nothing for func to do with it
+				continue;
+			}
+		}
+
+		P_SetTarget(&bnext, mobj->bnext); // We want to note our reference to bnext here incase it is MF_NOTHINK and gets removed!
+		if (!func(mobj))
+		{
+			P_SetTarget(&bnext, NULL);
+			return false;
+		}
+		if (P_MobjWasRemoved(tmthing) // func just popped our tmthing, cannot continue.
+		|| (bnext && P_MobjWasRemoved(bnext))) // func just broke blockmap chain, cannot continue.
+		{
+			P_SetTarget(&bnext, NULL);
+			return true;
+		}
+		mobj = bnext;
+	}
+	P_SetTarget(&bnext, NULL);
+	return true;
+}
+
 //
 // INTERCEPT ROUTINES
 //
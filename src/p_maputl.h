@@ -62,7 +62,9 @@ extern pslope_t *opentopslope, *openbottomslope;
 void P_LineOpening(line_t *plinedef, mobj_t *mobj);
 
 boolean P_BlockLinesIterator(INT32 x, INT32 y, boolean(*func)(line_t *));
+boolean P_BlockLinesIteratorBox(INT32 x, INT32 y, fixed_t *bbox, boolean(*func)(line_t *));
 boolean P_BlockThingsIterator(INT32 x, INT32 y, boolean(*func)(mobj_t *));
+boolean P_BlockThingsIteratorTm(INT32 x, INT32 y, boolean(*func)(mobj_t *));
 
 #define PT_ADDLINES     1
 #define PT_ADDTHINGS    2
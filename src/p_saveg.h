@@ -21,8 +21,15 @@
 // Persistent storage/archiving.
 // These are the load / save game routines.
 
+// Big enough for any netgame save P_SaveNetGame writes
+#define NETSAVEGAMESIZE (768*1024)
+
+// Nothing P_SaveNetGame writes between two P_SaveRoom checks is bigger
+#define SAVEROOM 4096
+
 void P_SaveGame(void);
-void P_SaveNetGame(void);
+boolean P_SaveNetGame(void);
+void P_SaveRoom(size_t size);
 boolean P_LoadGame(INT16 mapoverride);
 boolean P_LoadNetGame(void);
 
@@ -42,5 +49,6 @@ typedef struct
 
 extern savedata_t savedata;
 extern UINT8 *save_p;
+extern UINT8 *save_end; // P_SaveNetGame doesn't write past this, cleared after
 
 #endif
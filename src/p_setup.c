@@ -119,6 +119,9 @@ INT32 *blockmaplump; // Big blockmap
 fixed_t bmaporgx, bmaporgy;
 // for thing chains
 mobj_t **blocklinks;
+// packed line lists, one per block
+blockline_t *blocklines;
+INT32 *blocklineoffs;
 
 // REJECT
 // For fast sight rejection.
@@ -359,9 +362,9 @@ UINT32 P_GetScoreForGrade(INT16 map, UINT8 mare, UINT8 grade)
   * \sa ML_VERTEXES
   */
 
-static inline void P_LoadRawVertexes(UINT8 *data, size_t i)
+static inline void P_LoadRawVertexes(const UINT8 *data, size_t i)
 {
-	mapvertex_t *ml;
+	const mapvertex_t *ml;
 	vertex_t *li;
 
 	numvertexes = i / sizeof (mapvertex_t);
@@ -372,7 +375,7 @@ static inline void P_LoadRawVertexes(UINT8 *data, size_t i)
 	// Allocate zone memory for buffer.
 	vertexes = Z_Calloc(numvertexes * sizeof (*vertexes), PU_LEVEL, NULL);
 
-	ml = (mapvertex_t *)data;
+	ml = (const mapvertex_t *)data;
 	li = vertexes;
 
 	// Copy and convert vertex coordinates, internal representation as fixed.
@@ -385,9 +388,9 @@ static inline void P_LoadRawVertexes(UINT8 *data, size_t i)
 
 static inline void P_LoadVertexes(lumpnum_t lumpnum)
 {
-	UINT8 *data = W_CacheLumpNum(lumpnum, PU_STATIC);
+	const UINT8 *data = W_GetLumpData(lumpnum, PU_STATIC);
 	P_LoadRawVertexes(data, W_LumpLength(lumpnum));
-	Z_Free(data);
+	W_ReleaseLumpData(lumpnum, data);
 }
 
 /** Computes the length of a seg in fracunits.
@@ -426,10 +429,10 @@ static inline float P_SegLengthFloat(seg_t *seg)
   * \param lump Lump number of the SEGS resource.
   * \sa ::ML_SEGS
   */
-static void P_LoadRawSegs(UINT8 *data, size_t i)
+static void P_LoadRawSegs(const UINT8 *data, size_t i)
 {
 	INT32 linedef, side;
-	mapseg_t *ml;
+	const mapseg_t *ml;
 	seg_t *li;
 	line_t *ldef;
 
@@ -438,7 +441,7 @@ static void P_LoadRawSegs(UINT8 *data, size_t i)
 		I_Error("Level has no segs"); // instead of crashing
 	segs = Z_Calloc(numsegs * sizeof (*segs), PU_LEVEL, NULL);
 
-	ml = (mapseg_t *)data;
+	ml = (const mapseg_t *)data;
 	li = segs;
 	for (i = 0; i < numsegs; i++, li++, ml++)
 	{
@@ -476,9 +479,9 @@ static void P_LoadRawSegs(UINT8 *data, size_t i)
 
 static void P_LoadSegs(lumpnum_t lumpnum)
 {
-	UINT8 *data = W_CacheLumpNum(lumpnum, PU_STATIC);
+	const UINT8 *data = W_GetLumpData(lumpnum, PU_STATIC);
 	P_LoadRawSegs(data, W_LumpLength(lumpnum));
-	Z_Free(data);
+	W_ReleaseLumpData(lumpnum, data);
 }
 
 
@@ -487,9 +490,9 @@ static void P_LoadSegs(lumpnum_t lumpnum)
   * \param lump Lump number of the SSECTORS resource.
   * \sa ::ML_SSECTORS
   */
-static inline void P_LoadRawSubsectors(void *data, size_t i)
+static inline void P_LoadRawSubsectors(const void *data, size_t i)
 {
-	mapsubsector_t *ms;
+	const mapsubsector_t *ms;
 	subsector_t *ss;
 
 	numsubsectors = i / sizeof (mapsubsector_t);
@@ -497,7 +500,7 @@ static inline void P_LoadRawSubsectors(void *data, size_t i)
 		I_Error("Level has no subsectors (did you forget to run it through a nodesbuilder?)");
 	ss = subsectors = Z_Calloc(numsubsectors * sizeof (*subsectors), PU_LEVEL, NULL);
 
-	ms = (mapsubsector_t *)data;
+	ms = (const mapsubsector_t *)data;
 
 	for (i = 0; i < numsubsectors; i++, ss++, ms++)
 	{
@@ -513,9 +516,9 @@ static inline void P_LoadRawSubsectors(void *data, size_t i)
 
 static void P_LoadSubsectors(lumpnum_t lumpnum)
 {
-	UINT8 *data = W_CacheLumpNum(lumpnum, PU_STATIC);
+	const UINT8 *data = W_GetLumpData(lumpnum, PU_STATIC);
 	P_LoadRawSubsectors(data, W_LumpLength(lumpnum));
-	Z_Free(data);
+	W_ReleaseLumpData(lumpnum, data);
 }
 
 //
@@ -536,6 +539,9 @@ size_t P_PrecacheLevelFlats(void)
 	lumpnum_t lump;
 	size_t i, flatmemory = 0;
 
+	for (i = 0; i < numlevelflats; i++)
+		W_PrefetchLumpNum(levelflats[i].lumpnum);
+
 	//SoM: 4/18/2000: New flat code to make use of levelflats.
 	for (i = 0; i < numlevelflats; i++)
 	{
@@ -650,9 +656,9 @@ INT32 P_CheckLevelFlat(const char *flatname)
 
 // Sets up the ingame sectors structures.
 // Lumpnum is the lumpnum of a SECTORS lump.
-static void P_LoadRawSectors(UINT8 *data, size_t i)
+static void P_LoadRawSectors(const UINT8 *data, size_t i)
 {
-	mapsector_t *ms;
+	const mapsector_t *ms;
 	sector_t *ss;
 	levelflat_t *foundflats;
 
@@ -673,7 +679,7 @@ static void P_LoadRawSectors(UINT8 *data, size_t i)
 	numlevelflats = 0;
 
 	// For each counted sector, copy the sector raw data from our cache pointer ms, to the global table pointer ss.
-	ms = (mapsector_t *)data;
+	ms = (const mapsector_t *)data;
 	ss = sectors;
 	for (i = 0; i < numsectors; i++, ss++, ms++)
 	{
@@ -757,18 +763,18 @@ static void P_LoadRawSectors(UINT8 *data, size_t i)
 
 static void P_LoadSectors(lumpnum_t lumpnum)
 {
-	UINT8 *data = W_CacheLumpNum(lumpnum, PU_STATIC);
+	const UINT8 *data = W_GetLumpData(lumpnum, PU_STATIC);
 	P_LoadRawSectors(data, W_LumpLength(lumpnum));
-	Z_Free(data);
+	W_ReleaseLumpData(lumpnum, data);
 }
 
 //
 // P_LoadNodes
 //
-static void P_LoadRawNodes(UINT8 *data, size_t i)
+static void P_LoadRawNodes(const UINT8 *data, size_t i)
 {
 	UINT8 j, k;
-	mapnode_t *mn;
+	const mapnode_t *mn;
 	node_t *no;
 
 	numnodes = i / sizeof (mapnode_t);
@@ -776,7 +782,7 @@ static void P_LoadRawNodes(UINT8 *data, size_t i)
 		I_Error("Level has no nodes");
 	nodes = Z_Calloc(numnodes * sizeof (*nodes), PU_LEVEL, NULL);
 
-	mn = (mapnode_t *)data;
+	mn = (const mapnode_t *)data;
 	no = nodes;
 
 	for (i = 0; i < numnodes; i++, no++, mn++)
@@ -796,9 +802,9 @@ static void P_LoadRawNodes(UINT8 *data, size_t i)
 
 static void P_LoadNodes(lumpnum_t lumpnum)
 {
-	UINT8 *data = W_CacheLumpNum(lumpnum, PU_STATIC);
+	const UINT8 *data = W_GetLumpData(lumpnum, PU_STATIC);
 	P_LoadRawNodes(data, W_LumpLength(lumpnum));
-	Z_Free(data);
+	W_ReleaseLumpData(lumpnum, data);
 }
 
 //
@@ -816,7 +822,7 @@ void P_ReloadRings(void)
 	mapthing_t *mt = mapthings;
 
 	// scan the thinkers to find rings/wings/hoops to unset
-	for (th = thinkercap.next; th != &thinkercap; th = th->next)
+	for (th = thlist[THINK_MOBJ].next; th != &thlist[THINK_MOBJ]; th = th->next)
 	{
 		if (th->function.acp1 != (actionf_p1)P_MobjThinker)
 			continue;
@@ -933,7 +939,7 @@ void P_ScanThings(INT16 mapnum, INT16 wadnum, INT16 lumpnum)
 // P_LoadThings
 //
 
-static void P_PrepareRawThings(UINT8 *data, size_t i)
+static void P_PrepareRawThings(const UINT8 *data, size_t i)
 {
 	mapthing_t *mt;
 
@@ -970,9 +976,9 @@ static void P_PrepareRawThings(UINT8 *data, size_t i)
 
 static void P_PrepareThings(lumpnum_t lumpnum)
 {
-	UINT8 *data = W_CacheLumpNum(lumpnum, PU_STATIC);
+	const UINT8 *data = W_GetLumpData(lumpnum, PU_STATIC);
 	P_PrepareRawThings(data, W_LumpLength(lumpnum));
-	Z_Free(data);
+	W_ReleaseLumpData(lumpnum, data);
 }
 
 static void P_LoadThings(void)
@@ -1159,9 +1165,9 @@ void P_WriteThings(lumpnum_t lumpnum)
 	CONS_Printf(M_GetText("newthings%d.lmp saved.\n"), gamemap);
 }
 
-static void P_LoadRawLineDefs(UINT8 *data, size_t i)
+static void P_LoadRawLineDefs(const UINT8 *data, size_t i)
 {
-	maplinedef_t *mld;
+	const maplinedef_t *mld;
 	line_t *ld;
 	vertex_t *v1, *v2;
 
@@ -1170,7 +1176,7 @@ static void P_LoadRawLineDefs(UINT8 *data, size_t i)
 		I_Error("Level has no linedefs");
 	lines = Z_Calloc(numlines * sizeof (*lines), PU_LEVEL, NULL);
 
-	mld = (maplinedef_t *)data;
+	mld = (const maplinedef_t *)data;
 	ld = lines;
 	for (i = 0; i < numlines; i++, mld++, ld++)
 	{
@@ -1268,9 +1274,9 @@ static void P_LoadRawLineDefs(UINT8 *data, size_t i)
 
 static void P_LoadLineDefs(lumpnum_t lumpnum)
 {
-	UINT8 *data = W_CacheLumpNum(lumpnum, PU_STATIC);
+	const UINT8 *data = W_GetLumpData(lumpnum, PU_STATIC);
 	P_LoadRawLineDefs(data, W_LumpLength(lumpnum));
-	Z_Free(data);
+	W_ReleaseLumpData(lumpnum, data);
 }
 
 static void P_LoadLineDefs2(void)
@@ -1387,14 +1393,14 @@ static inline void P_LoadSideDefs(lumpnum_t lumpnum)
 }
 
 
-static void P_LoadRawSideDefs2(void *data)
+static void P_LoadRawSideDefs2(const void *data)
 {
 	UINT16 i;
 	INT32 num;
 
 	for (i = 0; i < numsides; i++)
 	{
-		register mapsidedef_t *msd = (mapsidedef_t *)data + i;
+		register const mapsidedef_t *msd = (const mapsidedef_t *)data + i;
 		register side_t *sd = sides + i;
 		register sector_t *sec;
 
@@ -1456,7 +1462,7 @@ static void P_LoadRawSideDefs2(void *data)
 					if ((msd->toptexture[0] == '#' && msd->toptexture[1] && msd->toptexture[2] && msd->toptexture[3] && msd->toptexture[4] && msd->toptexture[5] && msd->toptexture[6])
 						|| (msd->bottomtexture[0] == '#' && msd->bottomtexture[1] && msd->bottomtexture[2] && msd->bottomtexture[3] && msd->bottomtexture[4] && msd->bottomtexture[5] && msd->bottomtexture[6]))
 					{
-						char *col;
+						const char *col;
 
 						sec->midmap = R_CreateColormap(msd->toptexture, msd->midtexture,
 							msd->bottomtexture);
@@ -1620,7 +1626,7 @@ static void P_LoadRawSideDefs2(void *data)
 			default: // normal cases
 				if (msd->toptexture[0] == '#')
 				{
-					char *col = msd->toptexture;
+					const char *col = msd->toptexture;
 					sd->toptexture = sd->bottomtexture =
 						((col[1]-'0')*100 + (col[2]-'0')*10 + col[3]-'0') + 1;
 					sd->midtexture = R_TextureNumForName(msd->midtexture);
@@ -1640,9 +1646,9 @@ static void P_LoadRawSideDefs2(void *data)
 // Delay loading texture names until after loaded linedefs.
 static void P_LoadSideDefs2(lumpnum_t lumpnum)
 {
-	UINT8 *data = W_CacheLumpNum(lumpnum, PU_STATIC);
+	const UINT8 *data = W_GetLumpData(lumpnum, PU_STATIC);
 	P_LoadRawSideDefs2(data);
-	Z_Free(data);
+	W_ReleaseLumpData(lumpnum, data);
 }
 
 
@@ -1903,7 +1909,7 @@ static void P_CreateBlockMap(void)
 
 // Split from P_LoadBlockMap for convenience
 // -- Monster Iestyn 08/01/18
-static void P_ReadBlockMapLump(INT16 *wadblockmaplump, size_t count)
+static void P_ReadBlockMapLump(const INT16 *wadblockmaplump, size_t count)
 {
 	size_t i;
 	blockmaplump = Z_Calloc(sizeof (*blockmaplump) * count, PU_LEVEL, NULL);
@@ -1951,13 +1957,12 @@ static boolean P_LoadBlockMap(lumpnum_t lumpnum)
 		return false;
 
 	{
-		INT16 *wadblockmaplump = malloc(count); //INT16 *wadblockmaplump = W_CacheLumpNum (lump, PU_LEVEL);
+		const INT16 *wadblockmaplump = W_GetLumpData(lumpnum, PU_STATIC); //INT16 *wadblockmaplump = W_CacheLumpNum (lump, PU_LEVEL);
 		if (!wadblockmaplump)
 			return false;
-		W_ReadLump(lumpnum, wadblockmaplump);
 		count /= 2;
 		P_ReadBlockMapLump(wadblockmaplump, count);
-		free(wadblockmaplump);
+		W_ReleaseLumpData(lumpnum, wadblockmaplump);
 	}
 
 	bmaporgx = blockmaplump[0]<<FRACBITS;
@@ -2002,7 +2007,7 @@ static boolean P_LoadBlockMap(lumpnum_t lumpnum)
 // because making both the WAD and PK3 loading code use
 // the same functions is trickier than it looks for blockmap
 // -- Monster Iestyn 09/01/18
-static boolean P_LoadRawBlockMap(UINT8 *data, size_t count, const char *lumpname)
+static boolean P_LoadRawBlockMap(const UINT8 *data, size_t count, const char *lumpname)
 {
 #if 0
 	(void)data;
@@ -2024,7 +2029,7 @@ static boolean P_LoadRawBlockMap(UINT8 *data, size_t count, const char *lumpname
 
 	// no need to malloc anything, assume the data is uncompressed for now
 	count /= 2;
-	P_ReadBlockMapLump((INT16 *)data, count);
+	P_ReadBlockMapLump((const INT16 *)data, count);
 
 	bmaporgx = blockmaplump[0]<<FRACBITS;
 	bmaporgy = blockmaplump[1]<<FRACBITS;
@@ -2045,6 +2050,85 @@ static boolean P_LoadRawBlockMap(UINT8 *data, size_t count, const char *lumpname
 #endif
 }
 
+//
+// P_CreateBlockLines
+// Packs every block's line list, along with each line's bounding box
+// and what P_BoxOnLineSide needs, into one contiguous array, so that
+// P_BlockLinesIteratorBox can throw out lines that don't touch a box
+// without loading their line_t.
+//
+static void P_CreateBlockLines(void)
+{
+	const size_t numblocks = bmapwidth * bmapheight;
+	const INT32 *list;
+	size_t i, count = 0;
+	blockline_t *bl;
+	line_t *ld;
+
+	if (numlines > UINT16_MAX)
+	{
+		// P_BlockLinesIteratorBox goes through the blockmap instead
+		blocklines = NULL;
+		blocklineoffs = NULL;
+		return;
+	}
+
+	for (i = 0; i < numblocks; i++)
+		for (list = blockmaplump + blockmap[i] + 1; *list != -1; list++)
+			if ((size_t)*list < numlines)
+				count++;
+
+	blocklineoffs = Z_Malloc(sizeof (*blocklineoffs) * (numblocks + 1), PU_LEVEL, NULL);
+	blocklines = Z_Malloc(sizeof (*blocklines) * (count ? count : 1), PU_LEVEL, NULL);
+
+	bl = blocklines;
+	for (i = 0; i < numblocks; i++)
+	{
+		blocklineoffs[i] = (INT32)(bl - blocklines);
+
+		// First index is really empty, so +1 it.
+		for (list = blockmaplump + blockmap[i] + 1; *list != -1; list++)
+		{
+			if ((size_t)*list >= numlines)
+				continue;
+
+			ld = &lines[*list];
+			bl->x1 = (INT16)(ld->v1->x>>FRACBITS);
+			bl->y1 = (INT16)(ld->v1->y>>FRACBITS);
+			bl->x2 = (INT16)(ld->v2->x>>FRACBITS);
+			bl->y2 = (INT16)(ld->v2->y>>FRACBITS);
+			bl->line = (UINT16)*list;
+			bl->slopetype = (SINT8)ld->slopetype;
+			bl++;
+		}
+	}
+	blocklineoffs[numblocks] = (INT32)(bl - blocklines);
+}
+
+//
+// P_UnpinPolyobjBlockLines
+// Polyobject lines move, so the copies made by P_CreateBlockLines go stale.
+// Mark them so they are always handed to the iterator function,
+// which then looks at the real line like before.
+// Called once the polyobjects have been spawned.
+//
+void P_UnpinPolyobjBlockLines(void)
+{
+	blockline_t *bl, *end;
+
+	if (!blocklines)
+		return;
+
+	end = blocklines + blocklineoffs[bmapwidth * bmapheight];
+	for (bl = blocklines; bl < end; bl++)
+	{
+		if (!lines[bl->line].polyobj)
+			continue;
+
+		bl->slopetype = -1;
+	}
+}
+
 //
 // P_GroupLines
 // Builds sector line lists and subsector sector numbers.
@@ -2141,6 +2225,17 @@ static void P_GroupLines(void)
 	}
 }
 
+// Lots of node builders write a REJECT that rejects nothing.
+// Not worth the memory or the lookups; P_CheckSight's sight groups
+// cover what it could have told us anyway.
+static boolean P_RejectIsEmpty(const UINT8 *data, size_t count)
+{
+	while (count--)
+		if (*data++)
+			return false;
+	return true;
+}
+
 //
 // P_LoadReject
 //
@@ -2174,13 +2269,21 @@ static void P_LoadReject(lumpnum_t lumpnum)
 	}
 #else
 	else
+	{
 		rejectmatrix = W_CacheLumpNum(lumpnum, PU_LEVEL);
+		if (P_RejectIsEmpty(rejectmatrix, count))
+		{
+			Z_ChangeTag(rejectmatrix, PU_CACHE);
+			rejectmatrix = NULL;
+			CONS_Debug(DBG_SETUP, "P_LoadReject: REJECT lump is empty, will not be used\n");
+		}
+	}
 #endif
 }
 
 // PK3 version
 // -- Monster Iestyn 09/01/18
-static void P_LoadRawReject(UINT8 *data, size_t count, const char *lumpname)
+static void P_LoadRawReject(const UINT8 *data, size_t count, const char *lumpname)
 {
 	// Check if the lump is named "REJECT"
 	if (!lumpname || memcmp(lumpname, "REJECT\0\0", 8) != 0)
@@ -2201,6 +2304,12 @@ static void P_LoadRawReject(UINT8 *data, size_t count, const char *lumpname)
 		rejectmatrix = NULL;
 		CONS_Debug(DBG_SETUP, "P_LoadRawReject: Skipping %s byte REJECT lump on 3DS\n", sizeu1(count));
 #else
+		if (P_RejectIsEmpty(data, count))
+		{
+			rejectmatrix = NULL;
+			CONS_Debug(DBG_SETUP, "P_LoadRawReject: REJECT lump is empty, will not be used\n");
+			return;
+		}
 		rejectmatrix = Z_Malloc(count, PU_LEVEL, NULL); // allocate memory for the reject matrix
 		M_Memcpy(rejectmatrix, data, count); // copy the data into it
 #endif
@@ -2373,7 +2482,7 @@ void P_LoadThingsOnly(void)
 	mobj_t *mo;
 	thinker_t *think;
 
-	for (think = thinkercap.next; think != &thinkercap; think = think->next)
+	for (think = thlist[THINK_MOBJ].next; think != &thlist[THINK_MOBJ]; think = think->next)
 	{
 		if (think->function.acp1 != (actionf_p1)P_MobjThinker)
 			continue; // not a mobj thinker
@@ -2388,11 +2497,11 @@ void P_LoadThingsOnly(void)
 
 	if (W_IsLumpWad(lastloadedmaplumpnum)) // welp it's a map wad in a pk3
 	{ // HACK: Open wad file rather quickly so we can use the things lump
-		UINT8 *wadData = W_CacheLumpNum(lastloadedmaplumpnum, PU_STATIC);
-		filelump_t *fileinfo = (filelump_t *)(wadData + ((wadinfo_t *)wadData)->infotableofs);
+		const UINT8 *wadData = W_GetLumpData(lastloadedmaplumpnum, PU_STATIC);
+		const filelump_t *fileinfo = (const filelump_t *)(wadData + ((const wadinfo_t *)wadData)->infotableofs);
 		fileinfo += ML_THINGS; // we only need the THINGS lump
 		P_PrepareRawThings(wadData + fileinfo->filepos, fileinfo->size);
-		Z_Free(wadData); // we're done with this now
+		W_ReleaseLumpData(lastloadedmaplumpnum, wadData); // we're done with this now
 	}
 	else // phew it's just a WAD
 		P_PrepareThings(lastloadedmaplumpnum + ML_THINGS);
@@ -2427,6 +2536,26 @@ static INT32 P_MakeBufferMD5(const char *buffer, size_t len, void *resblock)
 #endif
 }
 
+// Starts reading the map lumps in the background,
+// in the order P_MakeMapMD5 and the P_Load* functions get to them.
+static void P_PrefetchMapLumps(lumpnum_t maplumpnum)
+{
+	static const UINT8 order[] = {
+		ML_LINEDEFS, ML_SECTORS, ML_THINGS, ML_SIDEDEFS, // P_MakeMapMD5
+		ML_BLOCKMAP, ML_VERTEXES, ML_SSECTORS, ML_NODES, ML_SEGS, ML_REJECT
+	};
+	size_t i;
+
+	if (W_IsLumpWad(maplumpnum)) // map wad in a pk3, read as a whole
+	{
+		W_PrefetchLumpNum(maplumpnum);
+		return;
+	}
+
+	for (i = 0; i < sizeof order; i++)
+		W_PrefetchLumpNum(maplumpnum + order[i]);
+}
+
 static void P_MakeMapMD5(lumpnum_t maplumpnum, void *dest)
 {
 	unsigned char linemd5[16];
@@ -2438,20 +2567,20 @@ static void P_MakeMapMD5(lumpnum_t maplumpnum, void *dest)
 
 	// Create a hash for the current map
 	// get the actual lumps!
-	UINT8 *datalines   = W_CacheLumpNum(maplumpnum + ML_LINEDEFS, PU_CACHE);
-	UINT8 *datasectors = W_CacheLumpNum(maplumpnum + ML_SECTORS, PU_CACHE);
-	UINT8 *datathings  = W_CacheLumpNum(maplumpnum + ML_THINGS, PU_CACHE);
-	UINT8 *datasides   = W_CacheLumpNum(maplumpnum + ML_SIDEDEFS, PU_CACHE);
+	const UINT8 *datalines   = W_GetLumpData(maplumpnum + ML_LINEDEFS, PU_CACHE);
+	const UINT8 *datasectors = W_GetLumpData(maplumpnum + ML_SECTORS, PU_CACHE);
+	const UINT8 *datathings  = W_GetLumpData(maplumpnum + ML_THINGS, PU_CACHE);
+	const UINT8 *datasides   = W_GetLumpData(maplumpnum + ML_SIDEDEFS, PU_CACHE);
 
-	P_MakeBufferMD5((char*)datalines,   W_LumpLength(maplumpnum + ML_LINEDEFS), linemd5);
-	P_MakeBufferMD5((char*)datasectors, W_LumpLength(maplumpnum + ML_SECTORS),  sectormd5);
-	P_MakeBufferMD5((char*)datathings,  W_LumpLength(maplumpnum + ML_THINGS),   thingmd5);
-	P_MakeBufferMD5((char*)datasides,   W_LumpLength(maplumpnum + ML_SIDEDEFS), sidedefmd5);
+	P_MakeBufferMD5((const char*)datalines,   W_LumpLength(maplumpnum + ML_LINEDEFS), linemd5);
+	P_MakeBufferMD5((const char*)datasectors, W_LumpLength(maplumpnum + ML_SECTORS),  sectormd5);
+	P_MakeBufferMD5((const char*)datathings,  W_LumpLength(maplumpnum + ML_THINGS),   thingmd5);
+	P_MakeBufferMD5((const char*)datasides,   W_LumpLength(maplumpnum + ML_SIDEDEFS), sidedefmd5);
 
-	Z_Free(datalines);
-	Z_Free(datasectors);
-	Z_Free(datathings);
-	Z_Free(datasides);
+	W_ReleaseLumpData(maplumpnum + ML_LINEDEFS, datalines);
+	W_ReleaseLumpData(maplumpnum + ML_SECTORS, datasectors);
+	W_ReleaseLumpData(maplumpnum + ML_THINGS, datathings);
+	W_ReleaseLumpData(maplumpnum + ML_SIDEDEFS, datasides);
 
 	for (i = 0; i < 16; i++)
 		resmd5[i] = (linemd5[i] + sectormd5[i] + thingmd5[i] + sidedefmd5[i]) & 0xFF;
@@ -2863,6 +2992,8 @@ boolean P_SetupLevel(boolean skipprecip)
 	if (lastloadedmaplumpnum == INT16_MAX)
 		I_Error("Map %s not found.\n", maplumpname);
 
+	P_PrefetchMapLumps(lastloadedmaplumpnum);
+
 	R_ReInitColormaps(mapheaderinfo[gamemap-1]->palette);
 	CON_SetupBackColormap();
 
@@ -2878,10 +3009,10 @@ boolean P_SetupLevel(boolean skipprecip)
 	if (W_IsLumpWad(lastloadedmaplumpnum))
 	{
 		// Remember that we're assuming that the WAD will have a specific set of lumps in a specific order.
-		UINT8 *wadData = W_CacheLumpNum(lastloadedmaplumpnum, PU_STATIC);
+		const UINT8 *wadData = W_GetLumpData(lastloadedmaplumpnum, PU_STATIC);
 		//filelump_t *fileinfo = wadData + ((wadinfo_t *)wadData)->infotableofs;
-		filelump_t *fileinfo = (filelump_t *)(wadData + ((wadinfo_t *)wadData)->infotableofs);
-		UINT32 numlumps = ((wadinfo_t *)wadData)->numlumps;
+		const filelump_t *fileinfo = (const filelump_t *)(wadData + ((const wadinfo_t *)wadData)->infotableofs);
+		UINT32 numlumps = ((const wadinfo_t *)wadData)->numlumps;
 
 		if (numlumps < ML_REJECT) // at least 9 lumps should be in the wad for a map to be loaded
 		{
@@ -2915,7 +3046,9 @@ boolean P_SetupLevel(boolean skipprecip)
 		if (!loadedbm)
 			P_CreateBlockMap(); // Graue 02-29-2004
 		P_LoadLineDefs2();
+		P_CreateBlockLines();
 		P_GroupLines();
+		P_InitSightGroups();
 		numdmstarts = numredctfstarts = numbluectfstarts = 0;
 
 		// reset the player starts
@@ -2926,7 +3059,7 @@ boolean P_SetupLevel(boolean skipprecip)
 		P_MapStart();
 
 		P_PrepareRawThings(wadData + (fileinfo + ML_THINGS)->filepos, (fileinfo + ML_THINGS)->size);
-		Z_Free(wadData);
+		W_ReleaseLumpData(lastloadedmaplumpnum, wadData);
 	}
 	else
 	{
@@ -2947,7 +3080,9 @@ boolean P_SetupLevel(boolean skipprecip)
 			P_CreateBlockMap(); // Graue 02-29-2004
 
 		P_LoadLineDefs2();
+		P_CreateBlockLines();
 		P_GroupLines();
+		P_InitSightGroups();
 		numdmstarts = numredctfstarts = numbluectfstarts = 0;
 
 		// reset the player starts
@@ -2979,6 +3114,8 @@ boolean P_SetupLevel(boolean skipprecip)
 
 	globalweather = mapheaderinfo[gamemap-1]->weather;
 
+	S_QueueLevelSounds(); // read in the background while the level loads
+
 #ifdef HWRENDER // not win32 only 19990829 by Kin
 	if (rendermode != render_soft && rendermode != render_none)
 	{
@@ -3173,6 +3310,9 @@ boolean P_SetupLevel(boolean skipprecip)
 	if (!(netgame || multiplayer) && (!modifiedgame || savemoddata))
 		mapvisited[gamemap-1] |= MV_VISITED;
 
+	S_PrecacheLevelSounds();
+
+	W_FlushPrefetches(); // whatever wasn't read by now won't be
 	levelloading = false;
 
 	P_RunCachedActions();
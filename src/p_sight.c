@@ -16,6 +16,9 @@
 #include "p_local.h"
 #include "r_main.h"
 #include "r_state.h"
+#include "command.h"
+#include "console.h"
+#include "z_zone.h"
 
 //
 // P_CheckSight
@@ -30,7 +33,115 @@ typedef struct {
 	fixed_t bbox[4];
 } los_t;
 
-static INT32 sightcounts[2];
+// Counters for the "sightstats" command
+static struct
+{
+	UINT32 checks; // calls to P_CheckSight
+	UINT32 memohits; // answered from the memo
+	UINT32 rejected; // ruled out by REJECT or the sight groups
+	UINT32 traversals; // had to walk the BSP
+	UINT32 visible;
+} sightstats;
+
+// Sight groups: sectors joined by two-sided lines, directly or through
+// other sectors, get the same group. Sight can only pass through two-sided
+// lines, so things in different groups can never see each other. This
+// replaces REJECT when a map has none (or on the handheld builds, which
+// don't load it), at a fraction of the memory: one entry per sector.
+// NULL when the whole map is one group.
+static UINT16 *sightgroups = NULL;
+
+// Memo of sight results. Two checks with the same things at the same
+// positions and heights get the same answer, as long as the level geometry
+// is the same. Sector heights are written all over the place (movers,
+// linedef executors, Lua), so rather than trusting each of those to call
+// P_InvalidateSightMemo, the memo only lasts for one thinker's turn:
+// P_RunThinkers and P_PlayerThink bump sightepoch before each one. Repeat
+// checks of the same pair mostly come from one thing's actions anyway.
+#define SIGHTMEMOSIZE 256 // power of two
+
+typedef struct
+{
+	const mobj_t *t1, *t2;
+	fixed_t x1, y1, z1, h1;
+	fixed_t x2, y2, z2, h2;
+	tic_t tic;
+	UINT32 epoch;
+	boolean result;
+} sightmemo_t;
+
+static sightmemo_t sightmemo[SIGHTMEMOSIZE];
+static UINT32 sightepoch = 1;
+
+/** \brief Forgets every remembered sight check.
+
+	Called before every thinker runs, and wherever sector heights,
+	3D floors or polyobjects change.
+*/
+void P_InvalidateSightMemo(void)
+{
+	sightepoch++;
+}
+
+static UINT16 P_FindSightGroup(UINT16 *parent, UINT16 i)
+{
+	while (parent[i] != i)
+		i = parent[i] = parent[parent[i]];
+	return i;
+}
+
+/** \brief Works out the sight groups of the current level's sectors.
+
+	Call once the lines have their front and back sectors.
+*/
+void P_InitSightGroups(void)
+{
+	UINT16 *parent;
+	size_t i, groups;
+
+	P_InvalidateSightMemo();
+	sightgroups = NULL;
+	if (!numsectors || numsectors > UINT16_MAX)
+		return;
+
+	parent = Z_Malloc(numsectors * sizeof (*parent), PU_LEVEL, NULL);
+	for (i = 0; i < numsectors; i++)
+		parent[i] = (UINT16)i;
+
+	groups = numsectors;
+	for (i = 0; i < numlines; i++)
+	{
+		UINT16 a, b;
+		if (!lines[i].frontsector || !lines[i].backsector)
+			continue;
+		a = P_FindSightGroup(parent, (UINT16)(lines[i].frontsector - sectors));
+		b = P_FindSightGroup(parent, (UINT16)(lines[i].backsector - sectors));
+		if (a != b)
+		{
+			parent[max(a, b)] = min(a, b);
+			groups--;
+		}
+	}
+
+	if (groups == 1)
+	{
+		Z_Free(parent);
+		return;
+	}
+
+	for (i = 0; i < numsectors; i++)
+		parent[i] = P_FindSightGroup(parent, (UINT16)i);
+	sightgroups = parent;
+	CONS_Debug(DBG_SETUP, "P_InitSightGroups: %s sight groups\n", sizeu1(groups));
+}
+
+static boolean P_CheckSightUncached(mobj_t *t1, mobj_t *t2);
+
+static inline sightmemo_t *P_SightMemoSlot(const mobj_t *t1, const mobj_t *t2)
+{
+	const size_t h = ((size_t)t1 >> 3) * 31 + ((size_t)t2 >> 3);
+	return &sightmemo[(h ^ (h >> 8)) & (SIGHTMEMOSIZE-1)];
+}
 
 //
 // P_DivlineSide
@@ -306,14 +417,49 @@ static boolean P_CrossBSPNode(INT32 bspnum, register los_t *los)
 //
 boolean P_CheckSight(mobj_t *t1, mobj_t *t2)
 {
-	const sector_t *s1, *s2;
-	size_t pnum;
-	los_t los;
+	sightmemo_t *memo;
+
+	sightstats.checks++;
 
-	// First check for trivial rejection.
 	if (!t1 || !t2)
 		return false;
 
+	memo = P_SightMemoSlot(t1, t2);
+	if (memo->tic == leveltime && memo->epoch == sightepoch
+	&& memo->t1 == t1 && memo->t2 == t2
+	&& memo->x1 == t1->x && memo->y1 == t1->y && memo->z1 == t1->z && memo->h1 == t1->height
+	&& memo->x2 == t2->x && memo->y2 == t2->y && memo->z2 == t2->z && memo->h2 == t2->height)
+	{
+		sightstats.memohits++;
+		if (memo->result)
+			sightstats.visible++;
+		return memo->result;
+	}
+
+	memo->result = P_CheckSightUncached(t1, t2);
+	memo->t1 = t1;
+	memo->t2 = t2;
+	memo->x1 = t1->x;
+	memo->y1 = t1->y;
+	memo->z1 = t1->z;
+	memo->h1 = t1->height;
+	memo->x2 = t2->x;
+	memo->y2 = t2->y;
+	memo->z2 = t2->z;
+	memo->h2 = t2->height;
+	memo->tic = leveltime;
+	memo->epoch = sightepoch;
+	if (memo->result)
+		sightstats.visible++;
+	return memo->result;
+}
+
+static boolean P_CheckSightUncached(mobj_t *t1, mobj_t *t2)
+{
+	const sector_t *s1, *s2;
+	size_t pnum;
+	los_t los;
+
 	I_Assert(!P_MobjWasRemoved(t1));
 	I_Assert(!P_MobjWasRemoved(t2));
 
@@ -329,7 +475,16 @@ boolean P_CheckSight(mobj_t *t1, mobj_t *t2)
 	{
 		// Check in REJECT table.
 		if (rejectmatrix[pnum>>3] & (1 << (pnum&7))) // can't possibly be connected
+		{
+			sightstats.rejected++;
 			return false;
+		}
+	}
+
+	if (sightgroups && sightgroups[s1-sectors] != sightgroups[s2-sectors])
+	{
+		sightstats.rejected++;
+		return false;
 	}
 
 	// killough 11/98: shortcut for melee situations
@@ -346,7 +501,7 @@ boolean P_CheckSight(mobj_t *t1, mobj_t *t2)
 
 	// An unobstructed LOS is possible.
 	// Now look from eyes of t1 to any part of t2.
-	sightcounts[1]++;
+	sightstats.traversals++;
 
 	validcount++;
 
@@ -421,3 +576,23 @@ boolean P_CheckSight(mobj_t *t1, mobj_t *t2)
 	// the head node is the last node output
 	return P_CrossBSPNode((INT32)numnodes - 1, &los);
 }
+
+/** \brief The "sightstats" command: how P_CheckSight calls were answered.
+*/
+void Command_Sightstats_f(void)
+{
+	const double checks = sightstats.checks ? (double)sightstats.checks : 1.0;
+
+	if (COM_Argc() > 1 && !stricmp(COM_Argv(1), "reset"))
+	{
+		memset(&sightstats, 0, sizeof(sightstats));
+		return;
+	}
+
+	CONS_Printf("%u sight checks, %u visible\n", sightstats.checks, sightstats.visible);
+	CONS_Printf("  memo hits:  %u (%.1f%%)\n", sightstats.memohits, 100.0 * sightstats.memohits / checks);
+	CONS_Printf("  rejected:   %u (%.1f%%)\n", sightstats.rejected, 100.0 * sightstats.rejected / checks);
+	CONS_Printf("  BSP walks:  %u (%.1f%%)\n", sightstats.traversals, 100.0 * sightstats.traversals / checks);
+	CONS_Printf("REJECT %s, %s\n", rejectmatrix ? "loaded" : "not loaded",
+		sightgroups ? "sight groups in use" : "map is a single sight group");
+}
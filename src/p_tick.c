@@ -25,9 +25,8 @@
 // Object place
 #include "m_cheat.h"
 
-#ifdef __3DS__
-#include <3ds.h>
-#endif
+#include "i_system.h" // I_GetPreciseTime
+#include "dehacked.h" // DEH_MobjTypeName
 
 tic_t leveltime;
 
@@ -39,8 +38,10 @@ tic_t leveltime;
 // but the first element must be thinker_t.
 //
 
-// Both the head and tail of the thinker list.
-thinker_t thinkercap;
+// Both the head and tail of each thinker list.
+// Thinkers are kept on separate lists by kind, so that code looking
+// for mobjs (or for sector specials) never has to walk the others.
+thinker_t thlist[NUM_THINKERLISTS];
 
 void Command_Numthinkers_f(void)
 {
@@ -48,6 +49,7 @@ void Command_Numthinkers_f(void)
 	INT32 count = 0;
 	actionf_p1 action;
 	thinker_t *think;
+	thinklistnum_t start = 0, end = NUM_THINKERLISTS - 1, i;
 
 	if (gamestate != GS_LEVEL)
 	{
@@ -74,6 +76,7 @@ void Command_Numthinkers_f(void)
 	switch (num)
 	{
 		case 1:
+			start = end = THINK_MOBJ;
 			action = (actionf_p1)P_MobjThinker;
 			CONS_Printf(M_GetText("Number of %s: "), "P_MobjThinker");
 			break;
@@ -86,14 +89,17 @@ void Command_Numthinkers_f(void)
 			CONS_Printf(M_GetText("Number of %s: "), "P_SnowThinker");
 			break;*/
 		case 2:
+			start = end = THINK_PRECIP;
 			action = (actionf_p1)P_NullPrecipThinker;
 			CONS_Printf(M_GetText("Number of %s: "), "P_NullPrecipThinker");
 			break;
 		case 3:
+			start = end = THINK_MAIN;
 			action = (actionf_p1)T_Friction;
 			CONS_Printf(M_GetText("Number of %s: "), "T_Friction");
 			break;
 		case 4:
+			start = end = THINK_MAIN;
 			action = (actionf_p1)T_Pusher;
 			CONS_Printf(M_GetText("Number of %s: "), "T_Pusher");
 			break;
@@ -106,12 +112,15 @@ void Command_Numthinkers_f(void)
 			return;
 	}
 
-	for (think = thinkercap.next; think != &thinkercap; think = think->next)
+	for (i = start; i <= end; i++)
 	{
-		if (think->function.acp1 != action)
-			continue;
+		for (think = thlist[i].next; think != &thlist[i]; think = think->next)
+		{
+			if (think->function.acp1 != action)
+				continue;
 
-		count++;
+			count++;
+		}
 	}
 
 	CONS_Printf("%d\n", count);
@@ -143,7 +152,7 @@ void Command_CountMobjs_f(void)
 
 			count = 0;
 
-			for (th = thinkercap.next; th != &thinkercap; th = th->next)
+			for (th = thlist[THINK_MOBJ].next; th != &thlist[THINK_MOBJ]; th = th->next)
 			{
 				if (th->function.acp1 != (actionf_p1)P_MobjThinker)
 					continue;
@@ -163,7 +172,7 @@ void Command_CountMobjs_f(void)
 	{
 		count = 0;
 
-		for (th = thinkercap.next; th != &thinkercap; th = th->next)
+		for (th = thlist[THINK_MOBJ].next; th != &thlist[THINK_MOBJ]; th = th->next)
 		{
 			if (th->function.acp1 != (actionf_p1)P_MobjThinker)
 				continue;
@@ -182,7 +191,9 @@ void Command_CountMobjs_f(void)
 //
 void P_InitThinkers(void)
 {
-	thinkercap.prev = thinkercap.next = &thinkercap;
+	UINT8 i;
+	for (i = 0; i < NUM_THINKERLISTS; i++)
+		thlist[i].prev = thlist[i].next = &thlist[i];
 #ifdef __3DS__
 	P_ResetDisappearBatch(); // PU_LEVEL freed our array; reset before new disappears register
 #endif
@@ -190,14 +201,14 @@ void P_InitThinkers(void)
 
 //
 // P_AddThinker
-// Adds a new thinker at the end of the list.
+// Adds a new thinker at the end of list n.
 //
-void P_AddThinker(thinker_t *thinker)
+void P_AddThinker(const thinklistnum_t n, thinker_t *thinker)
 {
-	thinkercap.prev->next = thinker;
-	thinker->next = &thinkercap;
-	thinker->prev = thinkercap.prev;
-	thinkercap.prev = thinker;
+	thlist[n].prev->next = thinker;
+	thinker->next = &thlist[n];
+	thinker->prev = thlist[n].prev;
+	thlist[n].prev = thinker;
 
 	thinker->references = 0;    // killough 11/98: init reference counter to 0
 }
@@ -253,7 +264,7 @@ void P_RemoveThinkerDelayed(void *pthinker)
 void P_RemoveThinker(thinker_t *thinker)
 {
 #ifdef HAVE_BLUA
-	LUA_InvalidateUserdata(thinker);
+	LUA_InvalidateThinker(thinker);
 #endif
 	thinker->function.acp1 = P_RemoveThinkerDelayed;
 }
@@ -279,74 +290,79 @@ if ((*mop = targ) != NULL) // Set new target and if non-NULL, increase its count
 	return targ;
 }
 
-#ifdef __3DS__
 // Per-thinker-type CPU profiler. Toggled by the "thinkertimes" console
-// command. Times each thinker call via svcGetSystemTick() and bins by
-// function pointer. Prints one line per non-zero bucket every wall second.
+// command. Times each thinker call via I_GetPreciseTime() and bins by
+// function pointer. Prints one line per non-zero bucket every wall second,
+// and keeps running totals that "thinkertimes csv <file>" writes out.
+// -thinkerprof <file> does the same for a whole demo playback, quietly,
+// so "-timedemo <demo> -nodraw -thinkerprof <file>" profiles headless.
 // When disabled, the profiled loop is skipped entirely (zero overhead).
 
-#define TPROF_TICKS_PER_SEC 268111856ULL // ARM11 CP15 timer rate
-
 typedef struct
 {
 	const char *name;
 	actionf_p1 fn;
-	u64 acc_ticks;
-	u32 calls;
+	precise_t acc_ticks;
+	UINT32 calls;
+	precise_t total_ticks; // everything since profiling was turned on
+	UINT64 total_calls;
 } thinker_bucket_t;
 
 static thinker_bucket_t thinker_buckets[] = {
-	{ "P_MobjThinker         ", (actionf_p1)P_MobjThinker,          0, 0 },
-	{ "P_NullPrecipThinker   ", (actionf_p1)P_NullPrecipThinker,    0, 0 },
-	{ "T_Friction            ", (actionf_p1)T_Friction,             0, 0 },
-	{ "T_Pusher              ", (actionf_p1)T_Pusher,               0, 0 },
-	{ "T_Scroll              ", (actionf_p1)T_Scroll,               0, 0 },
-	{ "T_MoveFloor           ", (actionf_p1)T_MoveFloor,            0, 0 },
-	{ "T_MoveCeiling         ", (actionf_p1)T_MoveCeiling,          0, 0 },
-	{ "T_MoveElevator        ", (actionf_p1)T_MoveElevator,         0, 0 },
-	{ "T_StartCrumble        ", (actionf_p1)T_StartCrumble,         0, 0 },
-	{ "T_BounceCheese        ", (actionf_p1)T_BounceCheese,         0, 0 },
-	{ "T_FloatSector         ", (actionf_p1)T_FloatSector,          0, 0 },
-	{ "T_RaiseSector         ", (actionf_p1)T_RaiseSector,          0, 0 },
-	{ "T_ContinuousFalling   ", (actionf_p1)T_ContinuousFalling,    0, 0 },
-	{ "T_SpikeSector         ", (actionf_p1)T_SpikeSector,          0, 0 },
-	{ "T_NoEnemiesSector     ", (actionf_p1)T_NoEnemiesSector,      0, 0 },
-	{ "T_EachTimeThinker     ", (actionf_p1)T_EachTimeThinker,      0, 0 },
-	{ "T_FireFlicker         ", (actionf_p1)T_FireFlicker,          0, 0 },
-	{ "T_LightningFlash      ", (actionf_p1)T_LightningFlash,       0, 0 },
-	{ "T_StrobeFlash         ", (actionf_p1)T_StrobeFlash,          0, 0 },
-	{ "T_Glow                ", (actionf_p1)T_Glow,                 0, 0 },
-	{ "T_LightFade           ", (actionf_p1)T_LightFade,            0, 0 },
-	{ "T_LaserFlash          ", (actionf_p1)T_LaserFlash,           0, 0 },
-	{ "T_Disappear           ", (actionf_p1)T_Disappear,            0, 0 },
-	{ "T_PolyObjRotate       ", (actionf_p1)T_PolyObjRotate,        0, 0 },
-	{ "T_PolyObjMove         ", (actionf_p1)T_PolyObjMove,          0, 0 },
-	{ "T_PolyObjWaypoint     ", (actionf_p1)T_PolyObjWaypoint,      0, 0 },
-	{ "T_PolyObjDisplace     ", (actionf_p1)T_PolyObjDisplace,      0, 0 },
-	{ "T_PolyObjFlag         ", (actionf_p1)T_PolyObjFlag,          0, 0 },
-	{ "P_RemoveThinkerDelayed", (actionf_p1)P_RemoveThinkerDelayed, 0, 0 },
+	{ "P_MobjThinker",          (actionf_p1)P_MobjThinker,          0, 0, 0, 0 },
+	{ "P_NullPrecipThinker",    (actionf_p1)P_NullPrecipThinker,    0, 0, 0, 0 },
+	{ "T_Friction",             (actionf_p1)T_Friction,             0, 0, 0, 0 },
+	{ "T_Pusher",               (actionf_p1)T_Pusher,               0, 0, 0, 0 },
+	{ "T_Scroll",               (actionf_p1)T_Scroll,               0, 0, 0, 0 },
+	{ "T_MoveFloor",            (actionf_p1)T_MoveFloor,            0, 0, 0, 0 },
+	{ "T_MoveCeiling",          (actionf_p1)T_MoveCeiling,          0, 0, 0, 0 },
+	{ "T_MoveElevator",         (actionf_p1)T_MoveElevator,         0, 0, 0, 0 },
+	{ "T_StartCrumble",         (actionf_p1)T_StartCrumble,         0, 0, 0, 0 },
+	{ "T_BounceCheese",         (actionf_p1)T_BounceCheese,         0, 0, 0, 0 },
+	{ "T_FloatSector",          (actionf_p1)T_FloatSector,          0, 0, 0, 0 },
+	{ "T_RaiseSector",          (actionf_p1)T_RaiseSector,          0, 0, 0, 0 },
+	{ "T_ContinuousFalling",    (actionf_p1)T_ContinuousFalling,    0, 0, 0, 0 },
+	{ "T_SpikeSector",          (actionf_p1)T_SpikeSector,          0, 0, 0, 0 },
+	{ "T_NoEnemiesSector",      (actionf_p1)T_NoEnemiesSector,      0, 0, 0, 0 },
+	{ "T_EachTimeThinker",      (actionf_p1)T_EachTimeThinker,      0, 0, 0, 0 },
+	{ "T_FireFlicker",          (actionf_p1)T_FireFlicker,          0, 0, 0, 0 },
+	{ "T_LightningFlash",       (actionf_p1)T_LightningFlash,       0, 0, 0, 0 },
+	{ "T_StrobeFlash",          (actionf_p1)T_StrobeFlash,          0, 0, 0, 0 },
+	{ "T_Glow",                 (actionf_p1)T_Glow,                 0, 0, 0, 0 },
+	{ "T_LightFade",            (actionf_p1)T_LightFade,            0, 0, 0, 0 },
+	{ "T_LaserFlash",           (actionf_p1)T_LaserFlash,           0, 0, 0, 0 },
+	{ "T_Disappear",            (actionf_p1)T_Disappear,            0, 0, 0, 0 },
+	{ "T_PolyObjRotate",        (actionf_p1)T_PolyObjRotate,        0, 0, 0, 0 },
+	{ "T_PolyObjMove",          (actionf_p1)T_PolyObjMove,          0, 0, 0, 0 },
+	{ "T_PolyObjWaypoint",      (actionf_p1)T_PolyObjWaypoint,      0, 0, 0, 0 },
+	{ "T_PolyObjDisplace",      (actionf_p1)T_PolyObjDisplace,      0, 0, 0, 0 },
+	{ "T_PolyObjFlag",          (actionf_p1)T_PolyObjFlag,          0, 0, 0, 0 },
+	{ "P_RemoveThinkerDelayed", (actionf_p1)P_RemoveThinkerDelayed, 0, 0, 0, 0 },
 };
 #define NUM_THINKER_BUCKETS (sizeof(thinker_buckets) / sizeof(thinker_buckets[0]))
 
-static u64 thinker_other_acc = 0;
-static u32 thinker_other_calls = 0;
-static u64 thinker_window_start = 0;
-static u32 thinker_window_tics = 0;
+static precise_t thinker_other_acc = 0;
+static UINT32 thinker_other_calls = 0;
+static precise_t thinker_other_total = 0;
+static UINT64 thinker_other_total_calls = 0;
+static precise_t thinker_window_start = 0;
+static UINT32 thinker_window_tics = 0;
+static UINT64 thinker_total_tics = 0;
 boolean thinker_prof_enabled = false;
 static boolean thinker_prof_started = false;
+static boolean thinker_prof_quiet = false; // no once/sec printing
+static char *thinker_prof_demofile = NULL; // -thinkerprof output
 
 // Per-mobj-type sub-profiler. P_MobjThinker is the dominant bucket in
 // thinker_buckets; this drills one level deeper to see which mobj->type
-// values eat the time. Sized to NUMMOBJTYPES (~700 entries, ~8KB total).
-static u64 mobjtype_acc[NUMMOBJTYPES];
-static u32 mobjtype_calls[NUMMOBJTYPES];
-
-unsigned long long P_MobjProfNow(void)
-{
-	return svcGetSystemTick();
-}
-
-void P_MobjProfHit(INT32 type, unsigned long long dt_ticks)
+// values eat the time. Sized to NUMMOBJTYPES, once for the current
+// window and once for the running totals.
+static precise_t mobjtype_acc[NUMMOBJTYPES];
+static UINT32 mobjtype_calls[NUMMOBJTYPES];
+static precise_t mobjtype_total[NUMMOBJTYPES];
+static UINT64 mobjtype_total_calls[NUMMOBJTYPES];
+
+void P_MobjProfHit(INT32 type, precise_t dt_ticks)
 {
 	if ((unsigned)type >= NUMMOBJTYPES)
 		return;
@@ -354,6 +370,7 @@ void P_MobjProfHit(INT32 type, unsigned long long dt_ticks)
 	mobjtype_calls[type]++;
 }
 
+#ifdef __3DS__
 // Player position cache used by P_MobjThinker's distance gate.
 INT32 mp_active_count;
 fixed_t mp_active_x[MAXPLAYERS];
@@ -372,8 +389,9 @@ static void P_RefreshPlayerCache(void)
 		mp_active_count++;
 	}
 }
+#endif
 
-static void P_ResetThinkerProfile(u64 now)
+static void P_ResetThinkerProfile(precise_t now)
 {
 	size_t i;
 	for (i = 0; i < NUM_THINKER_BUCKETS; i++)
@@ -389,14 +407,49 @@ static void P_ResetThinkerProfile(u64 now)
 	memset(mobjtype_calls, 0, sizeof(mobjtype_calls));
 }
 
+// Adds the current window to the running totals, then starts a new one.
+static void P_FoldThinkerProfile(precise_t now)
+{
+	size_t i;
+	for (i = 0; i < NUM_THINKER_BUCKETS; i++)
+	{
+		thinker_buckets[i].total_ticks += thinker_buckets[i].acc_ticks;
+		thinker_buckets[i].total_calls += thinker_buckets[i].calls;
+	}
+	thinker_other_total += thinker_other_acc;
+	thinker_other_total_calls += thinker_other_calls;
+	thinker_total_tics += thinker_window_tics;
+	for (i = 0; i < NUMMOBJTYPES; i++)
+	{
+		mobjtype_total[i] += mobjtype_acc[i];
+		mobjtype_total_calls[i] += mobjtype_calls[i];
+	}
+	P_ResetThinkerProfile(now);
+}
+
+static void P_ClearThinkerProfile(void)
+{
+	size_t i;
+	for (i = 0; i < NUM_THINKER_BUCKETS; i++)
+	{
+		thinker_buckets[i].total_ticks = 0;
+		thinker_buckets[i].total_calls = 0;
+	}
+	thinker_other_total = 0;
+	thinker_other_total_calls = 0;
+	thinker_total_tics = 0;
+	memset(mobjtype_total, 0, sizeof(mobjtype_total));
+	memset(mobjtype_total_calls, 0, sizeof(mobjtype_total_calls));
+	thinker_prof_started = false; // first profiled tic starts the window
+}
+
 #define MOBJTYPE_TOPN 12
-static void P_PrintMobjTypeTop(u32 tics)
+static void P_PrintMobjTypeTop(UINT32 tics)
 {
 	INT32 top[MOBJTYPE_TOPN];
 	int n = 0;
 	INT32 i;
 	int j;
-	(void)tics;
 	for (i = 0; i < (INT32)NUMMOBJTYPES; i++)
 	{
 		if (mobjtype_calls[i] == 0)
@@ -423,7 +476,7 @@ static void P_PrintMobjTypeTop(u32 tics)
 	for (j = 0; j < n; j++)
 	{
 		INT32 t = top[j];
-		u64 ms_x100 = mobjtype_acc[t] * 100000ULL / TPROF_TICKS_PER_SEC;
+		UINT64 ms_x100 = I_PreciseToMicros(mobjtype_acc[t]) / 10;
 		CONS_Printf("  MT %3d : %3u.%02u ms  (%u/tic)\n",
 			(int)t,
 			(unsigned)(ms_x100 / 100), (unsigned)(ms_x100 % 100),
@@ -434,29 +487,82 @@ static void P_PrintMobjTypeTop(u32 tics)
 static void P_PrintThinkerProfile(void)
 {
 	size_t i;
-	u32 tics = thinker_window_tics ? thinker_window_tics : 1;
+	UINT32 tics = thinker_window_tics ? thinker_window_tics : 1;
 	CONS_Printf("--- thinkertimes (%u tics) ---\n", (unsigned)thinker_window_tics);
 	for (i = 0; i < NUM_THINKER_BUCKETS; i++)
 	{
-		u64 ms_x100;
+		UINT64 ms_x100;
 		if (thinker_buckets[i].calls == 0)
 			continue;
-		ms_x100 = thinker_buckets[i].acc_ticks * 100000ULL / TPROF_TICKS_PER_SEC;
-		CONS_Printf("%s : %3u.%02u ms  (%u/tic)\n",
+		ms_x100 = I_PreciseToMicros(thinker_buckets[i].acc_ticks) / 10;
+		CONS_Printf("%-22s : %3u.%02u ms  (%u/tic)\n",
 			thinker_buckets[i].name,
 			(unsigned)(ms_x100 / 100), (unsigned)(ms_x100 % 100),
 			(unsigned)(thinker_buckets[i].calls / tics));
 	}
 	if (thinker_other_calls)
 	{
-		u64 ms_x100 = thinker_other_acc * 100000ULL / TPROF_TICKS_PER_SEC;
-		CONS_Printf("other                  : %3u.%02u ms  (%u/tic)\n",
+		UINT64 ms_x100 = I_PreciseToMicros(thinker_other_acc) / 10;
+		CONS_Printf("%-22s : %3u.%02u ms  (%u/tic)\n", "other",
 			(unsigned)(ms_x100 / 100), (unsigned)(ms_x100 % 100),
 			(unsigned)(thinker_other_calls / tics));
 	}
 	P_PrintMobjTypeTop(tics);
 }
 
+static void P_WriteThinkerProfileRow(FILE *f, const char *kind, const char *name,
+	UINT64 calls, precise_t ticks, UINT64 tics)
+{
+	const double us = (double)I_PreciseToMicros(ticks);
+	fprintf(f, "%s,%s,%.0f,%.0f,%.3f,%.3f,%.3f\n", kind, name,
+		(double)calls, us, us / (double)calls,
+		(double)calls / (double)tics, us / (double)tics);
+}
+
+/** \brief Writes the running profiler totals as CSV.
+
+	One row per thinker function and one per mobj type that ran at all,
+	with total and per-call/per-tic microseconds.
+
+	\param	filename	file to write
+	\return	false if the file couldn't be opened
+*/
+static boolean P_WriteThinkerProfile(const char *filename)
+{
+	FILE *f;
+	size_t i;
+	UINT64 tics;
+
+	if (thinker_prof_started)
+		P_FoldThinkerProfile(I_GetPreciseTime());
+	tics = thinker_total_tics ? thinker_total_tics : 1;
+
+	f = fopen(filename, "w");
+	if (!f)
+		return false;
+
+	fprintf(f, "kind,name,calls,total_us,us_per_call,calls_per_tic,us_per_tic\n");
+	for (i = 0; i < NUM_THINKER_BUCKETS; i++)
+	{
+		if (thinker_buckets[i].total_calls)
+			P_WriteThinkerProfileRow(f, "thinker", thinker_buckets[i].name,
+				thinker_buckets[i].total_calls, thinker_buckets[i].total_ticks, tics);
+	}
+	if (thinker_other_total_calls)
+		P_WriteThinkerProfileRow(f, "thinker", "other",
+			thinker_other_total_calls, thinker_other_total, tics);
+	for (i = 0; i < NUMMOBJTYPES; i++)
+	{
+		if (mobjtype_total_calls[i])
+			P_WriteThinkerProfileRow(f, "mobjtype", DEH_MobjTypeName((INT32)i),
+				mobjtype_total_calls[i], mobjtype_total[i], tics);
+	}
+
+	fclose(f);
+	CONS_Printf(M_GetText("Thinker profile of %s tics written to %s\n"), sizeu1((size_t)thinker_total_tics), filename);
+	return true;
+}
+
 static inline thinker_bucket_t *P_FindThinkerBucket(actionf_p1 fn)
 {
 	size_t i;
@@ -470,54 +576,84 @@ static inline thinker_bucket_t *P_FindThinkerBucket(actionf_p1 fn)
 
 static void P_RunThinkersProfiled(void)
 {
-	u64 now;
+	precise_t now;
+	size_t i;
 
 	if (!thinker_prof_started)
 	{
-		P_ResetThinkerProfile(svcGetSystemTick());
+		P_ResetThinkerProfile(I_GetPreciseTime());
 		thinker_prof_started = true;
 	}
 
-	for (currentthinker = thinkercap.next; currentthinker != &thinkercap; currentthinker = currentthinker->next)
+	for (i = 0; i < NUM_THINKERLISTS; i++)
 	{
-		actionf_p1 fn = currentthinker->function.acp1;
-		if (fn && fn != (actionf_p1)T_Disappear) // batched outside this loop
+		for (currentthinker = thlist[i].next; currentthinker != &thlist[i]; currentthinker = currentthinker->next)
 		{
-			thinker_bucket_t *bucket;
-			u64 t0 = svcGetSystemTick();
-			fn(currentthinker);
+			actionf_p1 fn = currentthinker->function.acp1;
+#ifdef __3DS__
+			if (fn && fn != (actionf_p1)T_Disappear) // batched outside this loop
+#else
+			if (fn)
+#endif
 			{
-				u64 dt = svcGetSystemTick() - t0;
-				bucket = P_FindThinkerBucket(fn);
-				if (bucket)
-				{
-					bucket->acc_ticks += dt;
-					bucket->calls++;
-				}
-				else
+				thinker_bucket_t *bucket;
+				precise_t t0;
+				P_InvalidateSightMemo();
+				t0 = I_GetPreciseTime();
+				fn(currentthinker);
 				{
-					thinker_other_acc += dt;
-					thinker_other_calls++;
+					precise_t dt = I_GetPreciseTime() - t0;
+					bucket = P_FindThinkerBucket(fn);
+					if (bucket)
+					{
+						bucket->acc_ticks += dt;
+						bucket->calls++;
+					}
+					else
+					{
+						thinker_other_acc += dt;
+						thinker_other_calls++;
+					}
 				}
 			}
 		}
 	}
+	P_InvalidateSightMemo();
 
 	thinker_window_tics++;
-	now = svcGetSystemTick();
-	if (now - thinker_window_start >= TPROF_TICKS_PER_SEC)
+	now = I_GetPreciseTime();
+	if (I_PreciseToMicros(now - thinker_window_start) >= 1000000)
 	{
-		P_PrintThinkerProfile();
-		P_ResetThinkerProfile(now);
+		if (!thinker_prof_quiet)
+			P_PrintThinkerProfile();
+		P_FoldThinkerProfile(now);
 	}
 }
 
 void Command_Thinkertimes_f(void)
 {
+	if (COM_Argc() >= 2 && !stricmp(COM_Argv(1), "csv"))
+	{
+		if (COM_Argc() < 3)
+		{
+			CONS_Printf(M_GetText("thinkertimes csv <file>: write the totals since profiling began\n"));
+			return;
+		}
+		if (!thinker_total_tics && !thinker_window_tics)
+		{
+			CONS_Printf(M_GetText("Nothing has been profiled yet.\n"));
+			return;
+		}
+		if (!P_WriteThinkerProfile(COM_Argv(2)))
+			CONS_Alert(CONS_ERROR, M_GetText("Couldn't open %s for writing\n"), COM_Argv(2));
+		return;
+	}
+
 	thinker_prof_enabled = !thinker_prof_enabled;
+	thinker_prof_quiet = false;
 	if (thinker_prof_enabled)
 	{
-		P_ResetThinkerProfile(svcGetSystemTick());
+		P_ClearThinkerProfile();
 		CONS_Printf("Thinker profiling: ON (printing once/sec)\n");
 	}
 	else
@@ -525,7 +661,29 @@ void Command_Thinkertimes_f(void)
 		CONS_Printf("Thinker profiling: OFF\n");
 	}
 }
-#endif // __3DS__
+
+void P_StartDemoThinkerProfile(const char *filename)
+{
+	Z_Free(thinker_prof_demofile);
+	thinker_prof_demofile = Z_StrDup(filename);
+	P_ClearThinkerProfile();
+	thinker_prof_enabled = true;
+	thinker_prof_quiet = true;
+}
+
+boolean P_EndDemoThinkerProfile(void)
+{
+	if (!thinker_prof_demofile)
+		return false;
+
+	if (!P_WriteThinkerProfile(thinker_prof_demofile))
+		CONS_Alert(CONS_ERROR, M_GetText("Couldn't open %s for writing\n"), thinker_prof_demofile);
+	Z_Free(thinker_prof_demofile);
+	thinker_prof_demofile = NULL;
+	thinker_prof_enabled = false;
+	thinker_prof_quiet = false;
+	return true;
+}
 
 //
 // P_RunThinkers
@@ -549,18 +707,23 @@ void Command_Thinkertimes_f(void)
 // Rewritten to delete nodes implicitly, by making currentthinker
 // external and using P_RemoveThinkerDelayed() implicitly.
 //
+// The lists are run in thinklistnum_t order: polyobjects first, so that
+// the things they carry see this tic's movement, then sector specials,
+// mobjs and precipitation.
+//
 static inline void P_RunThinkers(void)
 {
+	size_t i;
 #ifdef __3DS__
 	P_RefreshPlayerCache();
 	// Process all disappear thinkers in one cache-friendly pass. Charge the
 	// time to the T_Disappear bucket so the profiler still attributes it.
 	if (thinker_prof_enabled && thinker_prof_started)
 	{
-		u64 t0 = svcGetSystemTick();
+		precise_t t0 = I_GetPreciseTime();
 		T_DisappearBatch();
 		{
-			u64 dt = svcGetSystemTick() - t0;
+			precise_t dt = I_GetPreciseTime() - t0;
 			thinker_bucket_t *b = P_FindThinkerBucket((actionf_p1)T_Disappear);
 			if (b)
 			{
@@ -573,24 +736,33 @@ static inline void P_RunThinkers(void)
 	{
 		T_DisappearBatch();
 	}
+#endif
 	if (thinker_prof_enabled)
 	{
 		P_RunThinkersProfiled();
 		return;
 	}
-	for (currentthinker = thinkercap.next; currentthinker != &thinkercap; currentthinker = currentthinker->next)
+	for (i = 0; i < NUM_THINKERLISTS; i++)
 	{
-		actionf_p1 fn = currentthinker->function.acp1;
-		if (fn && fn != (actionf_p1)T_Disappear) // batched separately above
-			fn(currentthinker);
-	}
+		for (currentthinker = thlist[i].next; currentthinker != &thlist[i]; currentthinker = currentthinker->next)
+		{
+#ifdef __3DS__
+			actionf_p1 fn = currentthinker->function.acp1;
+			if (fn && fn != (actionf_p1)T_Disappear) // batched separately above
+			{
+				P_InvalidateSightMemo();
+				fn(currentthinker);
+			}
 #else
-	for (currentthinker = thinkercap.next; currentthinker != &thinkercap; currentthinker = currentthinker->next)
-	{
-		if (currentthinker->function.acp1)
-			currentthinker->function.acp1(currentthinker);
-	}
+			if (currentthinker->function.acp1)
+			{
+				P_InvalidateSightMemo();
+				currentthinker->function.acp1(currentthinker);
+			}
 #endif
+		}
+	}
+	P_InvalidateSightMemo();
 }
 
 //
@@ -92,7 +92,7 @@ INT32 R_CheckTextureNumForName(const char *name);
 void R_ReInitColormaps(UINT16 num);
 void R_ClearColormaps(void);
 INT32 R_ColormapNumForName(char *name);
-INT32 R_CreateColormap(char *p1, char *p2, char *p3);
+INT32 R_CreateColormap(const char *p1, const char *p2, const char *p3);
 const char *R_ColormapNameForNum(INT32 num);
 
 extern INT32 numtextures;
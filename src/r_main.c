@@ -1388,6 +1388,8 @@ void R_RegisterEngineStuff(void)
 
 	CV_RegisterVar(&cv_maxportals);
 
+	COM_AddCommand("spritesorttimes", Command_Spritesorttimes_f);
+
 	// Default viewheight is changeable,
 	// initialized to standard viewheight
 	CV_RegisterVar(&cv_viewheight);
@@ -20,6 +20,7 @@
 #include "z_zone.h"
 #include "m_misc.h"
 #include "i_video.h" // rendermode
+#include "i_system.h" // I_GetPreciseTime
 #include "r_things.h"
 #include "r_plane.h"
 #include "p_tick.h"
@@ -1631,68 +1632,163 @@ void R_AddSprites(sector_t *sec, INT32 lightlevel)
 //
 static vissprite_t vsprsortedhead;
 
-void R_SortVisSprites(void)
+static vsprsortkey_t *vsprsortkeys = NULL;
+static size_t vsprsortkeyscount = 0;
+
+// Returns room for count keys, plus as much again for R_SortVisSpriteKeys
+// to merge into. Valid until the next call.
+vsprsortkey_t *R_GetVisSpriteSortKeys(size_t count)
 {
-	UINT32       i;
-	vissprite_t *ds, *dsprev, *dsnext, *dsfirst;
-	vissprite_t *best = NULL;
-	vissprite_t  unsorted;
-	fixed_t      bestscale;
-	INT32        bestdispoffset;
+	if (count*2 > vsprsortkeyscount)
+	{
+		vsprsortkeyscount = count*2 < 256 ? 256 : count*2;
+		vsprsortkeys = Z_Realloc(vsprsortkeys, vsprsortkeyscount * sizeof (*vsprsortkeys), PU_STATIC, NULL);
+	}
+	return vsprsortkeys;
+}
 
-	if (!visspritecount)
-		return;
+#define VSPRSORTRUN 16 // insertion sorted before merging
+#define VSPRKEYLESS(a, b) ((a).group < (b).group || ((a).group == (b).group && (a).key < (b).key))
 
-	unsorted.next = unsorted.prev = &unsorted;
+/** \brief Stable merge sort of vissprite keys.
 
-	dsfirst = R_GetVisSprite(0);
+	Insertion sorts short runs in place, then merges pairs of runs back
+	and forth between keys and the space after it.
 
-	// The first's prev and last's next will be set to
-	// nonsense, but are fixed in a moment
-	for (i = 0, dsnext = dsfirst, ds = NULL; i < visspritecount; i++)
+	\param	keys	count keys, from R_GetVisSpriteSortKeys
+	\param	count	number of keys
+	\return	the sorted keys, either keys or keys + count
+*/
+const vsprsortkey_t *R_SortVisSpriteKeys(vsprsortkey_t *keys, size_t count)
+{
+	vsprsortkey_t *src = keys, *dst = keys + count, *swap;
+	size_t i, j, width;
+
+	for (i = 0; i < count; i += VSPRSORTRUN)
 	{
-		dsprev = ds;
-		ds = dsnext;
-		if (i < visspritecount - 1) dsnext = R_GetVisSprite(i + 1);
+		const size_t end = (i + VSPRSORTRUN < count) ? i + VSPRSORTRUN : count;
+		for (j = i + 1; j < end; j++)
+		{
+			vsprsortkey_t k = src[j];
+			size_t h = j;
+			while (h > i && VSPRKEYLESS(k, src[h-1]))
+			{
+				src[h] = src[h-1];
+				h--;
+			}
+			src[h] = k;
+		}
+	}
 
-		ds->next = dsnext;
-		ds->prev = dsprev;
+	for (width = VSPRSORTRUN; width < count; width *= 2)
+	{
+		for (i = 0; i < count; i += width*2)
+		{
+			const size_t mid = (i + width < count) ? i + width : count;
+			const size_t end = (i + width*2 < count) ? i + width*2 : count;
+			size_t a = i, b = mid, o = i;
+
+			// take from the right run only when strictly less, to stay stable
+			while (a < mid && b < end)
+				dst[o++] = VSPRKEYLESS(src[b], src[a]) ? src[b++] : src[a++];
+			while (a < mid)
+				dst[o++] = src[a++];
+			while (b < end)
+				dst[o++] = src[b++];
+		}
+		swap = src;
+		src = dst;
+		dst = swap;
 	}
 
-	// Fix first and last. ds still points to the last one after the loop
-	dsfirst->prev = &unsorted;
-	unsorted.next = dsfirst;
-	if (ds)
-		ds->next = &unsorted;
-	unsorted.prev = ds;
+	return src;
+}
+
+#undef VSPRKEYLESS
+
+// Time spent sorting vissprites, for the spritesorttimes command.
+// Both renderers report here once per frame.
+static boolean spritesort_prof_enabled = false;
+static precise_t spritesort_window_start = 0;
+static precise_t spritesort_acc = 0, spritesort_worst = 0;
+static UINT32 spritesort_frames = 0;
+static UINT64 spritesort_sprites = 0;
+static size_t spritesort_most = 0;
+
+void R_CountVisSpriteSort(precise_t start, size_t count)
+{
+	const precise_t now = I_GetPreciseTime();
+	const precise_t dt = now - start;
+
+	spritesort_acc += dt;
+	if (dt > spritesort_worst)
+		spritesort_worst = dt;
+	spritesort_frames++;
+	spritesort_sprites += count;
+	if (count > spritesort_most)
+		spritesort_most = count;
+
+	if (I_PreciseToMicros(now - spritesort_window_start) < 1000000)
+		return;
+
+	if (spritesort_prof_enabled && spritesort_frames)
+	{
+		const UINT64 avg = I_PreciseToMicros(spritesort_acc) / spritesort_frames;
+		const UINT64 worst = I_PreciseToMicros(spritesort_worst);
+		CONS_Printf("vissprite sort: %u frames, %u sprites/frame (max %s), %u us/frame (max %u us)\n",
+			(unsigned)spritesort_frames, (unsigned)(spritesort_sprites / spritesort_frames),
+			sizeu1(spritesort_most), (unsigned)avg, (unsigned)worst);
+	}
+	spritesort_window_start = now;
+	spritesort_acc = spritesort_worst = 0;
+	spritesort_frames = 0;
+	spritesort_sprites = 0;
+	spritesort_most = 0;
+}
+
+void Command_Spritesorttimes_f(void)
+{
+	spritesort_prof_enabled = !spritesort_prof_enabled;
+	CONS_Printf("Vissprite sort timing: %s\n", spritesort_prof_enabled ? "ON (printing once/sec)" : "OFF");
+}
+
+void R_SortVisSprites(void)
+{
+	UINT32 i;
+	vissprite_t *ds;
+	vsprsortkey_t *keys;
+	const vsprsortkey_t *sorted;
+	precise_t start;
+
+	if (!visspritecount)
+		return;
+
+	start = I_GetPreciseTime();
+
+	// smallest scale first, and of the same scale, smallest dispoffset;
+	// flipping the sign bits lets both compare as unsigned
+	keys = R_GetVisSpriteSortKeys(visspritecount);
+	for (i = 0; i < visspritecount; i++)
+	{
+		ds = R_GetVisSprite(i);
+		keys[i].key = ((UINT64)((UINT32)ds->scale ^ 0x80000000) << 32)
+			| ((UINT32)ds->dispoffset ^ 0x80000000);
+		keys[i].group = 0;
+		keys[i].sprite = ds;
+	}
+	sorted = R_SortVisSpriteKeys(keys, visspritecount);
 
-	// pull the vissprites out by scale
 	vsprsortedhead.next = vsprsortedhead.prev = &vsprsortedhead;
 	for (i = 0; i < visspritecount; i++)
 	{
-		bestscale = bestdispoffset = INT32_MAX;
-		for (ds = unsorted.next; ds != &unsorted; ds = ds->next)
-		{
-			if (ds->scale < bestscale)
-			{
-				bestscale = ds->scale;
-				bestdispoffset = ds->dispoffset;
-				best = ds;
-			}
-			// order visprites of same scale by dispoffset, smallest first
-			else if (ds->scale == bestscale && ds->dispoffset < bestdispoffset)
-			{
-				bestdispoffset = ds->dispoffset;
-				best = ds;
-			}
-		}
-		best->next->prev = best->prev;
-		best->prev->next = best->next;
-		best->next = &vsprsortedhead;
-		best->prev = vsprsortedhead.prev;
-		vsprsortedhead.prev->next = best;
-		vsprsortedhead.prev = best;
+		ds = sorted[i].sprite;
+		ds->next = &vsprsortedhead;
+		ds->prev = vsprsortedhead.prev;
+		vsprsortedhead.prev->next = ds;
+		vsprsortedhead.prev = ds;
 	}
+
+	R_CountVisSpriteSort(start, visspritecount);
 }
 
 //
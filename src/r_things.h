@@ -42,6 +42,21 @@ extern fixed_t windowbottom;
 void R_DrawMaskedColumn(column_t *column);
 void R_SortVisSprites(void);
 
+// Vissprite sort key, shared with the hardware renderer. Sprites sort by
+// group, then by key, both ascending; ones that compare equal keep the
+// order they were projected in.
+typedef struct
+{
+	UINT64 key;
+	UINT32 group;
+	void *sprite;
+} vsprsortkey_t;
+
+vsprsortkey_t *R_GetVisSpriteSortKeys(size_t count);
+const vsprsortkey_t *R_SortVisSpriteKeys(vsprsortkey_t *keys, size_t count);
+void R_CountVisSpriteSort(precise_t start, size_t count);
+void Command_Spritesorttimes_f(void);
+
 //faB: find sprites in wadfile, replace existing, add new ones
 //     (only sprites from namelist are added or replaced)
 void R_AddSpriteDefs(UINT16 wadnum);
@@ -57,6 +57,7 @@ CV_PossibleValue_t soundvolume_cons_t[] = {{0, "MIN"}, {31, "MAX"}, {0, NULL}};
 static void SetChannelsNum(void);
 static void Command_Tunes_f(void);
 static void Command_RestartAudio_f(void);
+static void Command_SoundCacheStats_f(void);
 
 // Sound system toggles
 static void GameMIDIMusic_OnChange(void);
@@ -93,6 +94,13 @@ consvar_t stereoreverse = {"stereoreverse", "Off", CV_SAVE, CV_OnOff, NULL, 0, N
 // if true, all sounds are loaded at game startup
 static consvar_t precachesound = {"precachesound", "Off", CV_SAVE, CV_OnOff, NULL, 0, NULL, NULL, 0, 0, NULL};
 
+// KB of sound lumps loaded with each level, for the sounds of what it spawns (0 = none)
+#ifdef _NDS
+static consvar_t precachelevelsound = {"precachelevelsound", "256", CV_SAVE, CV_Unsigned, NULL, 0, NULL, NULL, 0, 0, NULL};
+#else
+static consvar_t precachelevelsound = {"precachelevelsound", "2048", CV_SAVE, CV_Unsigned, NULL, 0, NULL, NULL, 0, 0, NULL};
+#endif
+
 // actual general (maximum) sound & music volume, saved into the config
 consvar_t cv_soundvolume = {"soundvolume", "18", CV_SAVE, soundvolume_cons_t, NULL, 0, NULL, NULL, 0, 0, NULL};
 consvar_t cv_digmusicvolume = {"digmusicvolume", "18", CV_SAVE, soundvolume_cons_t, NULL, 0, NULL, NULL, 0, 0, NULL};
@@ -258,6 +266,7 @@ void S_RegisterSoundStuff(void)
 
 	CV_RegisterVar(&stereoreverse);
 	CV_RegisterVar(&precachesound);
+	CV_RegisterVar(&precachelevelsound);
 
 #ifdef SNDSERV
 	CV_RegisterVar(&sndserver_cmd);
@@ -276,6 +285,7 @@ void S_RegisterSoundStuff(void)
 
 	COM_AddCommand("tunes", Command_Tunes_f);
 	COM_AddCommand("restartaudio", Command_RestartAudio_f);
+	COM_AddCommand("soundcachestats", Command_SoundCacheStats_f);
 
 
 #if defined (macintosh) && !defined (HAVE_SDL) // mp3 playlist stuff
@@ -356,6 +366,184 @@ lumpnum_t S_GetSfxLumpNum(sfxinfo_t *sfx)
 	return W_GetNumForName("dsthok");
 }
 
+//
+// Level sound precache
+//
+// The sounds of everything a level spawns are loaded with the level rather
+// than on first use, which decoded the lump mid-game. S_QueueLevelSounds
+// picks them once the things are spawned and has the lump prefetch threads
+// read them in the background while the rest of the level loads;
+// S_PrecacheLevelSounds then makes sound effects out of them.
+//
+
+// Counters for the "soundcachestats" command, reset with each level
+static struct
+{
+	UINT32 queued; // sounds picked for the level
+	UINT32 overbudget; // picked but left out, over precachelevelsound
+	UINT32 precached; // loaded at level load
+	size_t precachedbytes;
+	UINT32 hits; // sounds started with their data already loaded
+	UINT32 misses; // sounds that had to be loaded when started
+} soundcachestats;
+
+static UINT8 sfxmissed[(NUMSFX+7)/8]; // which sounds missed this level
+static sfxenum_t levelsounds[NUMSFX];
+static size_t numlevelsounds = 0;
+
+// Loads a sound's data if it isn't yet, counting whether it had to.
+static void S_CacheSfx(sfxinfo_t *sfx)
+{
+	if (sfx->data)
+	{
+		soundcachestats.hits++;
+		return;
+	}
+
+	// cache data if necessary
+	// NOTE: set sfx->data NULL sfx->lump -1 to force a reload
+	sfx->data = I_GetSfx(sfx);
+	soundcachestats.misses++;
+	sfxmissed[(sfx - S_sfx)>>3] |= 1<<((sfx - S_sfx)&7);
+}
+
+static const UINT32 *levelsoundcounts; // for S_CompareLevelSounds
+
+static int S_CompareLevelSounds(const void *a, const void *b)
+{
+	const UINT32 *c = levelsoundcounts;
+	const sfxenum_t sa = *(const sfxenum_t *)a, sb = *(const sfxenum_t *)b;
+	if (c[sa] != c[sb])
+		return (c[sa] < c[sb]) ? 1 : -1; // most used first
+	return (sa < sb) ? -1 : (sa > sb);
+}
+
+// Lua and SOC can put any number in an info's sound fields
+static inline void S_CountLevelSound(UINT32 *counts, sfxenum_t s)
+{
+	if ((INT32)s > sfx_None && (INT32)s < NUMSFX)
+		counts[s]++;
+}
+
+/** Picks the sounds the spawned things can make, up to precachelevelsound
+  * KB of lumps, the ones of the most common things first, and queues their
+  * lumps to be read ahead. Call once the level's things are spawned.
+  *
+  * \sa S_PrecacheLevelSounds
+  */
+void S_QueueLevelSounds(void)
+{
+	UINT32 *counts;
+	thinker_t *th;
+	size_t i, budget, total = 0;
+
+	memset(&soundcachestats, 0, sizeof (soundcachestats));
+	memset(sfxmissed, 0, sizeof (sfxmissed));
+	numlevelsounds = 0;
+
+	if (dedicated || sound_disabled || !precachelevelsound.value)
+		return;
+#ifdef HW3SOUND
+	if (hws_mode != HWS_DEFAULT_MODE)
+		return; // it keeps sounds its own way
+#endif
+
+	counts = calloc(NUMSFX, sizeof (*counts));
+	if (!counts)
+		return;
+
+	for (th = thlist[THINK_MOBJ].next; th != &thlist[THINK_MOBJ]; th = th->next)
+	{
+		const mobjinfo_t *info;
+
+		if (th->function.acp1 != (actionf_p1)P_MobjThinker)
+			continue;
+
+		info = ((mobj_t *)th)->info;
+		S_CountLevelSound(counts, info->seesound);
+		S_CountLevelSound(counts, info->attacksound);
+		S_CountLevelSound(counts, info->painsound);
+		S_CountLevelSound(counts, info->deathsound);
+		S_CountLevelSound(counts, info->activesound);
+	}
+
+	for (i = 1; i < NUMSFX; i++)
+		if (counts[i] && S_sfx[i].name && !S_sfx[i].data)
+			levelsounds[numlevelsounds++] = (sfxenum_t)i;
+	soundcachestats.queued = (UINT32)numlevelsounds;
+
+	levelsoundcounts = counts;
+	qsort(levelsounds, numlevelsounds, sizeof (*levelsounds), S_CompareLevelSounds);
+	free(counts);
+
+	budget = (size_t)precachelevelsound.value<<10;
+	for (i = 0; i < numlevelsounds; i++)
+	{
+		sfxinfo_t *sfx = &S_sfx[levelsounds[i]];
+		size_t length;
+
+		if (sfx->lumpnum == LUMPERROR)
+			sfx->lumpnum = S_GetSfxLumpNum(sfx);
+		length = W_LumpLength(sfx->lumpnum);
+		if (total + length > budget)
+			break;
+		total += length;
+
+		W_PrefetchLumpNum(sfx->lumpnum);
+	}
+
+	soundcachestats.overbudget = (UINT32)(numlevelsounds - i);
+	numlevelsounds = i;
+}
+
+/** Loads the sounds S_QueueLevelSounds picked. Their lumps have been
+  * read in the background by then, or are being read.
+  */
+void S_PrecacheLevelSounds(void)
+{
+	size_t i;
+
+	for (i = 0; i < numlevelsounds; i++)
+	{
+		sfxinfo_t *sfx = &S_sfx[levelsounds[i]];
+
+		if (sfx->data)
+			continue;
+
+		sfx->data = I_GetSfx(sfx);
+		if (!sfx->data)
+			continue;
+
+		soundcachestats.precached++;
+		soundcachestats.precachedbytes += W_LumpLength(sfx->lumpnum);
+	}
+
+	numlevelsounds = 0;
+}
+
+/** \brief The "soundcachestats" command: how this level's sounds were loaded.
+*/
+static void Command_SoundCacheStats_f(void)
+{
+	const double starts = (soundcachestats.hits + soundcachestats.misses) ? (double)(soundcachestats.hits + soundcachestats.misses) : 1.0;
+	size_t i;
+
+	CONS_Printf("%u sounds picked for the level, %u over the %d KB budget\n",
+		soundcachestats.queued, soundcachestats.overbudget, precachelevelsound.value);
+	CONS_Printf("  precached:  %u (%s KB)\n", soundcachestats.precached, sizeu1(soundcachestats.precachedbytes>>10));
+	CONS_Printf("  hits:       %u (%.1f%%)\n", soundcachestats.hits, 100.0 * soundcachestats.hits / starts);
+	CONS_Printf("  misses:     %u (%.1f%%)\n", soundcachestats.misses, 100.0 * soundcachestats.misses / starts);
+
+	if (!soundcachestats.misses)
+		return;
+
+	CONS_Printf("Loaded when started:");
+	for (i = 1; i < NUMSFX; i++)
+		if (sfxmissed[i>>3] & (1<<(i&7)))
+			CONS_Printf(" %s", S_sfx[i].name);
+	CONS_Printf("\n");
+}
+
 // Stop all sounds, load level info, THEN start sounds.
 void S_StopSounds(void)
 {
@@ -542,11 +730,7 @@ void S_StartSoundAtVolume(const void *origin_p, sfxenum_t sfx_id, INT32 volume)
 		// This is supposed to handle the loading/caching.
 		// For some odd reason, the caching is done nearly
 		// each time the sound is needed?
-
-		// cache data if necessary
-		// NOTE: set sfx->data NULL sfx->lump -1 to force a reload
-		if (!sfx->data)
-			sfx->data = I_GetSfx(sfx);
+		S_CacheSfx(sfx);
 
 		// increase the usefulness
 		if (sfx->usefulness++ < 0)
@@ -592,11 +776,7 @@ dontplay:
 	// This is supposed to handle the loading/caching.
 	// For some odd reason, the caching is done nearly
 	// each time the sound is needed?
-
-	// cache data if necessary
-	// NOTE: set sfx->data NULL sfx->lump -1 to force a reload
-	if (!sfx->data)
-		sfx->data = I_GetSfx(sfx);
+	S_CacheSfx(sfx);
 
 	// increase the usefulness
 	if (sfx->usefulness++ < 0)
@@ -91,6 +91,12 @@ void S_Start(void);
 //
 lumpnum_t S_GetSfxLumpNum(sfxinfo_t *sfx);
 
+//
+// Loads the sounds of the level's things ahead of their first use, see s_sound.c
+//
+void S_QueueLevelSounds(void);
+void S_PrecacheLevelSounds(void);
+
 //
 // Start sound for thing at <origin> using <sound_id> from sounds.h
 //
@@ -2073,6 +2073,26 @@ tic_t I_GetTime (void)
 }
 #endif
 
+//
+// I_GetPreciseTime
+// returns the performance counter; differences only, for profiling
+//
+precise_t I_GetPreciseTime(void)
+{
+	return SDL_GetPerformanceCounter();
+}
+
+UINT64 I_PreciseToMicros(precise_t d)
+{
+	static UINT64 frequency = 0;
+
+	if (!frequency)
+		frequency = SDL_GetPerformanceFrequency();
+
+	// split up so that long runs don't overflow the multiply
+	return (d / frequency) * 1000000 + (d % frequency) * 1000000 / frequency;
+}
+
 //
 //I_StartupTimer
 //
@@ -0,0 +1,105 @@
+// SONIC ROBO BLAST 2
+//-----------------------------------------------------------------------------
+// Copyright (C) 1999-2018 by Sonic Team Junior.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  sdl/i_threads.c
+/// \brief Multithreading abstraction for SDL
+
+#ifdef HAVE_THREADS
+
+#include "SDL.h"
+
+#include "../doomdef.h"
+#include "../i_threads.h"
+
+typedef struct
+{
+	I_thread_fn entry;
+	void *userdata;
+} thread_start_t;
+
+static int I_ThreadEntry(void *arg)
+{
+	thread_start_t start = *(thread_start_t *)arg;
+	free(arg);
+	start.entry(start.userdata);
+	return 0;
+}
+
+boolean I_SpawnThread(const char *name, I_thread_fn entry, void *userdata)
+{
+	thread_start_t *start;
+	SDL_Thread *th;
+
+	start = malloc(sizeof *start);
+	if (!start)
+		return false;
+	start->entry = entry;
+	start->userdata = userdata;
+
+	th = SDL_CreateThread(I_ThreadEntry, name, start);
+	if (!th)
+	{
+		free(start);
+		return false;
+	}
+	SDL_DetachThread(th);
+	return true;
+}
+
+I_mutex I_CreateMutex(void)
+{
+	SDL_mutex *mutex = SDL_CreateMutex();
+	if (!mutex)
+		I_Error("I_CreateMutex: %s", SDL_GetError());
+	return mutex;
+}
+
+void I_DestroyMutex(I_mutex id)
+{
+	SDL_DestroyMutex(id);
+}
+
+void I_LockMutex(I_mutex id)
+{
+	SDL_LockMutex(id);
+}
+
+void I_UnlockMutex(I_mutex id)
+{
+	SDL_UnlockMutex(id);
+}
+
+I_cond I_CreateCond(void)
+{
+	SDL_cond *cond = SDL_CreateCond();
+	if (!cond)
+		I_Error("I_CreateCond: %s", SDL_GetError());
+	return cond;
+}
+
+void I_DestroyCond(I_cond cond)
+{
+	SDL_DestroyCond(cond);
+}
+
+void I_HoldCond(I_cond cond, I_mutex mutex)
+{
+	SDL_CondWait(cond, mutex);
+}
+
+void I_WakeOneCond(I_cond cond)
+{
+	SDL_CondSignal(cond);
+}
+
+void I_WakeAllCond(I_cond cond)
+{
+	SDL_CondBroadcast(cond);
+}
+
+#endif/*HAVE_THREADS*/
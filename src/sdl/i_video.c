@@ -1440,7 +1440,7 @@ static void Impl_VideoSetupBuffer(void)
 
 void I_StartupGraphics(void)
 {
-	if (dedicated)
+	if (dedicated || M_CheckParm("-demoregress")) // headless demo regression runs too
 	{
 		rendermode = render_none;
 		return;
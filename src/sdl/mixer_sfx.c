@@ -0,0 +1,358 @@
+// SONIC ROBO BLAST 2
+//-----------------------------------------------------------------------------
+// Copyright (C) 2014-2018 by Sonic Team Junior.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file
+/// \brief Sound effect mixing shared by the SDL_mixer ports
+
+#include "../doomdef.h"
+
+#if defined (_NDS) || (defined(HAVE_SDL) && defined(HAVE_MIXER) && SOUND==SOUND_MIXER)
+
+#include "../sounds.h"
+#include "../s_sound.h"
+#include "../i_sound.h"
+#include "../z_zone.h"
+#include "../byteptr.h"
+#include "../command.h"
+
+#ifdef _MSC_VER
+#pragma warning(disable : 4214 4244)
+#endif
+#include "SDL.h"
+#ifdef _MSC_VER
+#pragma warning(default : 4214 4244)
+#endif
+
+#include "SDL_mixer.h"
+#include "mixer_sfx.h"
+
+// Sound effects are kept the way they come: DoomSound lumps stay 8-bit
+// mono at their own rate, straight out of the lump, instead of being
+// blown up to 16-bit stereo 44.1 kHz chunks (16 times the size for an
+// 11 kHz lump). SfxPostMix steps through them at their own rate and
+// pans them into Mixer's output, after it has mixed the music. Anything
+// else (WAVE, OGG, GME) is decoded into a Mixer chunk by the port, and
+// mixed the same way. sfxmutex keeps the channels from changing under
+// SfxPostMix.
+
+#ifdef _NDS
+#define NUMSFXCHANNELS 32
+#else
+#define NUMSFXCHANNELS 256
+#endif
+
+typedef struct
+{
+	const UINT8 *samples; // 8-bit unsigned mono, or S16 in the output format if chunk
+	UINT32 length; // in sample frames
+	UINT32 step; // 16.16 source frames per output frame
+	UINT16 freq;
+	Mix_Chunk *chunk; // decoded, NULL for DoomSounds
+	void *lump; // private copy of the DoomSound lump the samples point into
+	size_t size; // bytes held for this sound
+} nativesfx_t;
+
+typedef struct
+{
+	const nativesfx_t *sfx; // NULL if not playing
+	UINT32 position; // current source frame
+	UINT32 stepremainder; // and a 0.16 bit remainder
+	INT32 leftvol, rightvol; // volume * pan, up to 128*255
+} sfxchannel_t;
+
+static sfxchannel_t sfxchannels[NUMSFXCHANNELS];
+static SDL_mutex *sfxmutex = NULL;
+static int outputfreq = 44100, outputchannels = 2; // what Mixer actually opened
+static UINT8 sfx_volume;
+
+static inline INT16 SfxClip(INT32 sample)
+{
+	if (sample > INT16_MAX)
+		return INT16_MAX;
+	if (sample < INT16_MIN)
+		return INT16_MIN;
+	return (INT16)sample;
+}
+
+static void SfxPostMix(void *udata, Uint8 *stream, int len)
+{
+	INT16 *out;
+	INT32 frames, i, c;
+	(void)udata;
+
+	SDL_LockMutex(sfxmutex);
+	for (c = 0; c < NUMSFXCHANNELS; c++)
+	{
+		sfxchannel_t *chan = &sfxchannels[c];
+		const nativesfx_t *sfx = chan->sfx;
+		UINT32 pos, rem;
+		INT32 l, r;
+
+		if (!sfx)
+			continue;
+
+		out = (INT16 *)stream;
+		frames = len / (outputchannels * (INT32)sizeof (INT16));
+		pos = chan->position;
+		rem = chan->stepremainder;
+
+		for (i = 0; i < frames && pos < sfx->length; i++)
+		{
+			if (sfx->chunk)
+			{
+				const INT16 *s = (const INT16 *)sfx->samples + pos*outputchannels;
+				l = s[0];
+				r = (outputchannels > 1) ? s[1] : s[0];
+			}
+			else
+				l = r = ((INT32)sfx->samples[pos] - 0x80)<<8;
+
+			l = (l * chan->leftvol)>>15;
+			r = (r * chan->rightvol)>>15;
+			if (outputchannels > 1)
+			{
+				out[0] = SfxClip(out[0] + l);
+				out[1] = SfxClip(out[1] + r);
+			}
+			else
+				out[0] = SfxClip(out[0] + (l + r)/2);
+			out += outputchannels;
+
+			rem += sfx->step;
+			pos += rem>>FRACBITS;
+			rem &= FRACMASK;
+		}
+
+		chan->position = pos;
+		chan->stepremainder = rem;
+		if (pos >= sfx->length)
+			chan->sfx = NULL;
+	}
+	SDL_UnlockMutex(sfxmutex);
+}
+
+void *I_SfxFromDoomSound(void *lump, size_t lumplength)
+{
+	UINT8 *stream = lump;
+	nativesfx_t *sfx;
+	UINT16 ver, freq;
+	UINT32 samples;
+
+	if (lumplength < 8)
+		return NULL;
+
+	// lump header
+	ver = READUINT16(stream); // sound version format?
+	if (ver != 3) // It should be 3 if it's a doomsound...
+		return NULL; // onos! it's not a doomsound!
+	freq = READUINT16(stream);
+	samples = READUINT32(stream);
+
+	if (!freq)
+		return NULL;
+	if (samples > lumplength - 8)
+		samples = (UINT32)(lumplength - 8); // don't run past the lump
+
+	sfx = Z_Malloc(sizeof (*sfx), PU_SOUND, NULL);
+	sfx->samples = stream;
+	sfx->length = samples;
+	sfx->freq = freq;
+	sfx->step = (UINT32)(((UINT64)freq << FRACBITS) / outputfreq);
+	sfx->chunk = NULL;
+	sfx->lump = lump;
+	sfx->size = lumplength + sizeof (*sfx);
+	return sfx;
+}
+
+void *I_SfxFromChunk(Mix_Chunk *chunk)
+{
+	nativesfx_t *sfx;
+
+	if (!chunk)
+		return NULL;
+
+	sfx = Z_Malloc(sizeof (*sfx), PU_SOUND, NULL);
+	sfx->samples = chunk->abuf;
+	sfx->length = chunk->alen / (outputchannels * sizeof (INT16));
+	sfx->freq = (UINT16)outputfreq;
+	sfx->step = FRACUNIT;
+	sfx->chunk = chunk;
+	sfx->lump = NULL;
+	sfx->size = chunk->alen + sizeof (*sfx);
+	return sfx;
+}
+
+// Memory the old way of expanding DoomSounds to 16-bit stereo 44.1 kHz took
+static size_t ExpandedSfxSize(const nativesfx_t *sfx)
+{
+	if (sfx->chunk)
+		return sfx->size;
+	return (size_t)(((UINT64)sfx->length * 44100 / sfx->freq + 1) * 2 * sizeof (INT16));
+}
+
+static void Command_Sfxmemory_f(void)
+{
+	size_t i, numnative = 0, numchunks = 0;
+	size_t nativesize = 0, chunksize = 0, expandedsize = 0;
+
+	for (i = 1; i < NUMSFX; i++)
+	{
+		const nativesfx_t *sfx = S_sfx[i].data;
+		if (!sfx)
+			continue;
+
+		if (sfx->chunk)
+		{
+			numchunks++;
+			chunksize += sfx->size;
+		}
+		else
+		{
+			numnative++;
+			nativesize += sfx->size;
+		}
+		expandedsize += ExpandedSfxSize(sfx);
+	}
+
+	CONS_Printf(M_GetText("DoomSound effects: %s, %s KB at their own rate\n"), sizeu1(numnative), sizeu2(nativesize>>10));
+	CONS_Printf(M_GetText("Mixer-decoded effects: %s, %s KB\n"), sizeu1(numchunks), sizeu2(chunksize>>10));
+	CONS_Printf(M_GetText("Expanded to 44.1 kHz stereo, these would take %s KB\n"), sizeu1(expandedsize>>10));
+	CONS_Printf(M_GetText("PU_SOUND zone memory: %s KB\n"), sizeu1(Z_TagUsage(PU_SOUND)>>10));
+}
+
+void I_StartupSfxMix(int freq, int channels)
+{
+	static boolean sfxmemoryadded = false;
+
+	outputfreq = freq;
+	outputchannels = channels;
+	if (!sfxmutex)
+		sfxmutex = SDL_CreateMutex();
+	memset(sfxchannels, 0, sizeof (sfxchannels));
+
+	// Mixer only plays the music, SfxPostMix mixes the sound effects in
+	Mix_AllocateChannels(0);
+	Mix_SetPostMix(SfxPostMix, NULL);
+
+	if (!sfxmemoryadded) // restartaudio starts the sound again
+	{
+		COM_AddCommand("sfxmemory", Command_Sfxmemory_f);
+		sfxmemoryadded = true;
+	}
+}
+
+void I_ShutdownSfxMix(void)
+{
+	Mix_SetPostMix(NULL, NULL);
+}
+
+void I_FreeSfx(sfxinfo_t *sfx)
+{
+	nativesfx_t *native = sfx->data;
+
+	if (native)
+	{
+		INT32 c;
+
+		// make sure SfxPostMix is done with it
+		SDL_LockMutex(sfxmutex);
+		for (c = 0; c < NUMSFXCHANNELS; c++)
+			if (sfxchannels[c].sfx == native)
+				sfxchannels[c].sfx = NULL;
+		SDL_UnlockMutex(sfxmutex);
+
+		if (native->chunk)
+		{
+			Mix_Chunk *chunk = native->chunk;
+			UINT8 *abufdata = NULL;
+			if (chunk->allocated == 0)
+			{
+				// We allocated the data in this chunk, so get the abuf from mixer, then let it free the chunk, THEN we free the data
+				abufdata = chunk->abuf;
+			}
+			Mix_FreeChunk(chunk);
+			if (abufdata)
+			{
+				// I'm going to assume we used Z_Malloc to allocate this data.
+				Z_Free(abufdata);
+			}
+		}
+		else
+			Z_Free(native->lump);
+		Z_Free(native);
+	}
+	sfx->data = NULL;
+	sfx->lumpnum = LUMPERROR;
+}
+
+static void SetChannelVolume(sfxchannel_t *chan, UINT8 vol, UINT8 sep)
+{
+	INT32 volume = (((UINT16)vol + 1) * (UINT16)sfx_volume) / 62; // (256 * 31) / 62 == 127
+	chan->leftvol = volume * min((UINT16)(0xff-sep)<<1, 0xff);
+	chan->rightvol = volume * min((UINT16)(sep)<<1, 0xff);
+}
+
+INT32 I_StartSound(sfxenum_t id, UINT8 vol, UINT8 sep, UINT8 pitch, UINT8 priority, INT32 channel)
+{
+	sfxchannel_t *chan;
+
+	if (!sound_started || !S_sfx[id].data)
+		return -1;
+
+	// The handle is SRB2's channel number, so there's no picking another
+	// one when snd_channels is higher than what we mix.
+	if (channel < 0 || channel >= NUMSFXCHANNELS)
+		return -1;
+
+	SDL_LockMutex(sfxmutex);
+	chan = &sfxchannels[channel];
+	chan->sfx = S_sfx[id].data;
+	chan->position = 0;
+	chan->stepremainder = 0;
+	SetChannelVolume(chan, vol, sep);
+	SDL_UnlockMutex(sfxmutex);
+
+	(void)pitch; // Mixer can't handle pitch
+	(void)priority; // priority and channel management is handled by SRB2...
+	return channel;
+}
+
+void I_StopSound(INT32 handle)
+{
+	if (!sound_started || handle < 0 || handle >= NUMSFXCHANNELS)
+		return;
+
+	SDL_LockMutex(sfxmutex);
+	sfxchannels[handle].sfx = NULL;
+	SDL_UnlockMutex(sfxmutex);
+}
+
+boolean I_SoundIsPlaying(INT32 handle)
+{
+	if (handle < 0 || handle >= NUMSFXCHANNELS)
+		return false;
+	return sfxchannels[handle].sfx != NULL;
+}
+
+void I_UpdateSoundParams(INT32 handle, UINT8 vol, UINT8 sep, UINT8 pitch)
+{
+	if (handle < 0 || handle >= NUMSFXCHANNELS)
+		return;
+
+	SDL_LockMutex(sfxmutex);
+	SetChannelVolume(&sfxchannels[handle], vol, sep);
+	SDL_UnlockMutex(sfxmutex);
+	(void)pitch;
+}
+
+void I_SetSfxVolume(UINT8 volume)
+{
+	sfx_volume = volume;
+}
+
+#endif
@@ -0,0 +1,52 @@
+// SONIC ROBO BLAST 2
+//-----------------------------------------------------------------------------
+// Copyright (C) 2014-2018 by Sonic Team Junior.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file
+/// \brief Sound effect mixing shared by the SDL_mixer ports
+///
+///	Include after SDL_mixer.h. The port opens and closes Mixer and
+///	loads the sound effects; everything from I_FreeSfx to
+///	I_SetSfxVolume lives in mixer_sfx.c.
+
+#ifndef __MIXER_SFX__
+#define __MIXER_SFX__
+
+/**	\brief	Hooks the sound effect mixer into Mixer's output
+
+	\param	freq	sample rate Mixer opened the device with
+	\param	channels	1 for mono, 2 for stereo
+
+	\return	void
+*/
+void I_StartupSfxMix(int freq, int channels);
+
+/**	\brief	Unhooks the sound effect mixer, before Mix_CloseAudio
+
+	\return	void
+*/
+void I_ShutdownSfxMix(void);
+
+/**	\brief	Wraps a DoomSound lump to be played straight from the lump
+
+	\param	lump	a private PU_SOUND copy of the lump, from
+			W_CacheLumpNumForce; freed along with the sound
+	\param	lumplength	its size
+
+	\return	sound effect data for sfxinfo_t, or NULL if it isn't a DoomSound
+*/
+void *I_SfxFromDoomSound(void *lump, size_t lumplength);
+
+/**	\brief	Wraps a chunk decoded to Mixer's output format
+
+	\param	chunk	the chunk; freed along with the sound
+
+	\return	sound effect data for sfxinfo_t, or NULL if chunk is NULL
+*/
+void *I_SfxFromChunk(Mix_Chunk *chunk);
+
+#endif
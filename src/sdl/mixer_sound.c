@@ -19,6 +19,7 @@
 #include "../w_wad.h"
 #include "../z_zone.h"
 #include "../byteptr.h"
+#include "../command.h"
 
 #ifdef _MSC_VER
 #pragma warning(disable : 4214 4244)
@@ -29,6 +30,7 @@
 #endif
 
 #include "SDL_mixer.h"
+#include "mixer_sfx.h"
 
 /* This is the version number macro for the current SDL_mixer version: */
 #ifndef SDL_MIXER_COMPILEDVERSION
@@ -75,7 +77,7 @@
 UINT8 sound_started = false;
 
 static Mix_Music *music;
-static UINT8 music_volume, sfx_volume, internal_volume;
+static UINT8 music_volume, internal_volume;
 static float loop_point;
 static float song_length; // length in seconds
 static boolean songpaused;
@@ -116,6 +118,8 @@ static void var_cleanup(void)
 
 void I_StartupSound(void)
 {
+	int freq, channels;
+
 	I_Assert(!sound_started);
 
 #ifdef _WIN32
@@ -140,7 +144,7 @@ void I_StartupSound(void)
 	var_cleanup();
 
 	music = NULL;
-	music_volume = sfx_volume = 0;
+	music_volume = 0;
 
 #if SDL_MIXER_VERSION_ATLEAST(1,2,11)
 	Mix_Init(MIX_INIT_FLAC|MIX_INIT_MOD|MIX_INIT_MP3|MIX_INIT_OGG);
@@ -155,7 +159,14 @@ void I_StartupSound(void)
 
 	sound_started = true;
 	songpaused = false;
-	Mix_AllocateChannels(256);
+
+	// mix the sound effects for whatever Mixer actually opened
+	if (!Mix_QuerySpec(&freq, NULL, &channels))
+	{
+		freq = 44100;
+		channels = 2;
+	}
+	I_StartupSfxMix(freq, channels);
 }
 
 void I_ShutdownSound(void)
@@ -164,6 +175,7 @@ void I_ShutdownSound(void)
 		return; // not an error condition
 	sound_started = false;
 
+	I_ShutdownSfxMix();
 	Mix_CloseAudio();
 #if SDL_MIXER_VERSION_ATLEAST(1,2,11)
 	Mix_Quit();
@@ -185,121 +197,11 @@ void I_UpdateSound(void)
 /// SFX
 /// ------------------------
 
-// this is as fast as I can possibly make it.
-// sorry. more asm needed.
-static Mix_Chunk *ds2chunk(void *stream)
-{
-	UINT16 ver,freq;
-	UINT32 samples, i, newsamples;
-	UINT8 *sound;
-
-	SINT8 *s;
-	INT16 *d;
-	INT16 o;
-	fixed_t step, frac;
-
-	// lump header
-	ver = READUINT16(stream); // sound version format?
-	if (ver != 3) // It should be 3 if it's a doomsound...
-		return NULL; // onos! it's not a doomsound!
-	freq = READUINT16(stream);
-	samples = READUINT32(stream);
-
-	// convert from signed 8bit ???hz to signed 16bit 44100hz.
-	switch(freq)
-	{
-	case 44100:
-		if (samples >= UINT32_MAX>>2)
-			return NULL; // would wrap, can't store.
-		newsamples = samples;
-		break;
-	case 22050:
-		if (samples >= UINT32_MAX>>3)
-			return NULL; // would wrap, can't store.
-		newsamples = samples<<1;
-		break;
-	case 11025:
-		if (samples >= UINT32_MAX>>4)
-			return NULL; // would wrap, can't store.
-		newsamples = samples<<2;
-		break;
-	default:
-		frac = (44100 << FRACBITS) / (UINT32)freq;
-		if (!(frac & 0xFFFF)) // other solid multiples (change if FRACBITS != 16)
-			newsamples = samples * (frac >> FRACBITS);
-		else // strange and unusual fractional frequency steps, plus anything higher than 44100hz.
-			newsamples = FixedMul(FixedDiv(samples, freq), 44100) + 1; // add 1 to counter truncation.
-		if (newsamples >= UINT32_MAX>>2)
-			return NULL; // would and/or did wrap, can't store.
-		break;
-	}
-	sound = Z_Malloc(newsamples<<2, PU_SOUND, NULL); // samples * frequency shift * bytes per sample * channels
-
-	s = (SINT8 *)stream;
-	d = (INT16 *)sound;
-
-	i = 0;
-	switch(freq)
-	{
-	case 44100: // already at the same rate? well that makes it simple.
-		while(i++ < samples)
-		{
-			o = ((INT16)(*s++)+0x80)<<8; // changed signedness and shift up to 16 bits
-			*d++ = o; // left channel
-			*d++ = o; // right channel
-		}
-		break;
-	case 22050: // unwrap 2x
-		while(i++ < samples)
-		{
-			o = ((INT16)(*s++)+0x80)<<8; // changed signedness and shift up to 16 bits
-			*d++ = o; // left channel
-			*d++ = o; // right channel
-			*d++ = o; // left channel
-			*d++ = o; // right channel
-		}
-		break;
-	case 11025: // unwrap 4x
-		while(i++ < samples)
-		{
-			o = ((INT16)(*s++)+0x80)<<8; // changed signedness and shift up to 16 bits
-			*d++ = o; // left channel
-			*d++ = o; // right channel
-			*d++ = o; // left channel
-			*d++ = o; // right channel
-			*d++ = o; // left channel
-			*d++ = o; // right channel
-			*d++ = o; // left channel
-			*d++ = o; // right channel
-		}
-		break;
-	default: // convert arbitrary hz to 44100.
-		step = 0;
-		frac = ((UINT32)freq << FRACBITS) / 44100 + 1; //Add 1 to counter truncation.
-		while (i < samples)
-		{
-			o = (INT16)(*s+0x80)<<8; // changed signedness and shift up to 16 bits
-			while (step < FRACUNIT) // this is as fast as I can make it.
-			{
-				*d++ = o; // left channel
-				*d++ = o; // right channel
-				step += frac;
-			}
-			do {
-				i++; s++;
-				step -= FRACUNIT;
-			} while (step >= FRACUNIT);
-		}
-		break;
-	}
-
-	// return Mixer Chunk.
-	return Mix_QuickLoad_RAW(sound, (Uint32)((UINT8*)d-sound));
-}
-
+// Only loading lives here, mixer_sfx.c plays them.
 void *I_GetSfx(sfxinfo_t *sfx)
 {
 	void *lump;
+	void *native;
 	Mix_Chunk *chunk;
 	SDL_RWops *rw;
 #ifdef HAVE_LIBGME
@@ -311,15 +213,16 @@ void *I_GetSfx(sfxinfo_t *sfx)
 		sfx->lumpnum = S_GetSfxLumpNum(sfx);
 	sfx->length = W_LumpLength(sfx->lumpnum);
 
-	lump = W_CacheLumpNum(sfx->lumpnum, PU_SOUND);
+	// A private copy: another sfx may share this lump, and a DoomSound
+	// keeps its buffer until I_FreeSfx.
+	lump = W_CacheLumpNumForce(sfx->lumpnum, PU_SOUND);
+	if (!lump)
+		return NULL;
 
-	// convert from standard DoomSound format.
-	chunk = ds2chunk(lump);
-	if (chunk)
-	{
-		Z_Free(lump);
-		return chunk;
-	}
+	// standard DoomSound format, played straight from the lump
+	native = I_SfxFromDoomSound(lump, sfx->length);
+	if (native)
+		return native;
 
 	// Not a doom sound? Try something else.
 #ifdef HAVE_LIBGME
@@ -367,7 +270,7 @@ void *I_GetSfx(sfxinfo_t *sfx)
 					gme_free_info(info);
 					gme_delete(emu);
 
-					return Mix_QuickLoad_RAW((Uint8 *)mem, len);
+					return I_SfxFromChunk(Mix_QuickLoad_RAW((Uint8 *)mem, len));
 				}
 			}
 			else
@@ -440,7 +343,7 @@ void *I_GetSfx(sfxinfo_t *sfx)
 		gme_free_info(info);
 		gme_delete(emu);
 
-		return Mix_QuickLoad_RAW((Uint8 *)mem, len);
+		return I_SfxFromChunk(Mix_QuickLoad_RAW((Uint8 *)mem, len));
 	}
 #endif
 
@@ -449,69 +352,14 @@ void *I_GetSfx(sfxinfo_t *sfx)
 	if (rw != NULL)
 	{
 		chunk = Mix_LoadWAV_RW(rw, 1);
-		return chunk;
+		Z_Free(lump); // Mixer made its own copy
+		return I_SfxFromChunk(chunk);
 	}
 
+	Z_Free(lump);
 	return NULL; // haven't been able to get anything
 }
 
-void I_FreeSfx(sfxinfo_t *sfx)
-{
-	if (sfx->data)
-	{
-		Mix_Chunk *chunk = (Mix_Chunk*)sfx->data;
-		UINT8 *abufdata = NULL;
-		if (chunk->allocated == 0)
-		{
-			// We allocated the data in this chunk, so get the abuf from mixer, then let it free the chunk, THEN we free the data
-			// I believe this should ensure the sound is not playing when we free it
-			abufdata = chunk->abuf;
-		}
-		Mix_FreeChunk(sfx->data);
-		if (abufdata)
-		{
-			// I'm going to assume we used Z_Malloc to allocate this data.
-			Z_Free(abufdata);
-		}
-	}
-	sfx->data = NULL;
-	sfx->lumpnum = LUMPERROR;
-}
-
-INT32 I_StartSound(sfxenum_t id, UINT8 vol, UINT8 sep, UINT8 pitch, UINT8 priority, INT32 channel)
-{
-	UINT8 volume = (((UINT16)vol + 1) * (UINT16)sfx_volume) / 62; // (256 * 31) / 62 == 127
-	INT32 handle = Mix_PlayChannel(channel, S_sfx[id].data, 0);
-	Mix_Volume(handle, volume);
-	Mix_SetPanning(handle, min((UINT16)(0xff-sep)<<1, 0xff), min((UINT16)(sep)<<1, 0xff));
-	(void)pitch; // Mixer can't handle pitch
-	(void)priority; // priority and channel management is handled by SRB2...
-	return handle;
-}
-
-void I_StopSound(INT32 handle)
-{
-	Mix_HaltChannel(handle);
-}
-
-boolean I_SoundIsPlaying(INT32 handle)
-{
-	return Mix_Playing(handle);
-}
-
-void I_UpdateSoundParams(INT32 handle, UINT8 vol, UINT8 sep, UINT8 pitch)
-{
-	UINT8 volume = (((UINT16)vol + 1) * (UINT16)sfx_volume) / 62; // (256 * 31) / 62 == 127
-	Mix_Volume(handle, volume);
-	Mix_SetPanning(handle, min((UINT16)(0xff-sep)<<1, 0xff), min((UINT16)(sep)<<1, 0xff));
-	(void)pitch;
-}
-
-void I_SetSfxVolume(UINT8 volume)
-{
-	sfx_volume = volume;
-}
-
 /// ------------------------
 /// Music Utilities
 /// ------------------------
@@ -48,6 +48,7 @@
 #include "p_setup.h" // P_ScanThings
 #endif
 #include "m_misc.h" // M_MapNumber
+#include "i_threads.h"
 
 #ifdef HWRENDER
 #include "r_data.h"
@@ -83,6 +84,14 @@ int	snprintf(char *str, size_t n, const char *fmt, ...);
 #include "zlib.h"
 #endif
 
+// Map whole files into memory where we can, so uncompressed lumps
+// can be handed out without a copy. -nommap disables it.
+#if (defined (__unix__) || defined (UNIXCOMMON) || defined (__APPLE__)) && !defined (_NDS) && !defined (MSDOS) && !defined (NOMMAP)
+#define HAVE_MMAP
+#include <sys/mman.h>
+#include "m_argv.h"
+#endif
+
 
 typedef struct
 {
@@ -103,17 +112,20 @@ static inline boolean W_SkipUnsupportedLumpName(const char *name)
 }
 #endif
 
-// Must be a power of two
-#define LUMPNUMCACHESIZE 64
+// Lump name lookups are hashed on the full 8-byte (zero padded) name.
+// Each wadfile keeps chains of lumps sharing a hash, while lumpnametable
+// maps every name to the lump W_CheckNumForName returns for it: the first
+// one in the most recently added file.
+#define LUMPHASHEND UINT16_MAX
 
-typedef struct lumpnum_cache_s
-{
-	char lumpname[8];
-	lumpnum_t lumpnum;
-} lumpnum_cache_t;
+static lumpnum_t *lumpnametable = NULL; // open addressing, LUMPERROR marks a free slot
+static UINT32 lumpnametablemask = 0;
+static UINT32 lumpnametablecount = 0;
 
-static lumpnum_cache_t lumpnumcache[LUMPNUMCACHESIZE];
-static UINT16 lumpnumcacheindex = 0;
+static void W_FlushDecompCache(UINT16 wad);
+#ifdef HAVE_THREADS
+static void W_StopPrefetch(void);
+#endif
 
 //===========================================================================
 //                                                                    GLOBALS
@@ -121,6 +133,324 @@ static UINT16 lumpnumcacheindex = 0;
 UINT16 numwadfiles; // number of active wadfiles
 wadfile_t *wadfiles[MAX_WADFILES]; // 0 to numwadfiles-1 are valid
 
+// FNV-1a over a lump name as stored in lumpinfo_t, including the padding.
+static inline UINT32 W_HashLumpName(const char *name)
+{
+	UINT32 hash = 2166136261u;
+	INT32 i;
+
+	for (i = 0; i < 8; i++)
+	{
+		hash ^= (UINT8)name[i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+// Makes a name comparable with lumpinfo_t names: uppercase, zero padded to 8 chars.
+static inline void W_MakeLumpName(char *uname, const char *name)
+{
+	memset(uname, 0x00, 9);
+	strncpy(uname, name, 8);
+	strupr(uname);
+}
+
+// Sets up the lump name hash chains of a wadfile.
+static void W_BuildLumpHash(wadfile_t *wadfile)
+{
+	UINT32 numchains = 16;
+	UINT16 i;
+
+	while (numchains < wadfile->numlumps)
+		numchains <<= 1;
+
+	wadfile->lumphashmask = (UINT16)(numchains - 1);
+	wadfile->lumphash = Z_Malloc(numchains * sizeof (*wadfile->lumphash), PU_STATIC, NULL);
+	memset(wadfile->lumphash, 0xFF, numchains * sizeof (*wadfile->lumphash)); // LUMPHASHEND
+	wadfile->lumpchain = Z_Malloc((wadfile->numlumps ? wadfile->numlumps : 1) * sizeof (*wadfile->lumpchain), PU_STATIC, NULL);
+
+	// Link backwards, so every chain ends up in ascending lump order.
+	for (i = wadfile->numlumps; i-- > 0;)
+	{
+		UINT16 *chain = &wadfile->lumphash[W_HashLumpName(wadfile->lumpinfo[i].name) & wadfile->lumphashmask];
+		wadfile->lumpchain[i] = *chain;
+		*chain = i;
+	}
+}
+
+static void W_FreeLumpHash(wadfile_t *wadfile)
+{
+	Z_Free(wadfile->lumphash);
+	Z_Free(wadfile->lumpchain);
+	wadfile->lumphash = wadfile->lumpchain = NULL;
+}
+
+// PK3 path lookups.
+// W_CheckNumForFolderStartPK3 and friends match full names by prefix. Names
+// sharing a prefix are next to each other in pathorder, so that range is
+// found by binary search, and two min trees answer the lump order questions:
+// pathmintree gives the lowest lump number in a range of pathorder, and
+// pathlcptree, built over the common prefix lengths of lumps n and n+1,
+// tells where a run of lumps sharing a prefix ends.
+
+static inline INT32 W_PathCharCmp(const char *a, const char *b, size_t len)
+{
+	for (; len; len--, a++, b++)
+	{
+		INT32 ca = tolower((UINT8)*a), cb = tolower((UINT8)*b);
+		if (ca != cb)
+			return ca - cb;
+		if (!ca)
+			break;
+	}
+	return 0;
+}
+
+static const lumpinfo_t *pathsortlumps; // for W_PathOrderCmp
+
+static int W_PathOrderCmp(const void *a, const void *b)
+{
+	const UINT16 la = *(const UINT16 *)a, lb = *(const UINT16 *)b;
+	INT32 cmp = W_PathCharCmp(pathsortlumps[la].name2, pathsortlumps[lb].name2, (size_t)-1);
+	return cmp ? cmp : la - lb;
+}
+
+// Fills the inner nodes of a min tree whose leaves are already set.
+static void W_BuildMinTree(UINT16 *tree, UINT32 leaves)
+{
+	UINT32 i;
+	for (i = leaves - 1; i > 0; i--)
+		tree[i] = min(tree[2*i], tree[2*i + 1]);
+}
+
+// Lowest leaf value in [lo, hi).
+static UINT16 W_MinTreeRange(const UINT16 *tree, UINT32 leaves, UINT32 lo, UINT32 hi)
+{
+	UINT16 best = UINT16_MAX;
+	for (lo += leaves, hi += leaves; lo < hi; lo >>= 1, hi >>= 1)
+	{
+		if (lo & 1)
+		{
+			if (tree[lo] < best)
+				best = tree[lo];
+			lo++;
+		}
+		if (hi & 1)
+		{
+			hi--;
+			if (tree[hi] < best)
+				best = tree[hi];
+		}
+	}
+	return best;
+}
+
+// First leaf at or after start with a value below limit, or leaves if none.
+static UINT32 W_MinTreeFirstBelow(const UINT16 *tree, UINT32 leaves, UINT32 node, UINT32 nodelo, UINT32 nodehi, UINT32 start, UINT16 limit)
+{
+	UINT32 mid, found;
+
+	if (nodehi <= start || tree[node] >= limit)
+		return leaves;
+	if (node >= leaves)
+		return nodelo;
+
+	mid = (nodelo + nodehi)/2;
+	found = W_MinTreeFirstBelow(tree, leaves, 2*node, nodelo, mid, start, limit);
+	if (found == leaves)
+		found = W_MinTreeFirstBelow(tree, leaves, 2*node + 1, mid, nodehi, start, limit);
+	return found;
+}
+
+// Sets up the full name lookup structures of a PK3.
+static void W_BuildPathIndex(wadfile_t *wadfile)
+{
+	const lumpinfo_t *lumpinfo = wadfile->lumpinfo;
+	UINT16 numlumps = wadfile->numlumps;
+	UINT32 leaves = 1, i;
+
+	while (leaves < numlumps)
+		leaves <<= 1;
+	wadfile->pathtreesize = leaves;
+
+	wadfile->pathorder = Z_Malloc((numlumps ? numlumps : 1) * sizeof (*wadfile->pathorder), PU_STATIC, NULL);
+	for (i = 0; i < numlumps; i++)
+		wadfile->pathorder[i] = (UINT16)i;
+	pathsortlumps = lumpinfo;
+	qsort(wadfile->pathorder, numlumps, sizeof (*wadfile->pathorder), W_PathOrderCmp);
+
+	wadfile->pathmintree = Z_Malloc(2 * leaves * sizeof (*wadfile->pathmintree), PU_STATIC, NULL);
+	wadfile->pathlcptree = Z_Malloc(2 * leaves * sizeof (*wadfile->pathlcptree), PU_STATIC, NULL);
+	for (i = 0; i < leaves; i++)
+	{
+		wadfile->pathmintree[leaves + i] = (i < numlumps) ? wadfile->pathorder[i] : UINT16_MAX;
+		wadfile->pathlcptree[leaves + i] = UINT16_MAX;
+		if (i + 1 < numlumps)
+		{
+			const char *a = lumpinfo[i].name2, *b = lumpinfo[i + 1].name2;
+			UINT32 len = 0;
+			while (a[len] && tolower((UINT8)a[len]) == tolower((UINT8)b[len]) && len < UINT16_MAX - 1)
+				len++;
+			wadfile->pathlcptree[leaves + i] = (UINT16)len;
+		}
+	}
+	W_BuildMinTree(wadfile->pathmintree, leaves);
+	W_BuildMinTree(wadfile->pathlcptree, leaves);
+}
+
+static void W_FreePathIndex(wadfile_t *wadfile)
+{
+	if (!wadfile->pathorder)
+		return;
+	Z_Free(wadfile->pathorder);
+	Z_Free(wadfile->pathmintree);
+	Z_Free(wadfile->pathlcptree);
+	wadfile->pathorder = wadfile->pathmintree = wadfile->pathlcptree = NULL;
+}
+
+// First lump at or after startlump whose full name begins with name,
+// or INT16_MAX if there is none.
+static UINT16 W_FindPathPrefix(const char *name, UINT16 wad, UINT16 startlump)
+{
+	wadfile_t *wadfile = wadfiles[wad];
+	size_t len = strlen(name);
+	UINT32 lo, hi, first, last;
+	UINT16 lump;
+
+	if (!wadfile->pathorder)
+	{
+		lumpinfo_t *lump_p = wadfile->lumpinfo + startlump;
+		for (lump = startlump; lump < wadfile->numlumps; lump++, lump_p++)
+			if (!strnicmp(name, lump_p->name2, len))
+				return lump;
+		return INT16_MAX;
+	}
+
+	// find the pathorder range of names beginning with name
+	lo = 0, hi = wadfile->numlumps;
+	while (lo < hi)
+	{
+		UINT32 mid = (lo + hi)/2;
+		if (W_PathCharCmp(wadfile->lumpinfo[wadfile->pathorder[mid]].name2, name, len) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	first = lo;
+	hi = wadfile->numlumps;
+	while (lo < hi)
+	{
+		UINT32 mid = (lo + hi)/2;
+		if (W_PathCharCmp(wadfile->lumpinfo[wadfile->pathorder[mid]].name2, name, len) <= 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	last = lo;
+
+	if (first == last)
+		return INT16_MAX;
+
+	lump = W_MinTreeRange(wadfile->pathmintree, wadfile->pathtreesize, first, last);
+	if (lump >= startlump)
+		return lump;
+
+	// Somewhere in the middle of the matches, pick the nearest one after startlump.
+	lump = INT16_MAX;
+	for (; first < last; first++)
+		if (wadfile->pathorder[first] >= startlump && wadfile->pathorder[first] < lump)
+			lump = wadfile->pathorder[first];
+	return lump;
+}
+
+// Adds a wad's lumps to lumpnametable. Wads must be inserted in load order,
+// so that a later wad replaces the names it shares with earlier ones.
+static void W_InsertLumpNames(UINT16 wad)
+{
+	lumpinfo_t *lump_p = wadfiles[wad]->lumpinfo;
+	UINT16 i;
+
+	for (i = 0; i < wadfiles[wad]->numlumps; i++, lump_p++)
+	{
+		UINT32 slot = W_HashLumpName(lump_p->name) & lumpnametablemask;
+		lumpnum_t other;
+
+		while ((other = lumpnametable[slot]) != LUMPERROR)
+		{
+			if (memcmp(wadfiles[WADFILENUM(other)]->lumpinfo[LUMPNUM(other)].name, lump_p->name, 8) == 0)
+				break;
+			slot = (slot + 1) & lumpnametablemask;
+		}
+
+		if (other == LUMPERROR)
+			lumpnametablecount++;
+		else if (WADFILENUM(other) == wad)
+			continue; // first lump of that name in this wad wins
+
+		lumpnametable[slot] = ((lumpnum_t)wad<<16) + i;
+	}
+}
+
+// Throws away lumpnametable and builds it again from all loaded files.
+static void W_RebuildLumpNameTable(void)
+{
+	UINT32 numlumps = 0, size = 256;
+	UINT16 i;
+
+	for (i = 0; i < numwadfiles; i++)
+		if (wadfiles[i])
+			numlumps += wadfiles[i]->numlumps;
+
+	// keep the table at most half full
+	while (size < numlumps*2)
+		size <<= 1;
+
+	if (lumpnametable)
+		Z_Free(lumpnametable);
+	lumpnametable = Z_Malloc(size * sizeof (*lumpnametable), PU_STATIC, NULL);
+	memset(lumpnametable, 0xFF, size * sizeof (*lumpnametable)); // LUMPERROR
+	lumpnametablemask = size - 1;
+	lumpnametablecount = 0;
+
+	for (i = 0; i < numwadfiles; i++)
+		if (wadfiles[i])
+			W_InsertLumpNames(i);
+}
+
+// Makes the lumps of a newly added wad visible to W_CheckNumForName.
+static void W_AddLumpNames(UINT16 wad)
+{
+	if (!lumpnametable || (lumpnametablecount + wadfiles[wad]->numlumps)*2 > lumpnametablemask + 1)
+		W_RebuildLumpNameTable();
+	else
+		W_InsertLumpNames(wad);
+}
+
+// Maps a freshly opened file into memory, if the platform and the user allow it.
+static void W_MapWadFile(wadfile_t *wadfile)
+{
+	wadfile->mapping = NULL;
+#ifdef HAVE_MMAP
+	if (wadfile->filesize && !M_CheckParm("-nommap"))
+	{
+		void *mapping = mmap(NULL, wadfile->filesize, PROT_READ, MAP_PRIVATE, fileno(wadfile->handle), 0);
+		if (mapping != MAP_FAILED)
+			wadfile->mapping = mapping;
+		else
+			CONS_Debug(DBG_SETUP, "W_MapWadFile: can't map %s, reading it instead\n", wadfile->filename);
+	}
+#endif
+}
+
+static void W_UnmapWadFile(wadfile_t *wadfile)
+{
+#ifdef HAVE_MMAP
+	if (wadfile->mapping)
+		munmap(wadfile->mapping, wadfile->filesize);
+#endif
+	wadfile->mapping = NULL;
+}
+
 // W_Shutdown
 // Closes all of the WAD files before quitting
 // If not done on a Mac then open wad files
@@ -128,15 +458,27 @@ wadfile_t *wadfiles[MAX_WADFILES]; // 0 to numwadfiles-1 are valid
 // being ejected
 void W_Shutdown(void)
 {
+#ifdef HAVE_THREADS
+	W_StopPrefetch();
+#endif
+	W_FlushDecompCache(UINT16_MAX);
 	while (numwadfiles--)
 	{
+		W_UnmapWadFile(wadfiles[numwadfiles]);
 		fclose(wadfiles[numwadfiles]->handle);
 		Z_Free(wadfiles[numwadfiles]->filename);
 		while (wadfiles[numwadfiles]->numlumps--)
 			Z_Free(wadfiles[numwadfiles]->lumpinfo[wadfiles[numwadfiles]->numlumps].name2);
 		Z_Free(wadfiles[numwadfiles]->lumpinfo);
+		W_FreeLumpHash(wadfiles[numwadfiles]);
+		W_FreePathIndex(wadfiles[numwadfiles]);
 		Z_Free(wadfiles[numwadfiles]);
 	}
+	if (lumpnametable)
+	{
+		Z_Free(lumpnametable);
+		lumpnametable = NULL;
+	}
 }
 
 //===========================================================================
@@ -327,12 +669,6 @@ static inline INT32 W_MakeFileMD5(const char *filename, void *resblock)
 	return 1;
 }
 
-// Invalidates the cache of lump numbers. Call this whenever a wad is added.
-static void W_InvalidateLumpnumCache(void)
-{
-	memset(lumpnumcache, 0, sizeof (lumpnumcache));
-}
-
 /** Detect a file type.
  * \todo Actually detect the wad/pkzip headers and whatnot, instead of just checking the extensions.
  */
@@ -804,6 +1140,12 @@ UINT16 W_InitFile(const char *filename)
 	fseek(handle, 0, SEEK_END);
 	wadfile->filesize = (unsigned)ftell(handle);
 	wadfile->type = type;
+	W_MapWadFile(wadfile);
+	W_BuildLumpHash(wadfile);
+	if (type == RET_PK3)
+		W_BuildPathIndex(wadfile);
+	else
+		wadfile->pathorder = wadfile->pathmintree = wadfile->pathlcptree = NULL;
 
 	// already generated, just copy it over
 	M_Memcpy(&wadfile->md5sum, &md5sum, 16);
@@ -824,6 +1166,7 @@ UINT16 W_InitFile(const char *filename)
 	CONS_Printf(M_GetText("Added file %s (%u lumps)\n"), filename, numlumps);
 	wadfiles[numwadfiles] = wadfile;
 	numwadfiles++; // must come BEFORE W_LoadDehackedLumps, so any addfile called by COM_BufInsertText called by Lua doesn't overwrite what we just loaded
+	W_AddLumpNames(numwadfiles - 1);
 
 	// TODO: HACK ALERT - Load Lua & SOC stuff right here. I feel like this should be out of this place, but... Let's stick with this for now.
 	switch (wadfile->type)
@@ -847,7 +1190,6 @@ UINT16 W_InitFile(const char *filename)
 		break;
 	}
 
-	W_InvalidateLumpnumCache();
 	return wadfile->numlumps;
 }
 
@@ -861,6 +1203,7 @@ void W_UnloadWadFile(UINT16 num)
 		return;
 	CONS_Printf(M_GetText("Removing WAD %s...\n"), wadfiles[num]->filename);
 
+	W_FlushPrefetches();
 	DEH_UnloadDehackedWad(num);
 	wadfiles[num] = NULL;
 	lumpcache = delwad->lumpcache;
@@ -876,6 +1219,11 @@ void W_UnloadWadFile(UINT16 num)
 			Z_ChangeTag(lumpcache[i], PU_PURGELEVEL);
 	}
 	Z_Free(lumpcache);
+	W_FreeLumpHash(delwad);
+	W_FreePathIndex(delwad);
+	W_FlushDecompCache(num);
+	W_RebuildLumpNameTable();
+	W_UnmapWadFile(delwad);
 	fclose(delwad->handle);
 	Z_Free(delwad->filename);
 	Z_Free(delwad);
@@ -954,27 +1302,24 @@ const char *W_CheckNameForNum(lumpnum_t lumpnum)
 UINT16 W_CheckNumForNamePwad(const char *name, UINT16 wad, UINT16 startlump)
 {
 	UINT16 i;
-	static char uname[9];
-
-	memset(uname, 0x00, sizeof uname);
-	strncpy(uname, name, 8);
-	uname[8] = 0;
-	strupr(uname);
+	char uname[9];
+	wadfile_t *wadfile;
 
-	if (wad >= MAX_WADFILES || !wadfiles[wad])
+	if (wad >= MAX_WADFILES || !(wadfile = wadfiles[wad]))
 		return INT16_MAX;
 
+	W_MakeLumpName(uname, name);
+
 	//
-	// scan forward
+	// follow the name's hash chain
 	// start at 'startlump', useful parameter when there are multiple
 	//                       resources with the same name
 	//
-	if (startlump < wadfiles[wad]->numlumps)
+	if (startlump < wadfile->numlumps)
 	{
-		lumpinfo_t *lump_p = wadfiles[wad]->lumpinfo + startlump;
-		for (i = startlump; i < wadfiles[wad]->numlumps; i++, lump_p++)
+		for (i = wadfile->lumphash[W_HashLumpName(uname) & wadfile->lumphashmask]; i != LUMPHASHEND; i = wadfile->lumpchain[i])
 		{
-			if (memcmp(lump_p->name,uname,8) == 0)
+			if (i >= startlump && memcmp(wadfile->lumpinfo[i].name, uname, 8) == 0)
 				return i;
 		}
 	}
@@ -986,14 +1331,10 @@ UINT16 W_CheckNumForNamePwad(const char *name, UINT16 wad, UINT16 startlump)
 // Look for the first lump from a folder.
 UINT16 W_CheckNumForFolderStartPK3(const char *name, UINT16 wad, UINT16 startlump)
 {
-	INT32 i;
-	lumpinfo_t *lump_p = wadfiles[wad]->lumpinfo + startlump;
-	for (i = startlump; i < wadfiles[wad]->numlumps; i++, lump_p++)
-	{
-		if (strnicmp(name, lump_p->name2, strlen(name)) == 0)
-			break;
-	}
-	return i;
+	UINT16 lump = W_FindPathPrefix(name, wad, startlump);
+	if (lump == INT16_MAX && startlump < wadfiles[wad]->numlumps)
+		return wadfiles[wad]->numlumps; // past the last lump, as if we'd looked through all of them
+	return (lump == INT16_MAX) ? startlump : lump;
 }
 
 // In a PK3 type of resource file, it looks for the next lumpinfo entry that doesn't share the specified pathfile.
@@ -1001,31 +1342,33 @@ UINT16 W_CheckNumForFolderStartPK3(const char *name, UINT16 wad, UINT16 startlum
 // Returns the position of the lumpinfo entry.
 UINT16 W_CheckNumForFolderEndPK3(const char *name, UINT16 wad, UINT16 startlump)
 {
-	INT32 i;
-	lumpinfo_t *lump_p = wadfiles[wad]->lumpinfo + startlump;
-	for (i = startlump; i < wadfiles[wad]->numlumps; i++, lump_p++)
+	wadfile_t *wadfile = wadfiles[wad];
+	size_t len = strlen(name);
+	UINT32 lump;
+
+	if (startlump >= wadfile->numlumps || strnicmp(name, wadfile->lumpinfo[startlump].name2, len))
+		return startlump;
+
+	if (!wadfile->pathorder)
 	{
-		if (strnicmp(name, lump_p->name2, strlen(name)))
-			break;
+		for (lump = startlump + 1; lump < wadfile->numlumps; lump++)
+			if (strnicmp(name, wadfile->lumpinfo[lump].name2, len))
+				break;
+		return (UINT16)lump;
 	}
-	return i;
+
+	// The run of lumps sharing the prefix ends at the first neighbour
+	// pair with a shorter common prefix.
+	lump = W_MinTreeFirstBelow(wadfile->pathlcptree, wadfile->pathtreesize, 1, 0, wadfile->pathtreesize,
+		startlump, (UINT16)min(len, UINT16_MAX));
+	return (UINT16)min(lump + 1, wadfile->numlumps);
 }
 
 // In a PK3 type of resource file, it looks for an entry with the specified full name.
 // Returns lump position in PK3's lumpinfo, or INT16_MAX if not found.
 UINT16 W_CheckNumForFullNamePK3(const char *name, UINT16 wad, UINT16 startlump)
 {
-	INT32 i;
-	lumpinfo_t *lump_p = wadfiles[wad]->lumpinfo + startlump;
-	for (i = startlump; i < wadfiles[wad]->numlumps; i++, lump_p++)
-	{
-		if (!strnicmp(name, lump_p->name2, strlen(name)))
-		{
-			return i;
-		}
-	}
-	// Not found at all?
-	return INT16_MAX;
+	return W_FindPathPrefix(name, wad, startlump);
 }
 
 //
@@ -1034,38 +1377,26 @@ UINT16 W_CheckNumForFullNamePK3(const char *name, UINT16 wad, UINT16 startlump)
 //
 lumpnum_t W_CheckNumForName(const char *name)
 {
-	INT32 i;
-	lumpnum_t check = INT16_MAX;
+	char uname[9];
+	UINT32 slot;
+	lumpnum_t check;
 
-	// Check the lumpnumcache first. Loop backwards so that we check
-	// most recent entries first
-	for (i = lumpnumcacheindex + LUMPNUMCACHESIZE; i > lumpnumcacheindex; i--)
-	{
-		if (strncmp(lumpnumcache[i & (LUMPNUMCACHESIZE - 1)].lumpname, name, 8) == 0)
-		{
-			lumpnumcacheindex = i & (LUMPNUMCACHESIZE - 1);
-			return lumpnumcache[lumpnumcacheindex].lumpnum;
-		}
-	}
+	if (!lumpnametable)
+		return LUMPERROR;
 
-	// scan wad files backwards so patch lump files take precedence
-	for (i = numwadfiles - 1; i >= 0; i--)
-	{
-		check = W_CheckNumForNamePwad(name,(UINT16)i,0);
-		if (check != INT16_MAX)
-			break; //found it
-	}
+	W_MakeLumpName(uname, name);
 
-	if (check == INT16_MAX) return LUMPERROR;
-	else
+	// lumpnametable already holds the lump from the latest wad,
+	// so patch lump files take precedence
+	slot = W_HashLumpName(uname) & lumpnametablemask;
+	while ((check = lumpnametable[slot]) != LUMPERROR)
 	{
-		// Update the cache.
-		lumpnumcacheindex = (lumpnumcacheindex + 1) & (LUMPNUMCACHESIZE - 1);
-		strncpy(lumpnumcache[lumpnumcacheindex].lumpname, name, 8);
-		lumpnumcache[lumpnumcacheindex].lumpnum = (i<<16)+check;
-
-		return lumpnumcache[lumpnumcacheindex].lumpnum;
+		if (memcmp(wadfiles[WADFILENUM(check)]->lumpinfo[LUMPNUM(check)].name, uname, 8) == 0)
+			return check;
+		slot = (slot + 1) & lumpnametablemask;
 	}
+
+	return LUMPERROR;
 }
 
 // Look for valid map data through all added files in descendant order.
@@ -1242,7 +1573,7 @@ void zerr(int ret)
 #define NO_PNG_LUMPS
 
 #ifdef NO_PNG_LUMPS
-static void ErrorIfPNG(UINT8 *d, size_t s, char *f, char *l)
+static void ErrorIfPNG(const UINT8 *d, size_t s, char *f, char *l)
 {
     if (s < 67) // http://garethrees.org/2007/11/14/pngcrush/
         return;
@@ -1256,157 +1587,805 @@ static void ErrorIfPNG(UINT8 *d, size_t s, char *f, char *l)
 }
 #endif
 
-/** Reads bytes from the head of a lump.
-  * Note: If the lump is compressed, the whole thing has to be read anyway.
-  *
-  * \param wad Wad number to read from.
-  * \param lump Lump number to read from.
-  * \param dest Buffer in memory to serve as destination.
-  * \param size Number of bytes to read.
-  * \param offest Number of bytes to offset.
-  * \return Number of bytes read (should equal size).
-  * \sa W_ReadLump, W_RawReadLumpHeader
-  */
-size_t W_ReadLumpHeaderPwad(UINT16 wad, UINT16 lump, void *dest, size_t size, size_t offset)
-{
-	size_t lumpsize;
-	lumpinfo_t *l;
-	FILE *handle;
+// ==========================================================================
+//                                                   DECOMPRESSED LUMP CACHE
+// ==========================================================================
 
-	if (!TestValidLump(wad,lump))
-		return 0;
+// Decoded LZF and DEFLATE lumps are kept around, most recently used first,
+// for as long as they fit in the budget set by lumpdecompcache (kilobytes).
+// Deflated lumps are only inflated as far as reads need them, so reading the
+// header of a compressed patch doesn't cost a full decode, nor does reading
+// it again.
 
-	lumpsize = wadfiles[wad]->lumpinfo[lump].size;
-	// empty resource (usually markers like S_START, F_END ..)
-	if (!lumpsize || lumpsize<offset)
-		return 0;
+#define DECOMPHASHSIZE 256 // must be a power of two
+#define DECOMPMINREAD 4096 // inflate at least this much, small reads tend to be followed by more
+#define INFLATECHUNK 16384 // compressed bytes read from the file at once
 
-	// zero size means read all the lump
-	if (!size || size+offset > lumpsize)
-		size = lumpsize - offset;
+typedef struct lumpdecomp_s
+{
+	UINT16 wad, lump;
+	size_t length; // bytes decoded from the start of the lump
+	UINT8 *data;
+	struct lumpdecomp_s *prev, *next; // most recently used first
+	struct lumpdecomp_s *hashnext;
+} lumpdecomp_t;
 
-	// Let's get the raw lump data.
-	// We setup the desired file handle to read the lump data.
-	l = wadfiles[wad]->lumpinfo + lump;
-	handle = wadfiles[wad]->handle;
-	fseek(handle, (long)(l->position + offset), SEEK_SET);
+static lumpdecomp_t *decomphash[DECOMPHASHSIZE];
+static lumpdecomp_t *decomphead = NULL, *decomptail = NULL;
+static size_t decompbytes = 0;
 
-	// But let's not copy it yet. We support different compression formats on lumps, so we need to take that into account.
-	switch(wadfiles[wad]->lumpinfo[lump].compression)
-	{
-	case CM_NOCOMPRESSION:		// If it's uncompressed, we directly write the data into our destination, and return the bytes read.
-#ifdef NO_PNG_LUMPS
-		{
-			size_t bytesread = fread(dest, 1, size, handle);
-			ErrorIfPNG(dest, bytesread, wadfiles[wad]->filename, l->name2);
-			return bytesread;
-		}
+static void LumpDecompCache_OnChange(void);
+
+static CV_PossibleValue_t lumpdecompcache_cons_t[] = {{0, "MIN"}, {65536, "MAX"}, {0, NULL}};
+#ifdef _NDS
+consvar_t cv_lumpdecompcache = {"lumpdecompcache", "512", CV_SAVE|CV_CALL, lumpdecompcache_cons_t, LumpDecompCache_OnChange, 512, NULL, NULL, 0, 0, NULL};
 #else
-		return fread(dest, 1, size, handle);
+consvar_t cv_lumpdecompcache = {"lumpdecompcache", "4096", CV_SAVE|CV_CALL, lumpdecompcache_cons_t, LumpDecompCache_OnChange, 4096, NULL, NULL, 0, 0, NULL};
 #endif
-	case CM_LZF:		// Is it LZF compressed? Used by ZWADs.
-		{
-#ifdef ZWAD
-			char *rawData; // The lump's raw data.
-			char *decData; // Lump's decompressed real data.
-			size_t retval; // Helper var, lzf_decompress returns 0 when an error occurs.
 
-			rawData = Z_Malloc(l->disksize, PU_STATIC, NULL);
-			decData = Z_Malloc(l->size, PU_STATIC, NULL);
+#define DECOMPBUDGET ((size_t)cv_lumpdecompcache.value << 10)
 
-			if (fread(rawData, 1, l->disksize, handle) < l->disksize)
-				I_Error("wad %d, lump %d: cannot read compressed data", wad, lump);
-			retval = lzf_decompress(rawData, l->disksize, decData, l->size);
-#ifndef AVOID_ERRNO
-			if (retval == 0) // If this was returned, check if errno was set
-			{
-				// errno is a global var set by the lzf functions when something goes wrong.
-				if (errno == E2BIG)
-					I_Error("wad %d, lump %d: compressed data too big (bigger than %s)", wad, lump, sizeu1(l->size));
-				else if (errno == EINVAL)
-					I_Error("wad %d, lump %d: invalid compressed data", wad, lump);
-			}
-			// Otherwise, fall back on below error (if zero was actually the correct size then ???)
-#endif
-			if (retval != l->size)
-			{
-				I_Error("wad %d, lump %d: decompressed to wrong number of bytes (expected %s, got %s)", wad, lump, sizeu1(l->size), sizeu2(retval));
-			}
+static inline lumpdecomp_t **W_DecompHashSlot(UINT16 wad, UINT16 lump)
+{
+	return &decomphash[((wad * 31u) ^ lump) & (DECOMPHASHSIZE - 1)];
+}
 
-			if (!decData) // Did we get no data at all?
-				return 0;
-			M_Memcpy(dest, decData + offset, size);
-			Z_Free(rawData);
-			Z_Free(decData);
-#ifdef NO_PNG_LUMPS
-			ErrorIfPNG(dest, size, wadfiles[wad]->filename, l->name2);
-#endif
-			return size;
-#else
-			//I_Error("ZWAD files not supported on this platform.");
-			return 0;
-#endif
+static lumpdecomp_t *W_FindDecomp(UINT16 wad, UINT16 lump)
+{
+	lumpdecomp_t *entry;
+	for (entry = *W_DecompHashSlot(wad, lump); entry; entry = entry->hashnext)
+		if (entry->wad == wad && entry->lump == lump)
+			return entry;
+	return NULL;
+}
 
-		}
-#ifdef HAVE_ZLIB
-	case CM_DEFLATE: // Is it compressed via DEFLATE? Very common in ZIPs/PK3s, also what most doom-related editors support.
-		{
-			UINT8 *rawData; // The lump's raw data.
-			UINT8 *decData; // Lump's decompressed real data.
+// Moves an entry to the front of the LRU list.
+static void W_TouchDecomp(lumpdecomp_t *entry)
+{
+	if (entry == decomphead)
+		return;
 
-			int zErr; // Helper var.
-			z_stream strm;
-			unsigned long rawSize = l->disksize;
-			unsigned long decSize = l->size;
+	// unlink
+	entry->prev->next = entry->next;
+	if (entry->next)
+		entry->next->prev = entry->prev;
+	else
+		decomptail = entry->prev;
 
-			rawData = Z_Malloc(rawSize, PU_STATIC, NULL);
-			decData = Z_Malloc(decSize, PU_STATIC, NULL);
+	// relink at the front
+	entry->prev = NULL;
+	entry->next = decomphead;
+	decomphead->prev = entry;
+	decomphead = entry;
+}
 
-			if (fread(rawData, 1, rawSize, handle) < rawSize)
-				I_Error("wad %d, lump %d: cannot read compressed data", wad, lump);
+static void W_FreeDecomp(lumpdecomp_t *entry)
+{
+	lumpdecomp_t **slot = W_DecompHashSlot(entry->wad, entry->lump);
 
-			strm.zalloc = Z_NULL;
-			strm.zfree = Z_NULL;
-			strm.opaque = Z_NULL;
+	while (*slot != entry)
+		slot = &(*slot)->hashnext;
+	*slot = entry->hashnext;
 
-			strm.total_in = strm.avail_in = rawSize;
-			strm.total_out = strm.avail_out = decSize;
+	if (entry->prev)
+		entry->prev->next = entry->next;
+	else
+		decomphead = entry->next;
+	if (entry->next)
+		entry->next->prev = entry->prev;
+	else
+		decomptail = entry->prev;
 
-			strm.next_in = rawData;
-			strm.next_out = decData;
+	decompbytes -= entry->length;
+	Z_Free(entry->data);
+	Z_Free(entry);
+}
 
-			zErr = inflateInit2(&strm, -15);
-			if (zErr == Z_OK)
-			{
-				zErr = inflate(&strm, Z_FINISH);
-				if (zErr == Z_STREAM_END)
-				{
-					M_Memcpy(dest, decData, size);
-				}
-				else
-				{
-					size = 0;
-					zerr(zErr);
-				}
-
-				(void)inflateEnd(&strm);
-			}
-			else
-			{
-				CONS_Printf("whopet\n");
-				size = 0;
-				zerr(zErr);
-			}
+// Evicts the least recently used lumps until the cache fits in budget bytes.
+static void W_TrimDecompCache(size_t budget)
+{
+	while (decomptail && decompbytes > budget)
+		W_FreeDecomp(decomptail);
+}
 
-			Z_Free(rawData);
-			Z_Free(decData);
+// Forgets the lumps of one wad, or of all of them with UINT16_MAX.
+static void W_FlushDecompCache(UINT16 wad)
+{
+	lumpdecomp_t *entry = decomphead, *next;
+	for (; entry; entry = next)
+	{
+		next = entry->next;
+		if (wad == UINT16_MAX || entry->wad == wad)
+			W_FreeDecomp(entry);
+	}
+}
 
-#ifdef NO_PNG_LUMPS
-			ErrorIfPNG(dest, size, wadfiles[wad]->filename, l->name2);
+// A single lump may take at most a quarter of the cache.
+static inline boolean W_CanCacheDecomp(size_t length)
+{
+	return length <= DECOMPBUDGET/4;
+}
+
+// Hands a decoded buffer over to the cache, replacing what was there for that lump.
+static void W_StoreDecomp(UINT16 wad, UINT16 lump, UINT8 *data, size_t length)
+{
+	lumpdecomp_t *entry = W_FindDecomp(wad, lump);
+	lumpdecomp_t **slot = W_DecompHashSlot(wad, lump);
+
+	if (entry)
+		W_FreeDecomp(entry);
+
+	entry = Z_Malloc(sizeof (*entry), PU_STATIC, NULL);
+	entry->wad = wad;
+	entry->lump = lump;
+	entry->length = length;
+	entry->data = data;
+
+	entry->hashnext = *slot;
+	*slot = entry;
+
+	entry->prev = NULL;
+	entry->next = decomphead;
+	if (decomphead)
+		decomphead->prev = entry;
+	else
+		decomptail = entry;
+	decomphead = entry;
+
+	decompbytes += length;
+	W_TrimDecompCache(DECOMPBUDGET);
+}
+
+static void LumpDecompCache_OnChange(void)
+{
+	W_TrimDecompCache(DECOMPBUDGET);
+}
+
+#ifdef HAVE_ZLIB
+/** Inflates the start of a deflated lump, stopping as soon as enough came out.
+  *
+  * \param raw The lump's compressed data in memory, or NULL to read it from the file.
+  * \param out Buffer for the inflated data.
+  * \param outsize Number of bytes to inflate.
+  * \return Number of bytes inflated, which is less than outsize on error.
+  */
+static size_t W_InflateLump(UINT16 wad, UINT16 lump, const UINT8 *raw, UINT8 *out, size_t outsize)
+{
+	lumpinfo_t *l = wadfiles[wad]->lumpinfo + lump;
+	FILE *handle = wadfiles[wad]->handle;
+	UINT8 *chunk = NULL;
+	size_t rawleft = l->disksize;
+	z_stream strm;
+	int zErr;
+
+	strm.zalloc = Z_NULL;
+	strm.zfree = Z_NULL;
+	strm.opaque = Z_NULL;
+	strm.next_in = Z_NULL;
+	strm.avail_in = 0;
+
+	zErr = inflateInit2(&strm, -15);
+	if (zErr != Z_OK)
+	{
+		zerr(zErr);
+		return 0;
+	}
+
+	if (raw)
+	{
+		strm.next_in = (Bytef *)raw;
+		strm.avail_in = (uInt)rawleft;
+		rawleft = 0;
+	}
+	else
+	{
+		chunk = Z_Malloc(INFLATECHUNK, PU_STATIC, NULL);
+		fseek(handle, (long)l->position, SEEK_SET);
+	}
+
+	strm.next_out = out;
+	strm.avail_out = (uInt)outsize;
+
+	do
+	{
+		if (!strm.avail_in && rawleft)
+		{
+			size_t toread = min(rawleft, INFLATECHUNK);
+			if (fread(chunk, 1, toread, handle) < toread)
+				I_Error("wad %d, lump %d: cannot read compressed data", wad, lump);
+			strm.next_in = chunk;
+			strm.avail_in = (uInt)toread;
+			rawleft -= toread;
+		}
+		zErr = inflate(&strm, Z_SYNC_FLUSH);
+	} while (zErr == Z_OK && strm.avail_out);
+
+	if (strm.avail_out && zErr != Z_STREAM_END)
+		zerr(zErr);
+
+	(void)inflateEnd(&strm);
+	if (chunk)
+		Z_Free(chunk);
+
+	return outsize - strm.avail_out;
+}
+#endif
+
+#ifdef ZWAD
+// Decompresses a whole LZF lump into out, which must hold the lump's full size.
+static size_t W_DecompressLZFLump(UINT16 wad, UINT16 lump, const UINT8 *raw, UINT8 *out)
+{
+	lumpinfo_t *l = wadfiles[wad]->lumpinfo + lump;
+	UINT8 *rawData = NULL; // The lump's raw data, if it isn't mapped.
+	size_t retval; // Helper var, lzf_decompress returns 0 when an error occurs.
+
+	if (!raw)
+	{
+		raw = rawData = Z_Malloc(l->disksize, PU_STATIC, NULL);
+		fseek(wadfiles[wad]->handle, (long)l->position, SEEK_SET);
+		if (fread(rawData, 1, l->disksize, wadfiles[wad]->handle) < l->disksize)
+			I_Error("wad %d, lump %d: cannot read compressed data", wad, lump);
+	}
+	retval = lzf_decompress(raw, l->disksize, out, l->size);
+#ifndef AVOID_ERRNO
+	if (retval == 0) // If this was returned, check if errno was set
+	{
+		// errno is a global var set by the lzf functions when something goes wrong.
+		if (errno == E2BIG)
+			I_Error("wad %d, lump %d: compressed data too big (bigger than %s)", wad, lump, sizeu1(l->size));
+		else if (errno == EINVAL)
+			I_Error("wad %d, lump %d: invalid compressed data", wad, lump);
+	}
+	// Otherwise, fall back on below error (if zero was actually the correct size then ???)
+#endif
+	if (retval != l->size)
+	{
+		I_Error("wad %d, lump %d: decompressed to wrong number of bytes (expected %s, got %s)", wad, lump, sizeu1(l->size), sizeu2(retval));
+	}
+
+	if (rawData)
+		Z_Free(rawData);
+	return retval;
+}
+#endif
+
+// Decodes the first outsize bytes of a compressed lump.
+static size_t W_DecodeLump(UINT16 wad, UINT16 lump, const UINT8 *raw, UINT8 *out, size_t outsize)
+{
+	switch (wadfiles[wad]->lumpinfo[lump].compression)
+	{
+	case CM_LZF: // Is it LZF compressed? Used by ZWADs.
+#ifdef ZWAD
+		(void)outsize; // always the whole lump
+		return W_DecompressLZFLump(wad, lump, raw, out);
+#else
+		//I_Error("ZWAD files not supported on this platform.");
+		return 0;
+#endif
+#ifdef HAVE_ZLIB
+	case CM_DEFLATE: // Is it compressed via DEFLATE? Very common in ZIPs/PK3s, also what most doom-related editors support.
+		return W_InflateLump(wad, lump, raw, out, outsize);
+#endif
+	default:
+		I_Error("wad %d, lump %d: unsupported compression type!", wad, lump);
+	}
+	return 0;
+}
+
+// Reads part of a compressed lump, through the decompressed lump cache.
+// Returns size, or 0 if the lump couldn't be decoded that far.
+static size_t W_ReadCompressedLump(UINT16 wad, UINT16 lump, const UINT8 *raw, UINT8 *dest, size_t size, size_t offset)
+{
+	lumpinfo_t *l = wadfiles[wad]->lumpinfo + lump;
+	lumpdecomp_t *entry = W_FindDecomp(wad, lump);
+	size_t end = offset + size, want;
+	UINT8 *buf;
+
+	if (entry && entry->length >= end)
+	{
+		W_TouchDecomp(entry);
+		M_Memcpy(dest, entry->data + offset, size);
+		return size;
+	}
+
+	want = end;
+	if (l->compression != CM_DEFLATE) // LZF can only do whole lumps
+		want = l->size;
+	else if (want < DECOMPMINREAD)
+		want = min(DECOMPMINREAD, l->size);
+
+	if (!W_CanCacheDecomp(want))
+	{
+		// Too big to keep around. A full read can go straight to dest.
+		if (offset == 0 && want == size)
+			return (W_DecodeLump(wad, lump, raw, dest, size) == size) ? size : 0;
+
+		buf = Z_Malloc(want, PU_STATIC, NULL);
+		if (W_DecodeLump(wad, lump, raw, buf, want) < end)
+			size = 0;
+		else
+			M_Memcpy(dest, buf + offset, size);
+		Z_Free(buf);
+		return size;
+	}
+
+	buf = Z_Malloc(want, PU_STATIC, NULL);
+	if (W_DecodeLump(wad, lump, raw, buf, want) < want)
+	{
+		Z_Free(buf);
+		return 0;
+	}
+	M_Memcpy(dest, buf + offset, size);
+	W_StoreDecomp(wad, lump, buf, want);
+	return size;
+}
+
+// ==========================================================================
+//                                                             LUMP PREFETCH
+// ==========================================================================
+
+// Level loads know up front which lumps they are about to read. Those can be
+// handed to W_PrefetchLumpNum, so worker threads read and decompress them
+// while the main thread is still busy with the earlier ones. Workers only
+// use their own file handles and plain malloc, never the zone memory or the
+// console. W_ReadLumpHeaderPwad then copies finished lumps out of their
+// buffers, or waits for one that's still being read.
+// Uncompressed lumps of memory-mapped files need no worker, the kernel is
+// just told to start paging them in.
+
+#ifdef HAVE_THREADS
+
+#define MAXPREFETCH 64
+#ifdef _NDS
+#define PREFETCHWORKERS 1
+#define PREFETCHBUDGET ((size_t)2<<20)
+#else
+#define PREFETCHWORKERS 2
+#define PREFETCHBUDGET ((size_t)16<<20)
 #endif
-			return size;
+
+typedef enum
+{
+	PF_FREE,
+	PF_QUEUED,
+	PF_BUSY,
+	PF_DONE,
+	PF_FAILED
+} prefetchstate_t;
+
+typedef struct
+{
+	prefetchstate_t state;
+	UINT32 order; // workers pick the oldest queued job first
+	UINT16 wad, lump;
+
+	// Copied from the wadfile, workers don't look at wadfiles[]
+	const char *filename;
+	const UINT8 *mapping;
+	unsigned long position;
+	size_t disksize, size;
+	compmethod compression;
+
+	UINT8 *data; // malloc'd, the whole decoded lump
+} prefetch_t;
+
+static prefetch_t prefetches[MAXPREFETCH];
+static INT32 numprefetches = 0; // slots in use, only touched by the main thread
+static UINT32 prefetchorder = 0;
+static size_t prefetchbytes = 0; // decoded size of all the lumps in the slots
+static I_mutex prefetchmutex = NULL;
+static I_cond prefetchwork, prefetchdone;
+static INT32 prefetchworkers = 0;
+static boolean prefetchquit = false;
+
+// Reads and decodes a whole lump. Runs on a worker thread.
+static UINT8 *W_LoadPrefetch(const prefetch_t *job)
+{
+	UINT8 *data, *rawbuf = NULL;
+	const UINT8 *raw = NULL;
+	FILE *handle = NULL;
+	boolean ok = false;
+
+	data = malloc(job->size);
+	if (!data)
+		return NULL;
+
+	if (job->mapping)
+		raw = job->mapping + job->position;
+	else
+	{
+		handle = fopen(job->filename, "rb");
+		if (!handle || fseek(handle, (long)job->position, SEEK_SET) != 0)
+			goto done;
+
+		if (job->compression == CM_NOCOMPRESSION)
+		{
+			ok = (fread(data, 1, job->size, handle) == job->size);
+			goto done;
 		}
+
+		rawbuf = malloc(job->disksize);
+		if (!rawbuf || fread(rawbuf, 1, job->disksize, handle) != job->disksize)
+			goto done;
+		raw = rawbuf;
+	}
+
+	switch (job->compression)
+	{
+#ifdef ZWAD
+	case CM_LZF:
+		ok = (lzf_decompress(raw, job->disksize, data, job->size) == job->size);
+		break;
 #endif
+#ifdef HAVE_ZLIB
+	case CM_DEFLATE:
+		{
+			z_stream strm;
+			int zErr;
+
+			strm.zalloc = Z_NULL;
+			strm.zfree = Z_NULL;
+			strm.opaque = Z_NULL;
+			strm.next_in = (Bytef *)raw;
+			strm.avail_in = (uInt)job->disksize;
+			strm.next_out = data;
+			strm.avail_out = (uInt)job->size;
+
+			if (inflateInit2(&strm, -15) != Z_OK)
+				break;
+			zErr = inflate(&strm, Z_FINISH);
+			ok = (zErr == Z_STREAM_END || strm.avail_out == 0);
+			inflateEnd(&strm);
+		}
+		break;
+#endif
+	default: // leave it to the main thread to complain about
+		break;
+	}
+
+done:
+	if (handle)
+		fclose(handle);
+	free(rawbuf);
+	if (!ok)
+	{
+		free(data);
+		return NULL;
+	}
+	return data;
+}
+
+static prefetch_t *W_NextPrefetchJob(void)
+{
+	prefetch_t *job = NULL;
+	INT32 i;
+
+	for (i = 0; i < MAXPREFETCH; i++)
+		if (prefetches[i].state == PF_QUEUED
+		&& (!job || (INT32)(prefetches[i].order - job->order) < 0))
+			job = &prefetches[i];
+	return job;
+}
+
+static void W_PrefetchWorker(void *userdata)
+{
+	prefetch_t *job;
+	UINT8 *data;
+
+	(void)userdata;
+
+	I_LockMutex(prefetchmutex);
+	for (;;)
+	{
+		while (!prefetchquit && !(job = W_NextPrefetchJob()))
+			I_HoldCond(prefetchwork, prefetchmutex);
+		if (prefetchquit)
+			break;
+
+		// Nobody else touches a busy job, so it can be read unlocked.
+		job->state = PF_BUSY;
+		I_UnlockMutex(prefetchmutex);
+		data = W_LoadPrefetch(job);
+		I_LockMutex(prefetchmutex);
+
+		job->data = data;
+		job->state = data ? PF_DONE : PF_FAILED;
+		I_WakeAllCond(prefetchdone);
+	}
+	prefetchworkers--;
+	I_WakeAllCond(prefetchdone); // W_StopPrefetch waits for the last one
+	I_UnlockMutex(prefetchmutex);
+}
+
+static boolean W_StartPrefetchWorkers(void)
+{
+	if (prefetchmutex)
+		return (prefetchworkers > 0);
+
+	prefetchmutex = I_CreateMutex();
+	prefetchwork = I_CreateCond();
+	prefetchdone = I_CreateCond();
+	prefetchquit = false;
+
+	I_LockMutex(prefetchmutex);
+	while (prefetchworkers < PREFETCHWORKERS
+	&& I_SpawnThread("Lump prefetch", W_PrefetchWorker, NULL))
+		prefetchworkers++;
+	I_UnlockMutex(prefetchmutex);
+
+	if (!prefetchworkers)
+		CONS_Alert(CONS_WARNING, "Couldn't start lump prefetch threads\n");
+	return (prefetchworkers > 0);
+}
+
+// Must be called with prefetchmutex locked, and the job not busy.
+static void W_FreePrefetch(prefetch_t *job)
+{
+	free(job->data);
+	job->data = NULL;
+	prefetchbytes -= job->size;
+	job->state = PF_FREE;
+	numprefetches--;
+}
+
+static prefetch_t *W_FindPrefetch(UINT16 wad, UINT16 lump)
+{
+	INT32 i;
+
+	for (i = 0; i < MAXPREFETCH; i++)
+		if (prefetches[i].state != PF_FREE && prefetches[i].wad == wad && prefetches[i].lump == lump)
+			return &prefetches[i];
+	return NULL;
+}
+
+// Copies part of a prefetched lump to dest, waiting for it if a worker is
+// still on it. Returns false if the lump has to be read normally.
+static boolean W_ReadPrefetch(UINT16 wad, UINT16 lump, void *dest, size_t size, size_t offset)
+{
+	prefetch_t *job;
+	boolean ok;
+
+	I_LockMutex(prefetchmutex);
+	job = W_FindPrefetch(wad, lump);
+	if (!job)
+	{
+		I_UnlockMutex(prefetchmutex);
+		return false;
+	}
+
+	if (job->state == PF_QUEUED) // not started yet, reading it here is just as quick
+	{
+		W_FreePrefetch(job);
+		I_UnlockMutex(prefetchmutex);
+		return false;
+	}
+
+	while (job->state == PF_BUSY)
+		I_HoldCond(prefetchdone, prefetchmutex);
+
+	ok = (job->state == PF_DONE);
+	if (ok)
+		M_Memcpy(dest, job->data + offset, size);
+
+	// Done with it once its end is read (or it couldn't be read at all).
+	if (!ok || offset + size >= job->size)
+		W_FreePrefetch(job);
+	I_UnlockMutex(prefetchmutex);
+	return ok;
+}
+
+static void W_StopPrefetch(void)
+{
+	if (!prefetchmutex)
+		return;
+
+	W_FlushPrefetches();
+	I_LockMutex(prefetchmutex);
+	prefetchquit = true;
+	I_WakeAllCond(prefetchwork);
+	while (prefetchworkers > 0)
+		I_HoldCond(prefetchdone, prefetchmutex);
+	I_UnlockMutex(prefetchmutex);
+
+	// so W_StartPrefetchWorkers can start over
+	I_DestroyCond(prefetchwork);
+	I_DestroyCond(prefetchdone);
+	I_DestroyMutex(prefetchmutex);
+	prefetchmutex = NULL;
+	prefetchwork = prefetchdone = NULL;
+}
+
+#endif // HAVE_THREADS
+
+/** Queues a lump to be read ahead of time by the prefetch threads.
+  * Later reads of the lump are served from what they read.
+  * Does nothing for lumps that are already cached one way or another, or if
+  * there's no room left for them; they're then just read as usual.
+  *
+  * \param wad Wad number of the lump.
+  * \param lump Lump number of the lump.
+  * \sa W_FlushPrefetches
+  */
+void W_PrefetchLumpNumPwad(UINT16 wad, UINT16 lump)
+{
+	lumpinfo_t *l;
+#ifdef HAVE_THREADS
+	prefetch_t *job;
+	lumpdecomp_t *entry;
+	INT32 i;
+#endif
+
+	if (!TestValidLump(wad, lump))
+		return;
+
+	l = wadfiles[wad]->lumpinfo + lump;
+	if (!l->size || wadfiles[wad]->lumpcache[lump])
+		return;
+
+	if (wadfiles[wad]->mapping
+	&& l->position + (l->compression == CM_NOCOMPRESSION ? l->size : l->disksize) > wadfiles[wad]->filesize)
+		return; // broken, W_ReadLumpHeaderPwad will complain
+
+#ifdef HAVE_MMAP
+	if (wadfiles[wad]->mapping && l->compression == CM_NOCOMPRESSION)
+	{
+		// madvise wants a page aligned address.
+		size_t pagemask = (size_t)sysconf(_SC_PAGESIZE) - 1;
+		size_t start = l->position & ~pagemask;
+		madvise(wadfiles[wad]->mapping + start, l->position + l->size - start, MADV_WILLNEED);
+		return;
+	}
+#endif
+
+#ifdef HAVE_THREADS
+	entry = W_FindDecomp(wad, lump);
+	if (entry && entry->length >= l->size)
+		return;
+
+	if (numprefetches >= MAXPREFETCH || l->size > PREFETCHBUDGET/4 || !W_StartPrefetchWorkers())
+		return;
+
+	I_LockMutex(prefetchmutex);
+	if (prefetchbytes + l->size > PREFETCHBUDGET || W_FindPrefetch(wad, lump))
+	{
+		I_UnlockMutex(prefetchmutex);
+		return;
+	}
+
+	for (i = 0; prefetches[i].state != PF_FREE; i++)
+		;
+	job = &prefetches[i];
+	job->wad = wad;
+	job->lump = lump;
+	job->filename = wadfiles[wad]->filename;
+	job->mapping = wadfiles[wad]->mapping;
+	job->position = l->position;
+	job->disksize = l->disksize;
+	job->size = l->size;
+	job->compression = l->compression;
+	job->data = NULL;
+	job->order = prefetchorder++;
+	job->state = PF_QUEUED;
+	prefetchbytes += l->size;
+	numprefetches++;
+
+	I_WakeOneCond(prefetchwork);
+	I_UnlockMutex(prefetchmutex);
+#endif
+}
+
+void W_PrefetchLumpNum(lumpnum_t lumpnum)
+{
+	W_PrefetchLumpNumPwad(WADFILENUM(lumpnum), LUMPNUM(lumpnum));
+}
+
+/** Drops every prefetched lump that wasn't read yet, waiting for the ones
+  * the prefetch threads are still busy with.
+  */
+void W_FlushPrefetches(void)
+{
+#ifdef HAVE_THREADS
+	INT32 i;
+
+	if (!numprefetches)
+		return;
+
+	I_LockMutex(prefetchmutex);
+	for (i = 0; i < MAXPREFETCH; i++)
+	{
+		while (prefetches[i].state == PF_BUSY)
+			I_HoldCond(prefetchdone, prefetchmutex);
+		if (prefetches[i].state != PF_FREE)
+			W_FreePrefetch(&prefetches[i]);
+	}
+	I_UnlockMutex(prefetchmutex);
+#endif
+}
+
+/** Reads bytes from the head of a lump.
+  * Note: Compressed lumps are decoded from their start, and what was decoded
+  * is kept in the decompressed lump cache for the next reads.
+  *
+  * \param wad Wad number to read from.
+  * \param lump Lump number to read from.
+  * \param dest Buffer in memory to serve as destination.
+  * \param size Number of bytes to read.
+  * \param offest Number of bytes to offset.
+  * \return Number of bytes read (should equal size).
+  * \sa W_ReadLump, W_RawReadLumpHeader
+  */
+size_t W_ReadLumpHeaderPwad(UINT16 wad, UINT16 lump, void *dest, size_t size, size_t offset)
+{
+	size_t lumpsize;
+	lumpinfo_t *l;
+	FILE *handle;
+	const UINT8 *mapping;
+
+	if (!TestValidLump(wad,lump))
+		return 0;
+
+	lumpsize = wadfiles[wad]->lumpinfo[lump].size;
+	// empty resource (usually markers like S_START, F_END ..)
+	if (!lumpsize || lumpsize<offset)
+		return 0;
+
+	// zero size means read all the lump
+	if (!size || size+offset > lumpsize)
+		size = lumpsize - offset;
+
+#ifdef HAVE_THREADS
+	// Already read by a prefetch thread?
+	if (numprefetches && W_ReadPrefetch(wad, lump, dest, size, offset))
+	{
+#ifdef NO_PNG_LUMPS
+		ErrorIfPNG(dest, size, wadfiles[wad]->filename, wadfiles[wad]->lumpinfo[lump].name2);
+#endif
+		return size;
+	}
+#endif
+
+	// Let's get the raw lump data.
+	// We setup the desired file handle to read the lump data.
+	l = wadfiles[wad]->lumpinfo + lump;
+	handle = wadfiles[wad]->handle;
+	mapping = wadfiles[wad]->mapping;
+	if (mapping) // Memory-mapped files are read straight from memory instead.
+	{
+		if (l->position + (l->compression == CM_NOCOMPRESSION ? offset : l->disksize) > wadfiles[wad]->filesize)
+			I_Error("wad %d, lump %d: lump data past the end of the file", wad, lump);
+		mapping += l->position;
+	}
+
+	// But let's not copy it yet. We support different compression formats on lumps, so we need to take that into account.
+	switch(wadfiles[wad]->lumpinfo[lump].compression)
+	{
+	case CM_NOCOMPRESSION:		// If it's uncompressed, we directly write the data into our destination, and return the bytes read.
+		{
+			size_t bytesread;
+			if (mapping)
+			{
+				bytesread = min(size, wadfiles[wad]->filesize - l->position - offset);
+				M_Memcpy(dest, mapping + offset, bytesread);
+			}
+			else
+			{
+				fseek(handle, (long)(l->position + offset), SEEK_SET);
+				bytesread = fread(dest, 1, size, handle);
+			}
+#ifdef NO_PNG_LUMPS
+			ErrorIfPNG(dest, bytesread, wadfiles[wad]->filename, l->name2);
+#endif
+			return bytesread;
+		}
+	case CM_LZF:
+#ifdef HAVE_ZLIB
+	case CM_DEFLATE:
+#endif
+		size = W_ReadCompressedLump(wad, lump, mapping, dest, size, offset);
+#ifdef NO_PNG_LUMPS
+		ErrorIfPNG(dest, size, wadfiles[wad]->filename, l->name2);
+#endif
+		return size;
 	default:
 		I_Error("wad %d, lump %d: unsupported compression type!", wad, lump);
 	}
@@ -1485,6 +2464,63 @@ void *W_CacheLumpNumForce(lumpnum_t lumpnum, INT32 tag)
 	return ptr;
 }
 
+/** Gets a lump's data for reading only.
+  * Uncompressed lumps of memory-mapped files are returned as a pointer into
+  * the mapping, with no copy or zone allocation at all. Anything else is
+  * cached just like W_CacheLumpNumPwad would.
+  *
+  * \param wad Wad number to read from.
+  * \param lump Lump number to read from.
+  * \param tag Zone tag to use if the lump needs to be cached.
+  * \return The lump data, to give back with W_ReleaseLumpDataPwad.
+  * \sa W_CacheLumpNumPwad
+  */
+const void *W_GetLumpDataPwad(UINT16 wad, UINT16 lump, INT32 tag)
+{
+	lumpinfo_t *l;
+
+	if (!TestValidLump(wad, lump))
+		return NULL;
+
+	l = wadfiles[wad]->lumpinfo + lump;
+	if (wadfiles[wad]->mapping && l->compression == CM_NOCOMPRESSION
+		&& l->position + l->size <= wadfiles[wad]->filesize)
+	{
+		const UINT8 *data = wadfiles[wad]->mapping + l->position;
+#ifdef NO_PNG_LUMPS
+		ErrorIfPNG(data, l->size, wadfiles[wad]->filename, l->name2);
+#endif
+		return data;
+	}
+
+	return W_CacheLumpNumPwad(wad, lump, tag);
+}
+
+const void *W_GetLumpData(lumpnum_t lumpnum, INT32 tag)
+{
+	return W_GetLumpDataPwad(WADFILENUM(lumpnum), LUMPNUM(lumpnum), tag);
+}
+
+// Gives back data from W_GetLumpDataPwad.
+void W_ReleaseLumpDataPwad(UINT16 wad, UINT16 lump, const void *data)
+{
+	const UINT8 *mapping;
+
+	if (!data || !TestValidLump(wad, lump))
+		return;
+
+	mapping = wadfiles[wad]->mapping;
+	if (mapping && (const UINT8 *)data >= mapping && (const UINT8 *)data < mapping + wadfiles[wad]->filesize)
+		return; // nothing to free, it's the file itself
+
+	Z_Free((void *)data);
+}
+
+void W_ReleaseLumpData(lumpnum_t lumpnum, const void *data)
+{
+	W_ReleaseLumpDataPwad(WADFILENUM(lumpnum), LUMPNUM(lumpnum), data);
+}
+
 //
 // W_IsLumpCached
 //
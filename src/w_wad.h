@@ -14,6 +14,8 @@
 #ifndef __W_WAD__
 #define __W_WAD__
 
+#include "command.h" // consvar_t
+
 #ifdef HWRENDER
 #include "hardware/hw_data.h"
 #endif
@@ -106,8 +108,16 @@ typedef struct wadfile_s
 #ifdef HWRENDER
 	aatree_t *hwrcache; // patches are cached in renderer's native format
 #endif
+	UINT16 *lumphash; // first lump of each lump name hash chain
+	UINT16 *lumpchain; // next lump with the same name hash, in ascending order
+	UINT16 lumphashmask; // number of hash chains - 1
+	UINT16 *pathorder; // PK3 only: lumps sorted by full name, case insensitive
+	UINT16 *pathmintree; // lowest lump number over pathorder ranges
+	UINT16 *pathlcptree; // shortest common prefix of full names of neighbouring lumps
+	UINT32 pathtreesize; // number of leaves in the path trees
 	UINT16 numlumps; // this wad's number of resources
 	FILE *handle;
+	UINT8 *mapping; // the whole file mapped read-only in memory, or NULL (see W_GetLumpDataPwad)
 	UINT32 filesize; // for network
 	UINT8 md5sum[16];
 	boolean important;
@@ -160,6 +170,13 @@ boolean W_IsLumpFolder(UINT16 wad, UINT16 lump); // for detecting folder "lumps"
 void zerr(int ret); // zlib error checking
 #endif
 
+extern consvar_t cv_lumpdecompcache;
+
+// Start reading lumps in the background, for when it's known they'll be needed soon
+void W_PrefetchLumpNumPwad(UINT16 wad, UINT16 lump);
+void W_PrefetchLumpNum(lumpnum_t lump);
+void W_FlushPrefetches(void);
+
 size_t W_ReadLumpHeaderPwad(UINT16 wad, UINT16 lump, void *dest, size_t size, size_t offset);
 size_t W_ReadLumpHeader(lumpnum_t lump, void *dest, size_t size, size_t offest); // read all or a part of a lump
 void W_ReadLumpPwad(UINT16 wad, UINT16 lump, void *dest);
@@ -171,6 +188,13 @@ void *W_CacheLumpNumForce(lumpnum_t lumpnum, INT32 tag);
 
 boolean W_IsLumpCached(lumpnum_t lump, void *ptr);
 
+// Read-only access to a lump, straight from the file mapping when possible.
+// Give the data back with W_ReleaseLumpData, never Z_Free it.
+const void *W_GetLumpDataPwad(UINT16 wad, UINT16 lump, INT32 tag);
+const void *W_GetLumpData(lumpnum_t lump, INT32 tag);
+void W_ReleaseLumpDataPwad(UINT16 wad, UINT16 lump, const void *data);
+void W_ReleaseLumpData(lumpnum_t lump, const void *data);
+
 void *W_CacheLumpName(const char *name, INT32 tag);
 void *W_CachePatchName(const char *name, INT32 tag);
 
@@ -24,6 +24,11 @@
 ///        caught with this direct-malloc version. We also suspected that SRB2's
 ///        allocator was fragmenting badly. Finally, this version is a bit
 ///        simpler (about half the lines of code).
+///
+///        The block header now shares the allocation with the data it
+///        describes, and small blocks are carved out of slabs of same-sized
+///        slots instead of getting a malloc() each. Blocks are kept in one
+///        list per tag, so freeing a tag doesn't walk every other block too.
 
 #include "doomdef.h"
 #include "doomstat.h"
@@ -61,15 +66,13 @@ typedef struct
 	UINT32 id; // Should be ZONEID
 } ATTRPACK memhdr_t;
 
-// Some code might want aligned memory. Assume it wants memory n bytes
-// aligned -- then we allocate n-1 extra bytes and return a pointer to
-// the first byte aligned as requested.
-// Thus, "real" is the pointer we get from malloc() and will free()
-// later, but "hdr" is where the memhdr_t starts.
-// For non-aligned allocations they will be the same.
+// The memblock_t sits at the very start of the allocation, and the
+// memhdr_t right before the memory given out, which is ZONEALIGN aligned.
+// Some code might want memory aligned further. Assume it wants memory n
+// bytes aligned -- then we allocate n-ZONEALIGN extra bytes and give out
+// the first address past the headers aligned as requested.
 typedef struct memblock_s
 {
-	void *real;
 	memhdr_t *hdr;
 
 	void **user;
@@ -78,6 +81,11 @@ typedef struct memblock_s
 	size_t size; // including the header and blocks
 	size_t realsize; // size of real data only
 
+	struct zslab_s *slab; // slab the block was carved from, NULL if malloc'd
+#ifdef ZPROFILE
+	struct zcallsite_s *site; // where it was allocated
+#endif
+
 #ifdef ZDEBUG
 	const char *ownerfile;
 	INT32 ownerline;
@@ -135,8 +143,477 @@ static memblock_t *Ptr2Memblock(void *ptr, const char* func)
 
 }
 
-static memblock_t head;
+#define ZONEALIGN 8 // malloc() and the slab slots are at least this aligned
+#define ZONEHDRSIZE ((sizeof (memblock_t) + sizeof (memhdr_t) + ZONEALIGN-1) & ~(size_t)(ZONEALIGN-1))
+
+// Blocks are linked into the list of their tag, tags past the
+// end of the table all share the last list.
+#define NUMZONETAGS 128
+
+static memblock_t tagheads[NUMZONETAGS + 1];
+
+static inline memblock_t *Z_TagHead(INT32 tag)
+{
+	return &tagheads[(tag >= 0 && tag < NUMZONETAGS) ? tag : NUMZONETAGS];
+}
+
+static inline void Z_LinkBlock(memblock_t *block)
+{
+	memblock_t *head = Z_TagHead(block->tag);
+
+	block->next = head->next;
+	block->prev = head;
+	head->next = block;
+	block->next->prev = block;
+}
+
+static inline void Z_UnlinkBlock(memblock_t *block)
+{
+	block->prev->next = block->next;
+	block->next->prev = block->prev;
+}
+
+// Whether the list of tagheads[i] may hold blocks tagged lowtag to hightag.
+#define TAGLISTINRANGE(i, lowtag, hightag) ((i) == NUMZONETAGS || ((i) >= (lowtag) && (i) <= (hightag)))
+
+// ==========================================================================
+//                                                                     SLABS
+// ==========================================================================
+
+// Blocks up to MAXSLABBLOCK bytes (headers included) share slabs with other
+// blocks of the same size class, so spawning and removing small things like
+// mobjs doesn't go through malloc() and free() each time. Slabs with free
+// slots are kept in a list per class; a slab is given back to the system
+// once it's empty, unless it's the last of its class.
+// Valgrind builds give every block its own malloc(), so it keeps catching
+// overruns into neighbouring blocks.
+
+#ifndef HAVE_VALGRIND
+#define ZONESLABS
+#endif
+
+#ifdef ZONESLABS
+
+#ifdef _NDS
+#define SLABSIZE (16<<10)
+#else
+#define SLABSIZE (64<<10)
+#endif
+#define MAXSLABBLOCK 1024
+
+typedef struct zslot_s
+{
+	struct zslot_s *next;
+} zslot_t;
+
+typedef struct zslab_s
+{
+	struct zslab_s *next, *prev; // slabs of the class with free slots
+	struct zslabclass_s *cls;
+	zslot_t *freeslots;
+	UINT8 *unused; // slots from here on were never handed out
+	UINT32 used;
+} zslab_t;
+
+#define SLABHDRSIZE ((sizeof (zslab_t) + ZONEALIGN-1) & ~(size_t)(ZONEALIGN-1))
+
+typedef struct zslabclass_s
+{
+	size_t slotsize;
+	UINT32 slotsperslab;
+	zslab_t *partial; // slabs with free slots
+	UINT32 numslabs;
+	UINT32 usedslots;
+} zslabclass_t;
+
+static const UINT16 slabclasssizes[] = {
+	48, 64, 80, 96, 112, 128, 160, 192, 224, 256,
+	320, 384, 448, 512, 640, 768, 896, MAXSLABBLOCK
+};
+#define NUMSLABCLASSES (sizeof slabclasssizes / sizeof *slabclasssizes)
+
+static zslabclass_t slabclasses[NUMSLABCLASSES];
+static UINT8 slabclassfor[MAXSLABBLOCK/ZONEALIGN + 1]; // in ZONEALIGN units, rounded up
+
+static void Z_InitSlabs(void)
+{
+	size_t i, c = 0;
+
+	for (i = 0; i < NUMSLABCLASSES; i++)
+	{
+		slabclasses[i].slotsize = slabclasssizes[i];
+		slabclasses[i].slotsperslab = (UINT32)((SLABSIZE - SLABHDRSIZE) / slabclasssizes[i]);
+	}
+	for (i = 0; i <= MAXSLABBLOCK/ZONEALIGN; i++)
+	{
+		while (slabclasssizes[c] < i*ZONEALIGN)
+			c++;
+		slabclassfor[i] = (UINT8)c;
+	}
+}
+
+static void Z_LinkSlab(zslab_t *slab)
+{
+	zslabclass_t *cls = slab->cls;
+
+	slab->prev = NULL;
+	slab->next = cls->partial;
+	if (cls->partial)
+		cls->partial->prev = slab;
+	cls->partial = slab;
+}
+
+static void Z_UnlinkSlab(zslab_t *slab)
+{
+	if (slab->prev)
+		slab->prev->next = slab->next;
+	else
+		slab->cls->partial = slab->next;
+	if (slab->next)
+		slab->next->prev = slab->prev;
+}
+
+static void *xm(size_t size);
+
+static void *Z_SlabAlloc(size_t size, zslab_t **slabp)
+{
+	zslabclass_t *cls = &slabclasses[slabclassfor[(size + ZONEALIGN-1)/ZONEALIGN]];
+	zslab_t *slab = cls->partial;
+	void *slot;
+
+	if (!slab)
+	{
+		slab = xm(SLABSIZE);
+		slab->cls = cls;
+		slab->freeslots = NULL;
+		slab->unused = (UINT8 *)slab + SLABHDRSIZE;
+		slab->used = 0;
+		Z_LinkSlab(slab);
+		cls->numslabs++;
+	}
+
+	if (slab->freeslots)
+	{
+		slot = slab->freeslots;
+		slab->freeslots = slab->freeslots->next;
+	}
+	else
+	{
+		slot = slab->unused;
+		slab->unused += cls->slotsize;
+	}
+
+	cls->usedslots++;
+	if (++slab->used == cls->slotsperslab) // no free slots left
+		Z_UnlinkSlab(slab);
+
+	*slabp = slab;
+	return slot;
+}
+
+static void Z_SlabFree(zslab_t *slab, void *ptr)
+{
+	zslabclass_t *cls = slab->cls;
+	zslot_t *slot = ptr;
+
+	cls->usedslots--;
+	if (slab->used-- == cls->slotsperslab) // was full
+		Z_LinkSlab(slab);
+
+	if (!slab->used && cls->numslabs > 1)
+	{
+		Z_UnlinkSlab(slab);
+		free(slab);
+		cls->numslabs--;
+		return;
+	}
+
+	slot->next = slab->freeslots;
+	slab->freeslots = slot;
+}
+
+#endif // ZONESLABS
+
+// ==========================================================================
+//                                                                     POOLS
+// ==========================================================================
+
+// A pool hands out blocks of one size from big chunks, and keeps the freed
+// ones in a freelist for the next allocation. The chunks are zone blocks
+// with the pool's tag, so freeing that tag frees the whole pool at once.
+// Pooled blocks have a memhdr_t of their own, pointing at the pool instead
+// of a memblock_t, which is how Z_Free tells them apart. They're aligned to
+// POOLALIGN, so an object doesn't straddle more cache lines than it must.
+// Valgrind builds Z_Calloc every block instead.
+
+#ifdef _NDS
+#define POOLALIGNBITS 5 // ARM11 cache lines are 32 bytes
+#define POOLCHUNKSIZE (16<<10)
+#else
+#define POOLALIGNBITS 6
+#define POOLCHUNKSIZE (64<<10)
+#endif
+#define POOLALIGN (1<<POOLALIGNBITS)
+
+#define POOLID     0x9f0c0571 // memhdr_t id of a pooled block in use
+#define POOLFREEID 0x9f0c05f3 // and of one in the freelist
+
+struct zpool_s
+{
+	const char *name;
+	size_t size; // of a block, as asked for
+	size_t stride; // from a block to the next, its memhdr_t included
+	size_t perchunk;
+	INT32 tag;
+
+	UINT8 *chunks; // linked through their first bytes
+	void *freelist; // linked through their first bytes
+	size_t used, capacity; // in blocks
+
+	struct zpool_s *next;
+};
+
+static zpool_t *pools = NULL;
+
+/** Creates a pool for blocks of the same size.
+  * \param name Shown by memfree.
+  * \param size Size of every block.
+  * \param tag Tag of the pool's memory. Freeing it frees every block.
+  * \return The new pool, to allocate from with Z_PoolCalloc.
+  */
+zpool_t *Z_CreatePool(const char *name, size_t size, INT32 tag)
+{
+	zpool_t *pool;
+
+	if (tag >= PU_PURGELEVEL)
+		I_Error("Z_CreatePool: pool %s can't be purgable", name);
+
+	pool = calloc(1, sizeof *pool);
+	if (!pool)
+		I_Error("Z_CreatePool: out of memory");
+
+	pool->name = name;
+	pool->size = size;
+	pool->stride = (size + sizeof (memhdr_t) + POOLALIGN-1) & ~(size_t)(POOLALIGN-1);
+	pool->perchunk = (POOLCHUNKSIZE - POOLALIGN) / pool->stride;
+	if (!pool->perchunk)
+		pool->perchunk = 1;
+	pool->tag = tag;
+
+	pool->next = pools;
+	pools = pool;
+	return pool;
+}
+
+static inline memhdr_t *Z_PoolHdr(void *ptr)
+{
+	return (memhdr_t *)((UINT8 *)ptr - sizeof (memhdr_t));
+}
+
+#ifndef HAVE_VALGRIND
+static void Z_GrowPool(zpool_t *pool)
+{
+	UINT8 *chunk = Z_MallocAlign(POOLALIGN + pool->perchunk * pool->stride, pool->tag, NULL, POOLALIGNBITS);
+	size_t i;
+
+	*(UINT8 **)chunk = pool->chunks;
+	pool->chunks = chunk;
+
+	// Hand the blocks out from the start of the chunk.
+	for (i = pool->perchunk; i--;)
+	{
+		UINT8 *ptr = chunk + POOLALIGN + i*pool->stride;
+		memhdr_t *hdr = Z_PoolHdr(ptr);
+
+		hdr->block = (memblock_t *)(void *)pool;
+		hdr->id = POOLFREEID;
+		*(void **)ptr = pool->freelist;
+		pool->freelist = ptr;
+	}
+	pool->capacity += pool->perchunk;
+}
+#endif
+
+/** Allocates a zeroed block from a pool. Free it with Z_Free.
+  * \param pool Pool made by Z_CreatePool.
+  * \return The block.
+  */
+void *Z_PoolCalloc(zpool_t *pool)
+{
+#ifdef HAVE_VALGRIND
+	return Z_Calloc(pool->size, pool->tag, NULL);
+#else
+	void *ptr;
+
+	if (!pool->freelist)
+		Z_GrowPool(pool);
+
+	ptr = pool->freelist;
+	pool->freelist = *(void **)ptr;
+	Z_PoolHdr(ptr)->id = POOLID;
+	pool->used++;
+	return memset(ptr, 0, pool->size);
+#endif
+}
+
+#ifndef HAVE_VALGRIND
+static void Z_PoolFree(void *ptr)
+{
+	memhdr_t *hdr = Z_PoolHdr(ptr);
+	zpool_t *pool = (zpool_t *)(void *)hdr->block;
+
+#ifdef HAVE_BLUA
+	LUA_InvalidateUserdata(ptr);
+#endif
+
+	hdr->id = POOLFREEID;
+	*(void **)ptr = pool->freelist;
+	pool->freelist = ptr;
+	pool->used--;
+}
+#endif
+
+// Forgets the chunks of the pools tagged lowtag to hightag,
+// right before Z_FreeTags frees them.
+static void Z_ResetPools(INT32 lowtag, INT32 hightag)
+{
+	zpool_t *pool;
+	UINT8 *chunk;
+	size_t i;
+
+	for (pool = pools; pool; pool = pool->next)
+	{
+		if (pool->tag < lowtag || pool->tag > hightag)
+			continue;
+
+#ifdef HAVE_BLUA
+		// Lua could still have the blocks in use.
+		for (chunk = pool->chunks; chunk; chunk = *(UINT8 **)chunk)
+			for (i = 0; i < pool->perchunk; i++)
+			{
+				UINT8 *ptr = chunk + POOLALIGN + i*pool->stride;
+				if (Z_PoolHdr(ptr)->id == POOLID)
+					LUA_InvalidateUserdata(ptr);
+			}
+#else
+		(void)chunk;
+		(void)i;
+#endif
+
+		pool->chunks = NULL;
+		pool->freelist = NULL;
+		pool->used = pool->capacity = 0;
+	}
+}
+
+// ==========================================================================
+//                                                                STATISTICS
+// ==========================================================================
+
+// Live and peak bytes (as asked for, headers not included), and how many
+// blocks were allocated and freed, for each tag list. ZPROFILE builds
+// keep the same counters for every file:line that allocates zone memory.
+// The memprofile command shows them, or how they changed since a snapshot.
+
+typedef struct
+{
+	size_t live, peak;
+	UINT32 allocs, frees;
+} zstats_t;
+
+typedef struct
+{
+	zstats_t now, snap;
+} zcounter_t;
+
+static zcounter_t tagstats[NUMZONETAGS + 1];
+
+static inline zcounter_t *Z_TagStats(INT32 tag)
+{
+	return &tagstats[Z_TagHead(tag) - tagheads];
+}
+
+static inline void Z_StatsAdd(zstats_t *st, size_t size)
+{
+	st->live += size;
+	if (st->live > st->peak)
+		st->peak = st->live;
+}
+
+#ifdef ZPROFILE
+typedef struct zcallsite_s
+{
+	const char *file; // NULL for a free slot
+	INT32 line;
+	zcounter_t stats;
+} zcallsite_t;
+
+#define NUMCALLSITES 4096 // must be a power of two
+
+static zcallsite_t *callsites; // open addressing
+static UINT32 numcallsites = 0;
+static zcallsite_t othercallsites = {"(table full)", 0, {{0, 0, 0, 0}, {0, 0, 0, 0}}};
+
+static zcallsite_t *Z_FindCallsite(const char *file, INT32 line)
+{
+	UINT32 i = (((UINT32)(size_t)file >> 2) ^ ((UINT32)line * 2654435761u)) & (NUMCALLSITES-1);
+
+	// __FILE__ strings are only compared by address. If a file's name
+	// isn't pooled, its callsites just show up more than once.
+	while (callsites[i].file)
+	{
+		if (callsites[i].file == file && callsites[i].line == line)
+			return &callsites[i];
+		i = (i + 1) & (NUMCALLSITES-1);
+	}
+
+	if (numcallsites >= NUMCALLSITES - NUMCALLSITES/4)
+		return &othercallsites;
+	numcallsites++;
+	callsites[i].file = file;
+	callsites[i].line = line;
+	return &callsites[i];
+}
+#endif
+
+#ifdef ZPROFILE
+static void Z_CountAlloc(memblock_t *block, const char *file, INT32 line)
+#else
+static void Z_CountAlloc(memblock_t *block)
+#endif
+{
+	zcounter_t *c = Z_TagStats(block->tag);
 
+	Z_StatsAdd(&c->now, block->realsize);
+	c->now.allocs++;
+#ifdef ZPROFILE
+	block->site = Z_FindCallsite(file, line);
+	Z_StatsAdd(&block->site->stats.now, block->realsize);
+	block->site->stats.now.allocs++;
+#endif
+}
+
+static void Z_CountFree(memblock_t *block)
+{
+	zcounter_t *c = Z_TagStats(block->tag);
+
+	c->now.live -= block->realsize;
+	c->now.frees++;
+#ifdef ZPROFILE
+	block->site->stats.now.live -= block->realsize;
+	block->site->stats.now.frees++;
+#endif
+}
+
+// Block is about to be tagged tag. Its bytes move along, they weren't
+// allocated or freed.
+static void Z_CountRetag(memblock_t *block, INT32 tag)
+{
+	Z_TagStats(block->tag)->now.live -= block->realsize;
+	Z_StatsAdd(&Z_TagStats(tag)->now, block->realsize);
+}
+
+static void Command_Memprofile_f(void);
 static void Command_Memfree_f(void);
 #ifdef ZDEBUG
 static void Command_Memdump_f(void);
@@ -145,16 +622,29 @@ static void Command_Memdump_f(void);
 void Z_Init(void)
 {
 	UINT32 total, memfree;
+	INT32 i;
+
+	memset(tagheads, 0x00, sizeof(tagheads));
 
-	memset(&head, 0x00, sizeof(head));
+	for (i = 0; i <= NUMZONETAGS; i++)
+		tagheads[i].next = tagheads[i].prev = &tagheads[i];
 
-	head.next = head.prev = &head;
+#ifdef ZONESLABS
+	Z_InitSlabs();
+#endif
 
 	memfree = I_GetFreeMem(&total)>>20;
 	CONS_Printf("System memory: %uMB - Free: %uMB\n", total>>20, memfree);
 
+#ifdef ZPROFILE
+	callsites = calloc(NUMCALLSITES, sizeof *callsites);
+	if (!callsites)
+		I_Error("Z_Init: couldn't allocate the callsite table");
+#endif
+
 	// Note: This allocates memory. Watch out.
 	COM_AddCommand("memfree", Command_Memfree_f);
+	COM_AddCommand("memprofile", Command_Memprofile_f);
 
 #ifdef _NDS
 	//svcSleepThread(5000000000LL); // 5 seconds, to let the console print before we start doing things that might cause it to lag.
@@ -180,6 +670,14 @@ void Z_Free(void *ptr)
 	CONS_Debug(DBG_MEMORY, "Z_Free %s:%d\n", file, line);
 #endif
 
+#ifndef HAVE_VALGRIND
+	if (Z_PoolHdr(ptr)->id == POOLID)
+	{
+		Z_PoolFree(ptr);
+		return;
+	}
+#endif
+
 #ifdef ZDEBUG
 	block = Ptr2Memblock2(ptr, "Z_Free", file, line);
 #else
@@ -204,11 +702,15 @@ void Z_Free(void *ptr)
 	if (block->user != NULL)
 		*block->user = NULL;
 
-	// Free the memory and get rid of the block.
-	free(block->real);
-	block->prev->next = block->next;
-	block->next->prev = block->prev;
-	free(block);
+	// Get rid of the block, and the memory with it.
+	Z_CountFree(block);
+	Z_UnlinkBlock(block);
+#ifdef ZONESLABS
+	if (block->slab)
+		Z_SlabFree(block->slab, block);
+	else
+#endif
+		free(block);
 #ifdef VALGRIND_DESTROY_MEMPOOL
 	VALGRIND_DESTROY_MEMPOOL(block);
 #endif
@@ -251,28 +753,33 @@ void *Z_Malloc2(size_t size, INT32 tag, void *user, INT32 alignbits,
 void *Z_MallocAlign(size_t size, INT32 tag, void *user, INT32 alignbits)
 #endif
 {
-	size_t extrabytes = (1<<alignbits) - 1;
+	size_t alignmask = ((size_t)1<<alignbits) - 1;
+	size_t extrabytes = (alignmask > ZONEALIGN-1) ? alignmask - (ZONEALIGN-1) : 0;
 	size_t padsize = 0;
 	memblock_t *block;
-	void *ptr;
+	struct zslab_s *slab = NULL;
 	memhdr_t *hdr;
 	void *given;
-	size_t blocksize = extrabytes + sizeof *hdr + size;
+	size_t blocksize = ZONEHDRSIZE + extrabytes + size;
 
 #ifdef ZDEBUG2
 	CONS_Debug(DBG_MEMORY, "Z_Malloc %s:%d\n", file, line);
 #endif
 
-	block = xm(sizeof *block);
 #ifdef HAVE_VALGRIND
 	padsize += (1<<sizeof(size_t))*2;
 #endif
-	ptr = xm(blocksize + padsize*2);
+#ifdef ZONESLABS
+	if (blocksize <= MAXSLABBLOCK)
+		block = Z_SlabAlloc(blocksize, &slab);
+	else
+#endif
+		block = xm(blocksize + padsize*2);
 
 	// This horrible calculation makes sure that "given" is aligned
 	// properly.
-	given = (void *)((size_t)((UINT8 *)ptr + extrabytes + sizeof *hdr + padsize/2)
-		& ~extrabytes);
+	given = (void *)((size_t)((UINT8 *)block + ZONEHDRSIZE + extrabytes + padsize/2)
+		& ~alignmask);
 
 	// The mem header lives 'sizeof (memhdr_t)' bytes before given.
 	hdr = (memhdr_t *)((UINT8 *)given - sizeof *hdr);
@@ -285,22 +792,29 @@ void *Z_MallocAlign(size_t size, INT32 tag, void *user, INT32 alignbits)
 	VALGRIND_MEMPOOL_ALLOC(block, hdr, size + sizeof *hdr);
 #endif
 
-	block->next = head.next;
-	block->prev = &head;
-	head.next = block;
-	block->next->prev = block;
-
-	block->real = ptr;
 	block->hdr = hdr;
 	block->tag = tag;
 	block->user = NULL;
+	block->slab = slab;
 #ifdef ZDEBUG
 	block->ownerline = line;
 	block->ownerfile = file;
 #endif
-	block->size = blocksize;
+#ifdef ZONESLABS
+	if (slab)
+		block->size = slab->cls->slotsize - sizeof *block;
+	else
+#endif
+		block->size = blocksize - sizeof *block;
 	block->realsize = size;
 
+	Z_LinkBlock(block);
+#ifdef ZPROFILE
+	Z_CountAlloc(block, file, line);
+#else
+	Z_CountAlloc(block);
+#endif
+
 	hdr->id = ZONEID;
 	hdr->block = block;
 
@@ -408,26 +922,28 @@ void *Z_ReallocAlign(void *ptr, size_t size,INT32 tag, void *user,  INT32 alignb
 
 void Z_FreeTags(INT32 lowtag, INT32 hightag)
 {
-	memblock_t *block, *next;
-
-	size_t i=0;
+	memblock_t *block, *next, *head;
+	INT32 i;
 
 	//Z_CheckHeap(420);		XXX SLOW
 
-	for (block = head.next; block != &head; block = next)
+	Z_ResetPools(lowtag, hightag);
+
+	// Only the lists of the tags asked for need walking.
+	for (i = 0; i <= NUMZONETAGS; i++)
 	{
-		//printf("block %p, head: %p\n", block, &head);
-		next = block->next; // get link before freeing
+		if (!TAGLISTINRANGE(i, lowtag, hightag))
+			continue;
 
-		if (block->tag >= lowtag && block->tag <= hightag)
-			Z_Free((UINT8 *)block->hdr + sizeof *block->hdr);
+		head = &tagheads[i];
+		for (block = head->next; block != head; block = next)
+		{
+			next = block->next; // get link before freeing
 
-		i++;
+			if (block->tag >= lowtag && block->tag <= hightag)
+				Z_Free((UINT8 *)block->hdr + sizeof *block->hdr);
+		}
 	}
-
-#ifdef DIAGNOSTIC
-	//printf("Z_FreeTags: processed %li blocks\n", i);
-#endif
 }
 
 //
@@ -463,14 +979,15 @@ void Z_CheckMemCleanup(void)
   */
 void Z_CheckHeap(INT32 i)
 {
-	memblock_t *block;
+	memblock_t *block, *head;
 	memhdr_t *hdr;
 	UINT32 blocknumon = 0;
 	void *given;
+	INT32 t;
 
-	for (block = head.next; block != &head; block = block->next)
+	for (t = 0; t <= NUMZONETAGS; t++)
+	for (head = &tagheads[t], block = head->next; block != head; block = block->next)
 	{
-		//printf("block %p, head: %p\n", block, &head);
 		blocknumon++;
 		hdr = block->hdr;
 		given = (UINT8 *)hdr + sizeof *hdr;
@@ -525,6 +1042,18 @@ void Z_CheckHeap(INT32 i)
 				" lacks proper forward link", i, blocknumon
 #ifdef ZDEBUG
 				, block->ownerfile, block->ownerline
+#endif
+			       );
+		}
+		if (Z_TagHead(block->tag) != head)
+		{
+			I_Error("Z_CheckHeap %d: block %u"
+#ifdef ZDEBUG
+				"(owned by %s:%d)"
+#endif
+				" is in the wrong tag list", i, blocknumon
+#ifdef ZDEBUG
+				, block->ownerfile, block->ownerline
 #endif
 			       );
 		}
@@ -592,6 +1121,8 @@ void Z_ChangeTag2(void *ptr, INT32 tag)
 #endif
 #ifdef PARANOIA
 	if (hdr->id != ZONEID) I_Error("Z_CT at %s:%d: wrong id", file, line);
+#else
+	if (hdr->id == POOLID) I_Error("Z_CT: pooled blocks keep the tag of their pool");
 #endif
 
 	block = hdr->block;
@@ -604,7 +1135,15 @@ void Z_ChangeTag2(void *ptr, INT32 tag)
 		I_Error("Internal memory management error: "
 			"tried to make block purgable but it has no owner");
 
-	block->tag = tag;
+	if (Z_TagHead(tag) != Z_TagHead(block->tag))
+	{
+		Z_CountRetag(block, tag);
+		Z_UnlinkBlock(block);
+		block->tag = tag;
+		Z_LinkBlock(block);
+	}
+	else
+		block->tag = tag;
 }
 
 /** Calculates memory usage for a given set of tags.
@@ -617,13 +1156,21 @@ void Z_ChangeTag2(void *ptr, INT32 tag)
 size_t Z_TagsUsage(INT32 lowtag, INT32 hightag)
 {
 	size_t cnt = 0;
-	memblock_t *rover;
+	memblock_t *rover, *head;
+	INT32 i;
 
-	for (rover = head.next; rover != &head; rover = rover->next)
+	for (i = 0; i <= NUMZONETAGS; i++)
 	{
-		if (rover->tag < lowtag || rover->tag > hightag)
+		if (!TAGLISTINRANGE(i, lowtag, hightag))
 			continue;
-		cnt += rover->size + sizeof *rover;
+
+		head = &tagheads[i];
+		for (rover = head->next; rover != head; rover = rover->next)
+		{
+			if (rover->tag < lowtag || rover->tag > hightag)
+				continue;
+			cnt += rover->size + sizeof *rover;
+		}
 	}
 
 	return cnt;
@@ -649,6 +1196,24 @@ void Command_Memfree_f(void)
 	CONS_Printf(M_GetText("Special thinker   : %7s KB\n"), sizeu1(Z_TagUsage(PU_LEVSPEC)>>10));
 	CONS_Printf(M_GetText("All purgable      : %7s KB\n"),
 		sizeu1(Z_TagsUsage(PU_PURGELEVEL, INT32_MAX)>>10));
+	{
+		zpool_t *pool;
+		for (pool = pools; pool; pool = pool->next)
+			CONS_Printf(M_GetText("Pool %-13s: %7s KB (%s of %s used)\n"), pool->name,
+				sizeu1((pool->capacity * pool->stride)>>10), sizeu2(pool->used), sizeu3(pool->capacity));
+	}
+#ifdef ZONESLABS
+	{
+		size_t slabbytes = 0, slotbytes = 0, c;
+		for (c = 0; c < NUMSLABCLASSES; c++)
+		{
+			slabbytes += (size_t)slabclasses[c].numslabs * SLABSIZE;
+			slotbytes += (size_t)slabclasses[c].usedslots * slabclasses[c].slotsize;
+		}
+		CONS_Printf(M_GetText("Slabs             : %7s KB (%s KB unused)\n"),
+			sizeu1(slabbytes>>10), sizeu2((slabbytes - slotbytes)>>10));
+	}
+#endif
 
 #ifdef HWRENDER
 	if (rendermode != render_soft && rendermode != render_none)
@@ -670,7 +1235,7 @@ void Command_Memfree_f(void)
 #ifdef ZDEBUG
 static void Command_Memdump_f(void)
 {
-	memblock_t *block;
+	memblock_t *block, *head;
 	INT32 mintag = 0, maxtag = INT32_MAX;
 	INT32 i;
 
@@ -680,7 +1245,8 @@ static void Command_Memdump_f(void)
 	if ((i = COM_CheckParm("-max")))
 		maxtag = atoi(COM_Argv(i + 1));
 
-	for (block = head.next; block != &head; block = block->next)
+	for (i = 0; i <= NUMZONETAGS; i++)
+	for (head = &tagheads[i], block = head->next; block != head; block = block->next)
 		if (block->tag >= mintag && block->tag <= maxtag)
 		{
 			char *filename = strrchr(block->ownerfile, PATHSEP[0]);
@@ -689,6 +1255,208 @@ static void Command_Memdump_f(void)
 }
 #endif
 
+// memprofile [snapshot | diff] [live | peak | allocs | frees] [rows]
+enum
+{
+	ZCOL_LIVE,
+	ZCOL_PEAK,
+	ZCOL_ALLOCS,
+	ZCOL_FREES,
+	NUMZCOLS
+};
+
+static const char *const zcolnames[NUMZCOLS] = {"live", "peak", "allocs", "frees"};
+
+typedef struct
+{
+	char name[48];
+	const zcounter_t *c;
+} zprofrow_t;
+
+static INT32 profsortcol;
+static boolean profdiff, profsnapshot = false;
+
+static INT64 Z_ProfileValue(const zcounter_t *c, INT32 col, boolean diff)
+{
+	const zstats_t *now = &c->now, *snap = &c->snap;
+
+	switch (col)
+	{
+		case ZCOL_PEAK:
+			return (INT64)now->peak - (diff ? (INT64)snap->peak : 0);
+		case ZCOL_ALLOCS:
+			return (INT64)now->allocs - (diff ? (INT64)snap->allocs : 0);
+		case ZCOL_FREES:
+			return (INT64)now->frees - (diff ? (INT64)snap->frees : 0);
+		default:
+			return (INT64)now->live - (diff ? (INT64)snap->live : 0);
+	}
+}
+
+// Biggest first, or biggest change first when diffing.
+static int Z_ProfileRowCmp(const void *p1, const void *p2)
+{
+	INT64 v1 = Z_ProfileValue(((const zprofrow_t *)p1)->c, profsortcol, profdiff);
+	INT64 v2 = Z_ProfileValue(((const zprofrow_t *)p2)->c, profsortcol, profdiff);
+
+	if (profdiff)
+	{
+		if (v1 < 0) v1 = -v1;
+		if (v2 < 0) v2 = -v2;
+	}
+	return (v1 < v2) - (v1 > v2);
+}
+
+static boolean Z_ProfileRowUsed(const zcounter_t *c)
+{
+	INT32 col;
+
+	if (!profdiff)
+		return (c->now.allocs || c->now.peak);
+	for (col = 0; col < NUMZCOLS; col++)
+		if (Z_ProfileValue(c, col, true))
+			return true;
+	return false;
+}
+
+static void Z_PrintProfile(const char *title, zprofrow_t *rows, size_t numrows, size_t maxrows)
+{
+	size_t i;
+
+	qsort(rows, numrows, sizeof *rows, Z_ProfileRowCmp);
+
+	CONS_Printf("\x82%-32s %10s %10s %9s %9s\n", title, "Live", "Peak", "Allocs", "Frees");
+	for (i = 0; i < numrows && i < maxrows; i++)
+	{
+		const zcounter_t *c = rows[i].c;
+		if (profdiff)
+			CONS_Printf("%-32s %+10ld %+10ld %+9ld %+9ld\n", rows[i].name,
+				(long)Z_ProfileValue(c, ZCOL_LIVE, true), (long)Z_ProfileValue(c, ZCOL_PEAK, true),
+				(long)Z_ProfileValue(c, ZCOL_ALLOCS, true), (long)Z_ProfileValue(c, ZCOL_FREES, true));
+		else
+			CONS_Printf("%-32s %10s %10s %9u %9u\n", rows[i].name,
+				sizeu1(c->now.live), sizeu2(c->now.peak), c->now.allocs, c->now.frees);
+	}
+	if (numrows > maxrows)
+		CONS_Printf(M_GetText("(%s more)\n"), sizeu1(numrows - maxrows));
+}
+
+static const char *Z_TagName(INT32 tag)
+{
+	switch (tag)
+	{
+		case PU_STATIC:                return "PU_STATIC";
+		case PU_LUA:                   return "PU_LUA";
+		case PU_SOUND:                 return "PU_SOUND";
+		case PU_MUSIC:                 return "PU_MUSIC";
+		case PU_HUDGFX:                return "PU_HUDGFX";
+		case PU_HWRPATCHINFO:          return "PU_HWRPATCHINFO";
+		case PU_HWRPATCHCOLMIPMAP:     return "PU_HWRPATCHCOLMIPMAP";
+		case PU_HWRCACHE:              return "PU_HWRCACHE";
+		case PU_CACHE:                 return "PU_CACHE";
+		case PU_LEVEL:                 return "PU_LEVEL";
+		case PU_LEVSPEC:               return "PU_LEVSPEC";
+		case PU_HWRPLANE:              return "PU_HWRPLANE";
+		case PU_PURGELEVEL:            return "PU_PURGELEVEL";
+		case PU_CACHE_UNLOCKED:        return "PU_CACHE_UNLOCKED";
+		case PU_HWRCACHE_UNLOCKED:     return "PU_HWRCACHE_UNLOCKED";
+		case PU_HWRPATCHINFO_UNLOCKED: return "PU_HWRPATCHINFO_UNLOCKED";
+		default:                       return "";
+	}
+}
+
+static void Command_Memprofile_f(void)
+{
+	zprofrow_t *rows;
+	size_t numrows = 0, maxrows = 20, i;
+	INT32 col;
+
+	profsortcol = ZCOL_LIVE;
+	profdiff = false;
+
+	for (i = 1; i < COM_Argc(); i++)
+	{
+		const char *arg = COM_Argv(i);
+
+		if (!stricmp(arg, "snapshot"))
+		{
+			for (col = 0; col <= NUMZONETAGS; col++)
+				tagstats[col].snap = tagstats[col].now;
+#ifdef ZPROFILE
+			for (col = 0; col < NUMCALLSITES; col++)
+				callsites[col].stats.snap = callsites[col].stats.now;
+			othercallsites.stats.snap = othercallsites.stats.now;
+#endif
+			profsnapshot = true;
+			CONS_Printf(M_GetText("Zone counters saved, use \"memprofile diff\" to compare.\n"));
+			return;
+		}
+		else if (!stricmp(arg, "diff"))
+		{
+			if (!profsnapshot)
+			{
+				CONS_Printf(M_GetText("No snapshot taken yet, use \"memprofile snapshot\" first.\n"));
+				return;
+			}
+			profdiff = true;
+		}
+		else if (atoi(arg) > 0)
+			maxrows = atoi(arg);
+		else
+		{
+			for (col = 0; col < NUMZCOLS; col++)
+				if (!stricmp(arg, zcolnames[col]))
+					break;
+			if (col == NUMZCOLS)
+			{
+				CONS_Printf(M_GetText("memprofile [snapshot | diff] [live | peak | allocs | frees] [rows]: show zone memory usage by tag and by allocation site\n"));
+				return;
+			}
+			profsortcol = col;
+		}
+	}
+
+#ifdef ZPROFILE
+	rows = malloc((NUMCALLSITES + 1) * sizeof *rows);
+#else
+	rows = malloc((NUMZONETAGS + 1) * sizeof *rows);
+#endif
+	if (!rows)
+		return;
+
+	for (i = 0; i <= NUMZONETAGS; i++)
+		if (Z_ProfileRowUsed(&tagstats[i]))
+		{
+			if (i == NUMZONETAGS)
+				snprintf(rows[numrows].name, sizeof rows[numrows].name, ">=%d", NUMZONETAGS);
+			else
+				snprintf(rows[numrows].name, sizeof rows[numrows].name, "%3d %s", (INT32)i, Z_TagName((INT32)i));
+			rows[numrows++].c = &tagstats[i];
+		}
+	Z_PrintProfile(profdiff ? "Tag (change)" : "Tag", rows, numrows, NUMZONETAGS + 1);
+
+#ifdef ZPROFILE
+	numrows = 0;
+	for (i = 0; i <= NUMCALLSITES; i++)
+	{
+		zcallsite_t *site = (i == NUMCALLSITES) ? &othercallsites : &callsites[i];
+		const char *filename;
+
+		if (!site->file || !Z_ProfileRowUsed(&site->stats))
+			continue;
+		filename = strrchr(site->file, PATHSEP[0]);
+		snprintf(rows[numrows].name, sizeof rows[numrows].name, "%s:%d", filename ? filename + 1 : site->file, site->line);
+		rows[numrows++].c = &site->stats;
+	}
+	Z_PrintProfile(profdiff ? "Callsite (change)" : "Callsite", rows, numrows, maxrows);
+#else
+	(void)maxrows;
+	CONS_Printf(M_GetText("Build with ZPROFILE to see allocations by callsite.\n"));
+#endif
+
+	free(rows);
+}
+
 // Creates a copy of a string.
 char *Z_StrDup(const char *s)
 {
@@ -29,6 +29,13 @@
 
 //#define ZDEBUG
 
+// Count allocations per callsite for the memprofile command.
+// Needs the callsites ZDEBUG passes along.
+//#define ZPROFILE
+#if defined (ZPROFILE) && !defined (ZDEBUG)
+#define ZDEBUG
+#endif
+
 //
 // ZONE MEMORY
 // PU - purge tags.
@@ -96,6 +103,12 @@ void *Z_ReallocAlign(void *ptr, size_t size, INT32 tag, void *user, INT32 alignb
 #define Z_Realloc(p, s,t,u) Z_ReallocAlign(p, s, t, u, 0)
 #endif
 
+// Pools of same-sized blocks, for things that come and go all the time.
+// Their blocks are freed with Z_Free, or all at once with the pool's tag.
+typedef struct zpool_s zpool_t;
+zpool_t *Z_CreatePool(const char *name, size_t size, INT32 tag);
+void *Z_PoolCalloc(zpool_t *pool);
+
 size_t Z_TagUsage(INT32 tagnum);
 size_t Z_TagsUsage(INT32 lowtag, INT32 hightag);
 